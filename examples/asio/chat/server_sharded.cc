@@ -0,0 +1,120 @@
+#include "examples/asio/chat/codec.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThreadPool.h"
+#include "muduo/net/LoopLocal.h"
+#include "muduo/net/LoopMesh.h"
+#include "muduo/net/TcpServer.h"
+
+#include <set>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// Like server_threaded_highperformance.cc, but each io loop forwards
+// messages to the others through a LoopMesh instead of their functor
+// queues, and keeps its connections in a LoopLocal.
+class ChatServer : noncopyable
+{
+ public:
+  ChatServer(EventLoop* loop,
+             const InetAddress& listenAddr)
+  : server_(loop, listenAddr, "ChatServer"),
+    codec_(std::bind(&ChatServer::onStringMessage, this, _1, _2, _3))
+  {
+    server_.setConnectionCallback(
+        std::bind(&ChatServer::onConnection, this, _1));
+    server_.setMessageCallback(
+        std::bind(&LengthHeaderCodec::onMessage, &codec_, _1, _2, _3));
+  }
+
+  void setThreadNum(int numThreads)
+  {
+    server_.setThreadNum(numThreads);
+  }
+
+  void start()
+  {
+    server_.start();
+    // before any connection, which is accepted in the base loop
+    std::vector<EventLoop*> loops = server_.threadPool()->getAllLoops();
+    connections_.reset(new LoopLocal<ConnectionList>(loops));
+    mesh_.reset(new LoopMesh<MessagePtr>(
+        loops, kMeshCapacity, std::bind(&ChatServer::distributeMessage, this, _1, _2)));
+  }
+
+ private:
+  typedef std::set<TcpConnectionPtr> ConnectionList;
+  typedef std::shared_ptr<const string> MessagePtr;
+  static const size_t kMeshCapacity = 1024;
+
+  void onConnection(const TcpConnectionPtr& conn)
+  {
+    LOG_INFO << conn->peerAddress().toIpPort() << " -> "
+             << conn->localAddress().toIpPort() << " is "
+             << (conn->connected() ? "UP" : "DOWN");
+
+    if (conn->connected())
+    {
+      connections_->get().insert(conn);
+    }
+    else
+    {
+      connections_->get().erase(conn);
+    }
+  }
+
+  void onStringMessage(const TcpConnectionPtr&,
+                       const string& message,
+                       Timestamp)
+  {
+    MessagePtr msg(std::make_shared<const string>(message));
+    for (int to = 0; to < mesh_->size(); ++to)
+    {
+      if (!mesh_->send(to, msg))
+      {
+        // falls back to the functor queue, maybe out of order
+        mesh_->index().loop(to)->queueInLoop(
+            std::bind(&ChatServer::distributeMessage, this, -1, msg));
+      }
+    }
+  }
+
+  void distributeMessage(int, const MessagePtr& message)
+  {
+    for (const TcpConnectionPtr& conn : connections_->get())
+    {
+      codec_.send(get_pointer(conn), *message);
+    }
+  }
+
+  TcpServer server_;
+  LengthHeaderCodec codec_;
+  std::unique_ptr<LoopLocal<ConnectionList>> connections_;
+  std::unique_ptr<LoopMesh<MessagePtr>> mesh_;
+};
+
+int main(int argc, char* argv[])
+{
+  LOG_INFO << "pid = " << getpid();
+  if (argc > 1)
+  {
+    EventLoop loop;
+    uint16_t port = static_cast<uint16_t>(atoi(argv[1]));
+    InetAddress serverAddr(port);
+    ChatServer server(&loop, serverAddr);
+    if (argc > 2)
+    {
+      server.setThreadNum(atoi(argv[2]));
+    }
+    server.start();
+    loop.loop();
+  }
+  else
+  {
+    printf("Usage: %s port [thread_num]\n", argv[0]);
+  }
+}
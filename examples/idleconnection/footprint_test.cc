@@ -0,0 +1,131 @@
+// Measures memory per idle connection of TcpServer.
+//
+// Connects to itself over loopback and counts heap bytes, including
+// the malloc overhead, and RSS after all connections are accepted.
+
+#include "muduo/base/Atomic.h"
+#include "muduo/base/Logging.h"
+#include "muduo/base/ProcessInfo.h"
+#include "muduo/base/tests/HeapCounter.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/SocketsOps.h"
+#include "muduo/net/TcpServer.h"
+
+#include <stdio.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+struct Usage
+{
+  int64_t heapBytes;
+  int64_t heapBlocks;
+  int64_t rssBytes;
+
+  static Usage now()
+  {
+    Usage u;
+    u.heapBytes = g_heapBytes.load();
+    u.heapBlocks = g_heapBlocks.load();
+    ProcessInfo::Stat stat;
+    u.rssBytes = ProcessInfo::parseStat(ProcessInfo::procStat(), &stat)
+        ? stat.rss * ProcessInfo::pageSize() : 0;
+    return u;
+  }
+};
+
+EventLoop* g_loop;
+int g_connections;
+AtomicInt32 g_accepted;
+std::vector<int> g_clients;
+Usage g_before;
+
+void onConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    g_accepted.increment();
+  }
+}
+
+void report()
+{
+  Usage after = Usage::now();
+  int n = g_connections;
+  printf("connections = %d\n", n);
+  printf("heap bytes per connection = %.1f\n",
+         static_cast<double>(after.heapBytes - g_before.heapBytes) / n);
+  printf("heap blocks per connection = %.2f\n",
+         static_cast<double>(after.heapBlocks - g_before.heapBlocks) / n);
+  printf("rss bytes per connection = %.1f\n",
+         static_cast<double>(after.rssBytes - g_before.rssBytes) / n);
+  fflush(stdout);
+}
+
+void connectSome(const InetAddress& serverAddr)
+{
+  if (g_accepted.get() == g_connections)
+  {
+    report();
+    g_loop->quit();
+    return;
+  }
+  // a batch per tick, so that the accept backlog doesn't overflow
+  for (int i = 0; i < 1000 && static_cast<int>(g_clients.size()) < g_connections; ++i)
+  {
+    int sockfd = sockets::createNonblockingOrDie(AF_INET);
+    int ret = sockets::connect(sockfd, serverAddr.getSockAddr());
+    if (ret < 0 && errno != EINPROGRESS)
+    {
+      LOG_SYSFATAL << "connect";
+    }
+    g_clients.push_back(sockfd);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    printf("Usage: %s port [connections [threads]]\n", argv[0]);
+    return 0;
+  }
+  Logger::setLogLevel(Logger::WARN);
+  uint16_t port = static_cast<uint16_t>(atoi(argv[1]));
+  g_connections = argc > 2 ? atoi(argv[2]) : 10000;
+  int threads = argc > 3 ? atoi(argv[3]) : 0;
+
+  // both ends are in this process
+  struct rlimit rl;
+  ::getrlimit(RLIMIT_NOFILE, &rl);
+  rl.rlim_cur = rl.rlim_max;
+  ::setrlimit(RLIMIT_NOFILE, &rl);
+  // an eventfd, a timerfd and an epoll fd per io loop
+  int maxConnections = (ProcessInfo::maxOpenFiles() - 100 - 3 * threads) / 2;
+  if (g_connections > maxConnections)
+  {
+    printf("connections limited to %d by RLIMIT_NOFILE\n", maxConnections);
+    g_connections = maxConnections;
+  }
+  g_clients.reserve(g_connections);
+
+  printf("sizeof(TcpConnection) = %zd\nthreads = %d\n", sizeof(TcpConnection), threads);
+  EventLoop loop;
+  g_loop = &loop;
+  InetAddress serverAddr(port, true);
+  TcpServer server(&loop, serverAddr, "Footprint");
+  server.setConnectionCallback(onConnection);
+  server.setThreadNum(threads);
+  server.start();
+  g_before = Usage::now();
+
+  loop.runEvery(0.01, std::bind(connectSome, serverAddr));
+  loop.loop();
+
+  for (int sockfd : g_clients)
+  {
+    sockets::close(sockfd);
+  }
+}
@@ -5,7 +5,9 @@
 #include "muduo/base/Thread.h"
 #include "muduo/net/Channel.h"
 #include "muduo/net/EventLoop.h"
+#include "muduo/net/InetAddress.h"
 
+#include <netinet/tcp.h>
 #include <stdio.h>
 #include <sys/resource.h>
 #include <sys/socket.h>
@@ -45,6 +47,33 @@ void readCallback(Timestamp, int fd, int idx)
   }
 }
 
+// A connected pair of loopback TCP sockets, to compare with socketpair(2).
+int tcpPair(int fds[2])
+{
+  InetAddress loopback(0, true);
+  struct sockaddr_in addr = *reinterpret_cast<const struct sockaddr_in*>(loopback.getSockAddr());
+  socklen_t len = static_cast<socklen_t>(sizeof addr);
+  int listenfd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listenfd < 0
+      || ::bind(listenfd, reinterpret_cast<struct sockaddr*>(&addr), len) < 0
+      || ::listen(listenfd, 1) < 0
+      || ::getsockname(listenfd, reinterpret_cast<struct sockaddr*>(&addr), &len) < 0)
+  {
+    return -1;
+  }
+  fds[1] = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fds[1] < 0 || ::connect(fds[1], reinterpret_cast<struct sockaddr*>(&addr), len) < 0)
+  {
+    return -1;
+  }
+  fds[0] = ::accept4(listenfd, NULL, NULL, SOCK_CLOEXEC);
+  ::close(listenfd);
+  int one = 1;
+  ::setsockopt(fds[0], IPPROTO_TCP, TCP_NODELAY, &one, static_cast<socklen_t>(sizeof one));
+  ::setsockopt(fds[1], IPPROTO_TCP, TCP_NODELAY, &one, static_cast<socklen_t>(sizeof one));
+  return fds[0] < 0 ? -1 : 0;
+}
+
 std::pair<int, int> runOnce()
 {
   Timestamp beforeInit(Timestamp::now());
@@ -80,11 +109,15 @@ int main(int argc, char* argv[])
   numPipes = 100;
   numActive = 1;
   numWrites = 100;
+  bool tcp = false;
   int c;
-  while ((c = getopt(argc, argv, "n:a:w:")) != -1)
+  while ((c = getopt(argc, argv, "n:a:w:t")) != -1)
   {
     switch (c)
     {
+      case 't':
+        tcp = true;
+        break;
       case 'n':
         numPipes = atoi(optarg);
         break;
@@ -110,7 +143,9 @@ int main(int argc, char* argv[])
   g_pipes.resize(2 * numPipes);
   for (int i = 0; i < numPipes; ++i)
   {
-    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, &g_pipes[i*2]) == -1)
+    // -t for loopback TCP, Unix domain socket by default
+    int ret = tcp ? tcpPair(&g_pipes[i*2]) : ::socketpair(AF_UNIX, SOCK_STREAM, 0, &g_pipes[i*2]);
+    if (ret == -1)
     {
       perror("pipe");
       return 1;
@@ -9,6 +9,7 @@
 #include <utility>
 
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 using namespace muduo;
@@ -19,8 +20,9 @@ class Client;
 class Session : noncopyable
 {
  public:
+  template<typename Address>
   Session(EventLoop* loop,
-          const InetAddress& serverAddr,
+          const Address& serverAddr,
           const string& name,
           Client* owner)
     : client_(loop, serverAddr, name),
@@ -77,8 +79,9 @@ class Session : noncopyable
 class Client : noncopyable
 {
  public:
+  template<typename Address>
   Client(EventLoop* loop,
-         const InetAddress& serverAddr,
+         const Address& serverAddr,
          int blockSize,
          int sessionCount,
          int timeout,
@@ -189,7 +192,7 @@ int main(int argc, char* argv[])
 {
   if (argc != 7)
   {
-    fprintf(stderr, "Usage: client <host_ip> <port> <threads> <blocksize> ");
+    fprintf(stderr, "Usage: client <host_ip|unix_path> <port> <threads> <blocksize> ");
     fprintf(stderr, "<sessions> <time>\n");
   }
   else
@@ -205,9 +208,16 @@ int main(int argc, char* argv[])
     int timeout = atoi(argv[6]);
 
     EventLoop loop;
-    InetAddress serverAddr(ip, port);
-
-    Client client(&loop, serverAddr, blockSize, sessionCount, timeout, threadCount);
+    // "/path/to/socket" or "@abstract" for Unix domain socket, port is ignored
+    std::unique_ptr<Client> client;
+    if (ip[0] == '@' || strchr(ip, '/') != NULL)
+    {
+      client.reset(new Client(&loop, UnixAddress(ip), blockSize, sessionCount, timeout, threadCount));
+    }
+    else
+    {
+      client.reset(new Client(&loop, InetAddress(ip, port), blockSize, sessionCount, timeout, threadCount));
+    }
     loop.loop();
   }
 }
@@ -9,6 +9,7 @@
 #include <utility>
 
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 using namespace muduo;
@@ -31,7 +32,7 @@ int main(int argc, char* argv[])
 {
   if (argc < 4)
   {
-    fprintf(stderr, "Usage: server <address> <port> <threads>\n");
+    fprintf(stderr, "Usage: server <address|unix_path> <port> <threads>\n");
   }
   else
   {
@@ -40,12 +41,21 @@ int main(int argc, char* argv[])
 
     const char* ip = argv[1];
     uint16_t port = static_cast<uint16_t>(atoi(argv[2]));
-    InetAddress listenAddr(ip, port);
     int threadCount = atoi(argv[3]);
 
     EventLoop loop;
 
-    TcpServer server(&loop, listenAddr, "PingPong");
+    // "/path/to/socket" or "@abstract" for Unix domain socket, port is ignored
+    std::unique_ptr<TcpServer> serverPtr;
+    if (ip[0] == '@' || strchr(ip, '/') != NULL)
+    {
+      serverPtr.reset(new TcpServer(&loop, UnixAddress(ip), "PingPong"));
+    }
+    else
+    {
+      serverPtr.reset(new TcpServer(&loop, InetAddress(ip, port), "PingPong"));
+    }
+    TcpServer& server = *serverPtr;
 
     server.setConnectionCallback(onConnection);
     server.setMessageCallback(onMessage);
@@ -119,7 +119,7 @@ class Procmon : noncopyable
       LOG_INFO << "Current dir: " << cwd;
     }
     }
-    memZero(&lastStatData_, sizeof lastStatData_);
+    memZero(&lastStat_, sizeof lastStat_);
     server_.setHttpCallback(std::bind(&Procmon::onRequest, this, _1, _2));
   }
 
@@ -411,22 +411,23 @@ class Procmon : noncopyable
 
   void tick()
   {
-    string stat = readProcFile("stat");  // FIXME: catch file descriptor
-    if (stat.empty())
+    if (sampler_.size() == 0 && sampler_.add(pid_) < 0)
       return;
-    StringPiece procname = ProcessInfo::procname(stat);
-    StatData statData;
-    memZero(&statData, sizeof statData);
-    statData.parse(procname.end()+1, kbPerPage_);  // end is ')'
+    if (sampler_.sample() == 0)
+    {
+      sampler_.clear();  // reopen if the pid is reused
+      return;
+    }
+    const ProcessInfo::Stat& stat = sampler_.stat(0);
     if (ticks_ > 0)
     {
       CpuTime time;
-      time.userTime_ = std::max(0, static_cast<int>(statData.utime - lastStatData_.utime));
-      time.sysTime_ = std::max(0, static_cast<int>(statData.stime - lastStatData_.stime));
+      time.userTime_ = std::max(0, static_cast<int>(stat.utime - lastStat_.utime));
+      time.sysTime_ = std::max(0, static_cast<int>(stat.stime - lastStat_.stime));
       cpu_usage_.push_back(time);
     }
 
-    lastStatData_ = statData;
+    lastStat_ = stat;
     ++ticks_;
   }
 
@@ -492,7 +493,8 @@ class Procmon : noncopyable
   const string hostname_;
   const string cmdline_;
   int ticks_;
-  StatData lastStatData_;
+  ProcessInfo::StatSampler sampler_;
+  ProcessInfo::Stat lastStat_;
   boost::circular_buffer<CpuTime> cpu_usage_;
   Plot cpu_chart_;
   Plot ram_chart_;
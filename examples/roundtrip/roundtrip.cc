@@ -38,10 +38,11 @@ void serverMessageCallback(const TcpConnectionPtr& conn,
   }
 }
 
-void runServer(uint16_t port)
+template<typename Address>
+void runServer(const Address& listenAddr)
 {
   EventLoop loop;
-  TcpServer server(&loop, InetAddress(port), "ClockServer");
+  TcpServer server(&loop, listenAddr, "ClockServer");
   server.setConnectionCallback(serverConnectionCallback);
   server.setMessageCallback(serverMessageCallback);
   server.start();
@@ -94,10 +95,11 @@ void sendMyTime()
   }
 }
 
-void runClient(const char* ip, uint16_t port)
+template<typename Address>
+void runClient(const Address& serverAddr)
 {
   EventLoop loop;
-  TcpClient client(&loop, InetAddress(ip, port), "ClockClient");
+  TcpClient client(&loop, serverAddr, "ClockClient");
   client.enableRetry();
   client.setConnectionCallback(clientConnectionCallback);
   client.setMessageCallback(clientMessageCallback);
@@ -106,23 +108,37 @@ void runClient(const char* ip, uint16_t port)
   loop.loop();
 }
 
+// "/path/to/socket" or "@abstract"
+bool isUnixPath(const char* arg)
+{
+  return arg[0] == '@' || strchr(arg, '/') != NULL;
+}
+
 int main(int argc, char* argv[])
 {
-  if (argc > 2)
+  if (argc > 2 && strcmp(argv[1], "-s") == 0)
   {
-    uint16_t port = static_cast<uint16_t>(atoi(argv[2]));
-    if (strcmp(argv[1], "-s") == 0)
+    if (isUnixPath(argv[2]))
     {
-      runServer(port);
+      runServer(UnixAddress(argv[2]));
     }
     else
     {
-      runClient(argv[1], port);
+      runServer(InetAddress(static_cast<uint16_t>(atoi(argv[2]))));
     }
   }
+  else if (argc > 2)
+  {
+    runClient(InetAddress(argv[1], static_cast<uint16_t>(atoi(argv[2]))));
+  }
+  else if (argc > 1 && isUnixPath(argv[1]))
+  {
+    runClient(UnixAddress(argv[1]));
+  }
   else
   {
-    printf("Usage:\n%s -s port\n%s ip port\n", argv[0], argv[0]);
+    printf("Usage:\n%s -s port|unix_path\n%s ip port\n%s unix_path\n",
+           argv[0], argv[0], argv[0]);
   }
 }
 
@@ -5,6 +5,7 @@
 #include "muduo/net/SocketsOps.h"
 #include "muduo/net/TcpClient.h"
 #include "muduo/net/TcpServer.h"
+#include "muduo/net/UdpServer.h"
 
 #include <stdio.h>
 
@@ -25,49 +26,31 @@ int createNonblockingUDP()
 
 /////////////////////////////// Server ///////////////////////////////
 
-void serverReadCallback(int sockfd, muduo::Timestamp receiveTime)
+void onServerDatagram(const UdpSocketPtr& socket, const InetAddress& peer,
+                      StringPiece datagram, Timestamp receiveTime)
 {
-  int64_t message[2];
-  struct sockaddr peerAddr;
-  memZero(&peerAddr, sizeof peerAddr);
-  socklen_t addrLen = sizeof peerAddr;
-  ssize_t nr = ::recvfrom(sockfd, message, sizeof message, 0, &peerAddr, &addrLen);
-
-  char addrStr[64];
-  sockets::toIpPort(addrStr, sizeof addrStr, &peerAddr);
-  LOG_DEBUG << "received " << nr << " bytes from " << addrStr;
+  LOG_DEBUG << "received " << datagram.size() << " bytes from " << peer.toIpPort();
 
-  if (nr < 0)
-  {
-    LOG_SYSERR << "::recvfrom";
-  }
-  else if (implicit_cast<size_t>(nr) == frameLen)
+  if (implicit_cast<size_t>(datagram.size()) == frameLen)
   {
+    int64_t message[2];
+    memcpy(message, datagram.data(), frameLen);
     message[1] = receiveTime.microSecondsSinceEpoch();
-    ssize_t nw = ::sendto(sockfd, message, sizeof message, 0, &peerAddr, addrLen);
-    if (nw < 0)
-    {
-      LOG_SYSERR << "::sendto";
-    }
-    else if (implicit_cast<size_t>(nw) != frameLen)
-    {
-      LOG_ERROR << "Expect " << frameLen << " bytes, wrote " << nw << " bytes.";
-    }
+    socket->send(peer, message, sizeof message);
   }
   else
   {
-    LOG_ERROR << "Expect " << frameLen << " bytes, received " << nr << " bytes.";
+    LOG_ERROR << "Expect " << frameLen << " bytes, received " << datagram.size() << " bytes.";
   }
 }
 
-void runServer(uint16_t port)
+void runServer(uint16_t port, int numThreads)
 {
-  Socket sock(createNonblockingUDP());
-  sock.bindAddress(InetAddress(port));
   EventLoop loop;
-  Channel channel(&loop, sock.fd());
-  channel.setReadCallback(std::bind(&serverReadCallback, sock.fd(), _1));
-  channel.enableReading();
+  UdpServer server(&loop, InetAddress(port), "RoundTripUdp");
+  server.setThreadNum(numThreads);
+  server.setDatagramCallback(onServerDatagram);
+  server.start();
   loop.loop();
 }
 
@@ -136,7 +119,8 @@ int main(int argc, char* argv[])
     uint16_t port = static_cast<uint16_t>(atoi(argv[2]));
     if (strcmp(argv[1], "-s") == 0)
     {
-      runServer(port);
+      int numThreads = argc > 3 ? atoi(argv[3]) : 0;
+      runServer(port, numThreads);
     }
     else
     {
@@ -145,7 +129,7 @@ int main(int argc, char* argv[])
   }
   else
   {
-    printf("Usage:\n%s -s port\n%s ip port\n", argv[0], argv[0]);
+    printf("Usage:\n%s -s port [threads]\n%s ip port\n", argv[0], argv[0]);
   }
 }
 
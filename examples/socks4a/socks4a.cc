@@ -1,14 +1,15 @@
 #include "examples/socks4a/tunnel.h"
 
 #include "muduo/net/Endian.h"
+#include "muduo/net/Resolver.h"
 #include <stdio.h>
-#include <netdb.h>
 #include <unistd.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
 EventLoop* g_eventLoop;
+Resolver* g_resolver;
 std::map<string, TunnelPtr> g_tunnels;
 
 void onServerConnection(const TcpConnectionPtr& conn)
@@ -23,12 +24,54 @@ void onServerConnection(const TcpConnectionPtr& conn)
     std::map<string, TunnelPtr>::iterator it = g_tunnels.find(conn->name());
     if (it != g_tunnels.end())
     {
-      it->second->disconnect();
+      if (it->second)  // null while resolving
+      {
+        it->second->disconnect();
+      }
       g_tunnels.erase(it);
     }
   }
 }
 
+void reject(const TcpConnectionPtr& conn)
+{
+  char response[] = "\000\x5bUVWXYZ";
+  conn->send(response, 8);
+  conn->shutdown();
+}
+
+void startTunnel(const TcpConnectionPtr& conn, const sockaddr_in& addr)
+{
+  TunnelPtr tunnel(new Tunnel(g_eventLoop, InetAddress(addr), conn));
+  tunnel->setup();
+  tunnel->connect();
+  g_tunnels[conn->name()] = tunnel;
+  char response[] = "\000\x5aUVWXYZ";
+  memcpy(response+2, &addr.sin_port, 2);
+  memcpy(response+4, &addr.sin_addr.s_addr, 4);
+  conn->send(response, 8);
+}
+
+void onResolved(const std::weak_ptr<TcpConnection>& weakConn,
+                sockaddr_in addr,
+                const std::vector<InetAddress>& addresses)
+{
+  TcpConnectionPtr conn = weakConn.lock();
+  if (!conn || !conn->connected())
+  {
+    return;
+  }
+  if (addresses.empty())
+  {
+    reject(conn);
+  }
+  else
+  {
+    addr.sin_addr.s_addr = addresses[0].ipv4NetEndian();
+    startTunnel(conn, addr);
+  }
+}
+
 void onServerMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
 {
   LOG_DEBUG << conn->name() << " " << buf->readableBytes();
@@ -57,50 +100,28 @@ void onServerMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
         addr.sin_addr.s_addr = *static_cast<const uint32_t*>(ip);
 
         bool socks4a = sockets::networkToHost32(addr.sin_addr.s_addr) < 256;
-        bool okay = false;
-        if (socks4a)
+        if (ver != 4 || cmd != 1)
+        {
+          reject(conn);
+        }
+        else if (socks4a)
         {
           const char* endOfHostName = std::find(where+1, end, '\0');
           if (endOfHostName != end)
           {
             string hostname = where+1;
-            where = endOfHostName;
+            buf->retrieveUntil(endOfHostName+1);
             LOG_INFO << "Socks4a host name " << hostname;
-            InetAddress tmp;
-            if (InetAddress::resolve(hostname, &tmp))
-            {
-              addr.sin_addr.s_addr = tmp.ipv4NetEndian();
-              okay = true;
-            }
-          }
-          else
-          {
-            return;
+            // data from the client stays in buf until the tunnel is up
+            g_tunnels[conn->name()] = TunnelPtr();
+            g_resolver->resolve(hostname,
+                std::bind(onResolved, std::weak_ptr<TcpConnection>(conn), addr, _1));
           }
         }
         else
         {
-          okay = true;
-        }
-
-        InetAddress serverAddr(addr);
-        if (ver == 4 && cmd == 1 && okay)
-        {
-          TunnelPtr tunnel(new Tunnel(g_eventLoop, serverAddr, conn));
-          tunnel->setup();
-          tunnel->connect();
-          g_tunnels[conn->name()] = tunnel;
           buf->retrieveUntil(where+1);
-          char response[] = "\000\x5aUVWXYZ";
-          memcpy(response+2, &addr.sin_port, 2);
-          memcpy(response+4, &addr.sin_addr.s_addr, 4);
-          conn->send(response, 8);
-        }
-        else
-        {
-          char response[] = "\000\x5bUVWXYZ";
-          conn->send(response, 8);
-          conn->shutdown();
+          startTunnel(conn, addr);
         }
       }
     }
@@ -128,6 +149,8 @@ int main(int argc, char* argv[])
 
     EventLoop loop;
     g_eventLoop = &loop;
+    Resolver resolver(&loop);
+    g_resolver = &resolver;
 
     TcpServer server(&loop, listenAddr, "Socks4");
 
@@ -5,6 +5,7 @@
 #include "muduo/base/Thread.h"
 #include "muduo/base/ThreadPool.h"
 #include "muduo/net/EventLoop.h"
+#include "muduo/net/Future.h"
 #include "muduo/net/InetAddress.h"
 #include "muduo/net/TcpServer.h"
 
@@ -96,7 +97,9 @@ class SudokuServer
 
     if (puzzle.size() == implicit_cast<size_t>(kCells))
     {
-      threadPool_.run(std::bind(&solve, conn, puzzle, id));
+      // solves in the pool, and replies in the loop of conn
+      offload(&threadPool_, std::bind(&solveSudoku, puzzle))
+          .then(conn->getLoop(), std::bind(&reply, conn, id, _1));
     }
     else
     {
@@ -105,12 +108,11 @@ class SudokuServer
     return goodRequest;
   }
 
-  static void solve(const TcpConnectionPtr& conn,
-                    const string& puzzle,
-                    const string& id)
+  static void reply(const TcpConnectionPtr& conn,
+                    const string& id,
+                    const string& result)
   {
     LOG_DEBUG << conn->name();
-    string result = solveSudoku(puzzle);
     if (id.empty())
     {
       conn->send(result+"\r\n");
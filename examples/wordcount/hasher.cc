@@ -1,4 +1,5 @@
 #include "muduo/base/CountDownLatch.h"
+#include "muduo/base/FileUtil.h"
 #include "muduo/base/Logging.h"
 #include "muduo/net/EventLoopThread.h"
 #include "muduo/net/TcpClient.h"
@@ -7,9 +8,9 @@
 
 #include "examples/wordcount/hash.h"
 
-#include <fstream>
-#include <iostream>
+#include <algorithm>
 
+#include <ctype.h>
 #include <stdio.h>
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
@@ -180,24 +181,41 @@ WordCountSender::WordCountSender(const std::string& receivers)
   }
 }
 
+bool isSpace(char c)
+{
+  return ::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
 void WordCountSender::processFile(const char* filename)
 {
   LOG_INFO << "processFile " << filename;
   WordCountMap wordcounts;
-  // FIXME: use mmap to read file
-  std::ifstream in(filename);
-  string word;
+  FileUtil::MappedFile file(filename);
+  if (!file.valid())
+  {
+    LOG_SYSERR << "processFile " << filename;
+    return;
+  }
+  file.advise(FileUtil::MappedFile::kSequential);
+  FileUtil::LineIterator lines(file.range());
+  StringPiece line;
   // FIXME: make local hash optional.
   std::hash<string> hash;
-  while (in)
+  bool more = true;
+  while (more)
   {
     wordcounts.clear();
-    while (in >> word)
+    while (wordcounts.size() <= kMaxHashSize && (more = lines.next(&line)))
     {
-      wordcounts[word] += 1;
-      if (wordcounts.size() > kMaxHashSize)
+      const char* p = line.begin();
+      while (p != line.end())
       {
-        break;
+        const char* start = std::find_if_not(p, line.end(), isSpace);
+        p = std::find_if(start, line.end(), isSpace);
+        if (p != start)
+        {
+          wordcounts[string(start, p)] += 1;
+        }
       }
     }
 
@@ -20,7 +20,7 @@ AsyncLogging::AsyncLogging(const string& basename,
     rollSize_(rollSize),
     thread_(std::bind(&AsyncLogging::threadFunc, this), "Logging"),
     latch_(1),
-    mutex_(),
+    mutex_("AsyncLogging"),
     cond_(mutex_),
     currentBuffer_(new Buffer),
     nextBuffer_(new Buffer),
@@ -60,6 +60,7 @@ void AsyncLogging::threadFunc()
   assert(running_ == true);
   latch_.countDown();
   LogFile output(basename_, rollSize_, false);
+  output.setRollCallback(rollCallback_);
   BufferPtr newBuffer1(new Buffer);
   BufferPtr newBuffer2(new Buffer);
   newBuffer1->bzero();
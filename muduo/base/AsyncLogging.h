@@ -9,6 +9,7 @@
 #include "muduo/base/BlockingQueue.h"
 #include "muduo/base/BoundedBlockingQueue.h"
 #include "muduo/base/CountDownLatch.h"
+#include "muduo/base/LogFile.h"
 #include "muduo/base/Mutex.h"
 #include "muduo/base/Thread.h"
 #include "muduo/base/LogStream.h"
@@ -37,6 +38,11 @@ class AsyncLogging : noncopyable
 
   void append(const char* logline, int len);
 
+  // Must be called before start().
+  // The callback runs in the logging thread, e.g. LogCompressor::compress.
+  void setRollCallback(const LogFile::RollCallback& cb)
+  { rollCallback_ = cb; }
+
   void start()
   {
     running_ = true;
@@ -63,6 +69,7 @@ class AsyncLogging : noncopyable
   std::atomic<bool> running_;
   const string basename_;
   const off_t rollSize_;
+  LogFile::RollCallback rollCallback_;
   muduo::Thread thread_;
   muduo::CountDownLatch latch_;
   muduo::MutexLock mutex_;
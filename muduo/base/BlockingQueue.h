@@ -20,7 +20,7 @@ class BlockingQueue : noncopyable
 {
  public:
   BlockingQueue()
-    : mutex_(),
+    : mutex_("BlockingQueue"),
       notEmpty_(mutex_),
       queue_()
   {
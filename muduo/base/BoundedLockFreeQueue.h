@@ -0,0 +1,264 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_BOUNDEDLOCKFREEQUEUE_H
+#define MUDUO_BASE_BOUNDEDLOCKFREEQUEUE_H
+
+#include "muduo/base/noncopyable.h"
+
+#include <atomic>
+#include <memory>
+#include <assert.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace muduo
+{
+
+namespace detail
+{
+
+// Spinning only helps if the other side runs on another CPU.
+inline int spinLimit()
+{
+  static const int spins = ::sysconf(_SC_NPROCESSORS_ONLN) > 1 ? 256 : 0;
+  return spins;
+}
+
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+
+// Blocks while *addr == expected, spurious wakeups are possible.
+inline void futexWait(std::atomic<int>* addr, int expected)
+{
+  static_assert(sizeof(std::atomic<int>) == sizeof(int), "futex word must be an int");
+  ::syscall(SYS_futex, reinterpret_cast<int*>(addr), FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+inline void futexWake(std::atomic<int>* addr, int count)
+{
+  ::syscall(SYS_futex, reinterpret_cast<int*>(addr), FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+}  // namespace detail
+
+///
+/// Multi-producer multi-consumer bounded queue, lock free when neither
+/// empty nor full, a drop-in for BoundedBlockingQueue.
+///
+/// Each slot carries a sequence number which tells whether it is ready for
+/// the producer or the consumer of a given round, after Dmitry Vyukov's
+/// bounded MPMC queue. Blocked put() and take() spin for a while,
+/// then park on a futex.
+///
+/// T must be default constructible, capacity is rounded up to power of 2.
+///
+template<typename T>
+class BoundedLockFreeQueue : noncopyable
+{
+ public:
+  explicit BoundedLockFreeQueue(int maxSize)
+    : mask_(roundUp(maxSize) - 1),
+      cells_(new Cell[mask_ + 1]),
+      enqueuePos_(0),
+      dequeuePos_(0),
+      notEmpty_(0),
+      notFull_(0)
+  {
+    for (size_t i = 0; i <= mask_; ++i)
+    {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  void put(const T& x)
+  {
+    T copy(x);
+    put(std::move(copy));
+  }
+
+  void put(T&& x)
+  {
+    int spins = 0;
+    while (!tryPut(std::move(x)))
+    {
+      if (++spins < detail::spinLimit())
+      {
+        detail::cpuRelax();
+        continue;
+      }
+      int key = prepareWait(&notFull_);
+      if (full())
+      {
+        detail::futexWait(&notFull_, key);
+      }
+      spins = 0;
+    }
+  }
+
+  T take()
+  {
+    T x;
+    int spins = 0;
+    while (!tryTake(&x))
+    {
+      if (++spins < detail::spinLimit())
+      {
+        detail::cpuRelax();
+        continue;
+      }
+      int key = prepareWait(&notEmpty_);
+      if (empty())
+      {
+        detail::futexWait(&notEmpty_, key);
+      }
+      spins = 0;
+    }
+    return x;
+  }
+
+  // x is moved from only if it returns true
+  bool tryPut(T&& x)
+  {
+    Cell* cell = NULL;
+    size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    while (true)
+    {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0)
+      {
+        if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if (diff < 0)
+      {
+        return false;  // full
+      }
+      else
+      {
+        pos = enqueuePos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->data = std::move(x);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    wakeUp(&notEmpty_);
+    return true;
+  }
+
+  bool tryTake(T* x)
+  {
+    Cell* cell = NULL;
+    size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+    while (true)
+    {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0)
+      {
+        if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if (diff < 0)
+      {
+        return false;  // empty
+      }
+      else
+      {
+        pos = dequeuePos_.load(std::memory_order_relaxed);
+      }
+    }
+    *x = std::move(cell->data);
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    wakeUp(&notFull_);
+    return true;
+  }
+
+  // The following are approximate when used concurrently.
+
+  bool empty() const
+  {
+    size_t pos = dequeuePos_.load();
+    return cells_[pos & mask_].sequence.load() != pos + 1;
+  }
+
+  bool full() const
+  {
+    size_t pos = enqueuePos_.load();
+    return cells_[pos & mask_].sequence.load() != pos;
+  }
+
+  size_t size() const
+  {
+    size_t enq = enqueuePos_.load();
+    size_t deq = dequeuePos_.load();
+    return enq > deq ? enq - deq : 0;
+  }
+
+  size_t capacity() const
+  {
+    return mask_ + 1;
+  }
+
+ private:
+  struct Cell
+  {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  static size_t roundUp(int maxSize)
+  {
+    assert(maxSize > 0);
+    size_t n = 1;
+    while (n < static_cast<size_t>(maxSize))
+    {
+      n <<= 1;
+    }
+    return n;
+  }
+
+  // notEmpty_ and notFull_ are event counts, bit 0 tells someone is waiting,
+  // so wakeUp() makes a syscall only once per round of waiting.
+  static int prepareWait(std::atomic<int>* event)
+  {
+    return event->fetch_or(1) | 1;
+  }
+
+  static void wakeUp(std::atomic<int>* event)
+  {
+    // pairs with fetch_or() in prepareWait()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int key = event->load(std::memory_order_relaxed);
+    if ((key & 1) && event->compare_exchange_strong(key, key + 1))
+    {
+      detail::futexWake(event, INT_MAX);
+    }
+  }
+
+  static const int kCacheLine = 64;
+
+  const size_t mask_;
+  const std::unique_ptr<Cell[]> cells_;
+  char pad0_[kCacheLine] __attribute__((unused));
+  std::atomic<size_t> enqueuePos_;
+  char pad1_[kCacheLine - sizeof(std::atomic<size_t>)] __attribute__((unused));
+  std::atomic<size_t> dequeuePos_;
+  char pad2_[kCacheLine - sizeof(std::atomic<size_t>)] __attribute__((unused));
+  std::atomic<int> notEmpty_;
+  std::atomic<int> notFull_;
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_BOUNDEDLOCKFREEQUEUE_H
@@ -8,7 +8,7 @@
 using namespace muduo;
 
 CountDownLatch::CountDownLatch(int count)
-  : mutex_(),
+  : mutex_("CountDownLatch"),
     condition_(mutex_),
     count_(count)
 {
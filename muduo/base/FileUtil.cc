@@ -10,6 +10,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -169,6 +170,112 @@ int FileUtil::ReadSmallFile::readToBuffer(int* size)
   return err;
 }
 
+FileUtil::MappedFile::MappedFile(StringArg filename)
+  : err_(0),
+    data_(NULL),
+    size_(0)
+{
+  int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    err_ = errno;
+    return;
+  }
+
+  struct stat statbuf;
+  if (::fstat(fd, &statbuf) < 0)
+  {
+    err_ = errno;
+  }
+  else if (S_ISDIR(statbuf.st_mode))
+  {
+    err_ = EISDIR;
+  }
+  else if (statbuf.st_size > 0)
+  {
+    size_ = static_cast<size_t>(statbuf.st_size);
+    void* addr = ::mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+      err_ = errno;
+      size_ = 0;
+    }
+    else
+    {
+      data_ = static_cast<char*>(addr);
+    }
+  }
+  // the mapping stays valid after close
+  ::close(fd);
+}
+
+FileUtil::MappedFile::~MappedFile()
+{
+  if (data_)
+  {
+    ::munmap(data_, size_);
+  }
+}
+
+int FileUtil::MappedFile::advise(Advice advice, size_t offset, size_t len) const
+{
+  if (data_ == NULL)
+    return err_;
+
+  static const int kAdvices[] =
+  {
+    MADV_NORMAL,
+    MADV_SEQUENTIAL,
+    MADV_RANDOM,
+    MADV_WILLNEED,
+    MADV_DONTNEED,
+  };
+  assert(offset <= size_);
+  // madvise(2) needs a page aligned address
+  const size_t kPageSize = static_cast<size_t>(::sysconf(_SC_PAGE_SIZE));
+  size_t aligned = offset / kPageSize * kPageSize;
+  len = std::min(len, size_ - offset) + (offset - aligned);
+  return ::madvise(data_ + aligned, len, kAdvices[advice]) == 0 ? 0 : errno;
+}
+
+int FileUtil::MappedFile::adviseHugePage() const
+{
+  if (data_ == NULL)
+    return err_;
+#ifdef MADV_HUGEPAGE
+  return ::madvise(data_, size_, MADV_HUGEPAGE) == 0 ? 0 : errno;
+#else
+  return EINVAL;
+#endif
+}
+
+std::vector<FileUtil::MappedFile::Range> FileUtil::MappedFile::split(int n, char delim) const
+{
+  assert(n > 0);
+  std::vector<Range> ranges;
+  const char* begin = data_;
+  const char* end = data_ + size_;
+  size_t chunk = size_ / n;
+  for (int i = 1; i < n && begin != end; ++i)
+  {
+    const char* target = std::max<const char*>(begin, data_ + chunk * i);
+    const char* found = static_cast<const char*>(::memchr(target, delim, end - target));
+    const char* split = found ? found + 1 : end;
+    if (split != begin)
+    {
+      Range r = { begin, split };
+      ranges.push_back(r);
+      begin = split;
+    }
+  }
+  if (begin != end)
+  {
+    Range r = { begin, end };
+    ranges.push_back(r);
+  }
+  return ranges;
+}
+
 template int FileUtil::readFile(StringArg filename,
                                 int maxSize,
                                 string* content,
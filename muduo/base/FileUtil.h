@@ -10,6 +10,8 @@
 
 #include "muduo/base/noncopyable.h"
 #include "muduo/base/StringPiece.h"
+#include <vector>
+#include <string.h>
 #include <sys/types.h>  // for off_t
 
 namespace muduo
@@ -82,6 +84,93 @@ class AppendFile : noncopyable
   off_t writtenBytes_;
 };
 
+// read-only mapping of a whole file, for scanning files of any size
+// without copying them.
+class MappedFile : noncopyable
+{
+ public:
+  enum Advice
+  {
+    kNormal,
+    kSequential,  // read ahead aggressively, drop pages soon after read
+    kRandom,
+    kWillNeed,    // start reading in now
+    kDontNeed,
+  };
+
+  // [begin, end), may be larger than 2GB, unlike StringPiece.
+  struct Range
+  {
+    const char* begin;
+    const char* end;
+  };
+
+  explicit MappedFile(StringArg filename);
+  ~MappedFile();
+
+  // errno of open/fstat/mmap, 0 if ok.
+  int error() const { return err_; }
+  bool valid() const { return err_ == 0; }
+
+  // data() is NULL if the file is empty.
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  Range range() const { Range r = { data_, data_ + size_ }; return r; }
+
+  // return errno
+  int advise(Advice advice) const { return advise(advice, 0, size_); }
+  int advise(Advice advice, size_t offset, size_t len) const;
+  // Asks for transparent huge pages, which the kernel supports for
+  // read-only file mappings only if built with CONFIG_READ_ONLY_THP_FOR_FS.
+  int adviseHugePage() const;
+
+  // Splits into at most n ranges, each ends with delim except the last one,
+  // for scanning in parallel.
+  std::vector<Range> split(int n, char delim = '\n') const;
+
+ private:
+  int err_;
+  char* data_;
+  size_t size_;
+};
+
+// Iterates the records separated by delim in [begin, end),
+// with memchr(3) which glibc vectorizes.
+class LineIterator
+{
+ public:
+  LineIterator(const char* begin, const char* end, char delim = '\n')
+    : cur_(begin), end_(end), delim_(delim)
+  {
+  }
+
+  explicit LineIterator(MappedFile::Range range, char delim = '\n')
+    : cur_(range.begin), end_(range.end), delim_(delim)
+  {
+  }
+
+  // Sets line without the delimiter, the last one may not end with it.
+  // Returns false at the end.
+  bool next(StringPiece* line)
+  {
+    if (cur_ == end_)
+      return false;
+    const char* delim = static_cast<const char*>(::memchr(cur_, delim_, end_ - cur_));
+    const char* lineEnd = delim ? delim : end_;
+    line->set(cur_, static_cast<int>(lineEnd - cur_));
+    cur_ = delim ? delim + 1 : end_;
+    return true;
+  }
+
+  // not yet consumed
+  const char* position() const { return cur_; }
+
+ private:
+  const char* cur_;
+  const char* end_;
+  char delim_;
+};
+
 }  // namespace FileUtil
 }  // namespace muduo
 
@@ -0,0 +1,382 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/base/FlightRecorder.h"
+
+#include "muduo/base/CurrentThread.h"
+#include "muduo/base/Date.h"
+#include "muduo/base/TscClock.h"
+
+#include <atomic>
+
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using namespace muduo;
+
+namespace
+{
+
+struct Record
+{
+  int64_t ticks;  // see readTicks()
+  const char* file;
+  const char* msg;
+  int64_t args[2];
+  int line;
+  short level;
+  short numArgs;
+};
+
+const uint64_t kRingMask = FlightRecorder::kRecordsPerThread - 1;
+static_assert((FlightRecorder::kRecordsPerThread & kRingMask) == 0,
+              "kRecordsPerThread must be power of 2");
+
+// Written by its owner thread only, read by whoever dumps.
+struct Ring
+{
+  std::atomic<bool> inUse;
+  std::atomic<uint64_t> written;
+  int tid;
+  char name[32];
+  Record records[FlightRecorder::kRecordsPerThread];
+};
+
+// Rings are never freed, so they can be walked from a signal handler.
+// A ring of an exited thread is kept for dumping until reused by a new thread.
+const int kMaxRings = 4096;
+std::atomic<Ring*> g_rings[kMaxRings];
+std::atomic<int> g_numRings(0);
+std::atomic<bool> g_crashDumped(false);
+
+__thread Ring* t_ring;
+__thread bool t_noRing;
+pthread_key_t g_ringKey;
+pthread_once_t g_ringKeyOnce = PTHREAD_ONCE_INIT;
+
+// Set once before the first record.
+bool g_useTsc;
+int64_t g_baseTicks;
+int64_t g_baseMonotonic;
+
+int64_t clockMicroseconds(clockid_t clock)
+{
+  struct timespec ts;
+  ::clock_gettime(clock, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * Timestamp::kMicroSecondsPerSecond + ts.tv_nsec / 1000;
+}
+
+// Raw invariant TSC, a few cycles instead of a call into the vDSO,
+// or microseconds of CLOCK_MONOTONIC. Converted to time when dumped.
+inline int64_t readTicks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  if (g_useTsc)
+    return static_cast<int64_t>(__rdtsc());
+#endif
+  return clockMicroseconds(CLOCK_MONOTONIC);
+}
+
+void releaseRing(void* ptr)
+{
+  static_cast<Ring*>(ptr)->inUse.store(false, std::memory_order_release);
+}
+
+void createRingKey()
+{
+  pthread_key_create(&g_ringKey, &releaseRing);
+  g_useTsc = TscClock::available();
+  g_baseTicks = readTicks();
+  g_baseMonotonic = clockMicroseconds(CLOCK_MONOTONIC);
+}
+
+Ring* acquireRing()
+{
+  pthread_once(&g_ringKeyOnce, &createRingKey);
+  Ring* ring = NULL;
+  int numRings = g_numRings.load(std::memory_order_acquire);
+  for (int i = 0; i < numRings && i < kMaxRings && ring == NULL; ++i)
+  {
+    Ring* r = g_rings[i].load(std::memory_order_acquire);
+    bool inUse = false;
+    if (r && r->inUse.compare_exchange_strong(inUse, true))
+    {
+      ring = r;
+    }
+  }
+  if (ring == NULL)
+  {
+    int index = g_numRings.fetch_add(1);
+    if (index >= kMaxRings)
+    {
+      t_noRing = true;
+      return NULL;
+    }
+    ring = new Ring;
+    ring->inUse.store(true);
+    g_rings[index].store(ring, std::memory_order_release);
+  }
+  ring->written.store(0, std::memory_order_relaxed);
+  ring->tid = CurrentThread::tid();
+  strncpy(ring->name, CurrentThread::name(), sizeof ring->name - 1);
+  ring->name[sizeof ring->name - 1] = '\0';
+  pthread_setspecific(g_ringKey, ring);
+  t_ring = ring;
+  return ring;
+}
+
+// Formats without malloc or locks, so that it is async-signal-safe.
+class LineWriter
+{
+ public:
+  LineWriter()
+    : len_(0)
+  {
+  }
+
+  void append(const char* str)
+  {
+    while (*str && len_ < kMaxLen)
+    {
+      buf_[len_++] = *str++;
+    }
+  }
+
+  void appendInt(int64_t v, int width = 0)
+  {
+    char digits[24];
+    int n = 0;
+    uint64_t u = v < 0 ? -static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+    do
+    {
+      digits[n++] = static_cast<char>('0' + u % 10);
+      u /= 10;
+    } while (u != 0);
+    while (n < width)
+    {
+      digits[n++] = '0';
+    }
+    if (v < 0)
+    {
+      digits[n++] = '-';
+    }
+    while (n > 0 && len_ < kMaxLen)
+    {
+      buf_[len_++] = digits[--n];
+    }
+  }
+
+  void append(char c)
+  {
+    if (len_ < kMaxLen)
+    {
+      buf_[len_++] = c;
+    }
+  }
+
+  const char* data() const { return buf_; }
+  int length() const { return len_; }
+
+ private:
+  static const int kMaxLen = 512;
+  char buf_[kMaxLen];
+  int len_;
+};
+
+const char* levelName(int level)
+{
+  return level == Logger::TRACE ? "TRACE " : "DEBUG ";
+}
+
+const char* sourceBasename(const char* file)
+{
+  const char* slash = strrchr(file, '/');
+  return slash ? slash + 1 : file;
+}
+
+typedef void (*RawOutput)(const char* msg, int len, void* context);
+
+void dumpRings(RawOutput output, void* context)
+{
+  int numRings = g_numRings.load(std::memory_order_acquire);
+  // ticks to time, at the rate since the first record
+  int64_t nowTicks = readTicks();
+  int64_t nowMonotonic = clockMicroseconds(CLOCK_MONOTONIC);
+  int64_t nowRealtime = clockMicroseconds(CLOCK_REALTIME);
+  double ticksPerMicrosecond = 1.0;
+  if (g_useTsc && nowMonotonic > g_baseMonotonic)
+  {
+    ticksPerMicrosecond = static_cast<double>(nowTicks - g_baseTicks)
+                          / static_cast<double>(nowMonotonic - g_baseMonotonic);
+  }
+
+  for (int i = 0; i < numRings && i < kMaxRings; ++i)
+  {
+    const Ring* ring = g_rings[i].load(std::memory_order_acquire);
+    if (ring == NULL)
+      continue;
+    uint64_t written = ring->written.load(std::memory_order_acquire);
+    if (written == 0)
+      continue;
+
+    uint64_t begin = written > kRingMask ? written - kRingMask - 1 : 0;
+    LineWriter header;
+    header.append("---- flight recorder of thread ");
+    header.appendInt(ring->tid);
+    header.append(' ');
+    header.append(ring->name);
+    header.append(ring->inUse.load(std::memory_order_relaxed) ? "" : " (exited)");
+    header.append(", ");
+    header.appendInt(static_cast<int64_t>(written - begin));
+    header.append(" of ");
+    header.appendInt(static_cast<int64_t>(written));
+    header.append(" records ----\n");
+    output(header.data(), header.length(), context);
+
+    for (uint64_t n = begin; n < written; ++n)
+    {
+      const Record& rec = ring->records[n & kRingMask];
+      int64_t time = nowRealtime - static_cast<int64_t>(
+          static_cast<double>(nowTicks - rec.ticks) / ticksPerMicrosecond);
+      int64_t seconds = time / Timestamp::kMicroSecondsPerSecond;
+      int64_t micros = time % Timestamp::kMicroSecondsPerSecond;
+      Date::YearMonthDay ymd = Date(static_cast<int>(seconds / 86400)
+                                    + Date::kJulianDayOf1970_01_01).yearMonthDay();
+      int secondsOfDay = static_cast<int>(seconds % 86400);
+
+      LineWriter line;
+      line.appendInt(ymd.year, 4);
+      line.appendInt(ymd.month, 2);
+      line.appendInt(ymd.day, 2);
+      line.append(' ');
+      line.appendInt(secondsOfDay / 3600, 2);
+      line.append(':');
+      line.appendInt(secondsOfDay / 60 % 60, 2);
+      line.append(':');
+      line.appendInt(secondsOfDay % 60, 2);
+      line.append('.');
+      line.appendInt(micros, 6);
+      line.append("Z ");
+      line.appendInt(ring->tid);
+      line.append(' ');
+      line.append(levelName(rec.level));
+      line.append(rec.msg);
+      for (int a = 0; a < rec.numArgs; ++a)
+      {
+        line.append(' ');
+        line.appendInt(rec.args[a]);
+      }
+      line.append(" - ");
+      line.append(sourceBasename(rec.file));
+      line.append(':');
+      line.appendInt(rec.line);
+      line.append('\n');
+      output(line.data(), line.length(), context);
+    }
+  }
+}
+
+void outputToFd(const char* msg, int len, void* context)
+{
+  int fd = *static_cast<int*>(context);
+  while (len > 0)
+  {
+    ssize_t n = ::write(fd, msg, len);
+    if (n <= 0)
+      break;
+    msg += n;
+    len -= static_cast<int>(n);
+  }
+}
+
+void outputToLogger(const char* msg, int len, void* context)
+{
+  (*static_cast<Logger::OutputFunc*>(context))(msg, len);
+}
+
+void outputToString(const char* msg, int len, void* context)
+{
+  static_cast<string*>(context)->append(msg, len);
+}
+
+void crashHandler(int sig)
+{
+  if (!g_crashDumped.exchange(true))
+  {
+    int fd = STDERR_FILENO;
+    dumpRings(outputToFd, &fd);
+  }
+  ::signal(sig, SIG_DFL);
+  ::raise(sig);  // delivered with default action once returned
+}
+
+}  // namespace
+
+void FlightRecorder::record(Logger::LogLevel level, const char* file, int line,
+                            const char* msg, int numArgs, int64_t arg0, int64_t arg1)
+{
+  Ring* ring = t_ring;
+  if (__builtin_expect(ring == NULL, 0))
+  {
+    if (t_noRing || (ring = acquireRing()) == NULL)
+      return;
+  }
+  uint64_t n = ring->written.load(std::memory_order_relaxed);
+  Record& rec = ring->records[n & kRingMask];
+  rec.ticks = readTicks();
+  rec.file = file;
+  rec.msg = msg;
+  rec.args[0] = arg0;
+  rec.args[1] = arg1;
+  rec.line = line;
+  rec.level = static_cast<short>(level);
+  rec.numArgs = static_cast<short>(numArgs);
+  ring->written.store(n + 1, std::memory_order_release);
+}
+
+void FlightRecorder::dump(int fd)
+{
+  dumpRings(outputToFd, &fd);
+}
+
+void FlightRecorder::dump(Logger::OutputFunc output)
+{
+  dumpRings(outputToLogger, &output);
+}
+
+string FlightRecorder::dumpToString()
+{
+  string result;
+  dumpRings(outputToString, &result);
+  return result;
+}
+
+void FlightRecorder::dumpOnCrash(Logger::OutputFunc output)
+{
+  if (!g_crashDumped.exchange(true))
+  {
+    dump(output);
+  }
+}
+
+void FlightRecorder::installSignalHandlers()
+{
+  const int signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+  for (int sig : signals)
+  {
+    struct sigaction sa;
+    memZero(&sa, sizeof sa);
+    sa.sa_handler = crashHandler;
+    sigemptyset(&sa.sa_mask);
+    ::sigaction(sig, &sa, NULL);
+  }
+}
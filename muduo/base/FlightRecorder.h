@@ -0,0 +1,70 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_FLIGHTRECORDER_H
+#define MUDUO_BASE_FLIGHTRECORDER_H
+
+#include "muduo/base/Logging.h"
+
+namespace muduo
+{
+
+///
+/// Always-on in-memory ring of recent TRACE/DEBUG records, one per thread.
+///
+/// Recording ignores Logger::logLevel(), takes no lock and does no formatting,
+/// a record keeps the message literal and two integer arguments as is,
+/// they are formatted only when dumped. So is time, kept as ticks of
+/// the invariant TSC if available, see TscClock.
+///
+/// Rings are dumped by LOG_FATAL, by crash signals once
+/// installSignalHandlers() is called, or on demand with dumpToString().
+/// Dumping does not stop recording threads, the oldest records may be torn.
+///
+class FlightRecorder : noncopyable
+{
+ public:
+  static const int kRecordsPerThread = 512;  // must be power of 2
+
+  // msg must outlive the process, usually a string literal.
+  static void record(Logger::LogLevel level, const char* file, int line,
+                     const char* msg)
+  { record(level, file, line, msg, 0, 0, 0); }
+
+  static void record(Logger::LogLevel level, const char* file, int line,
+                     const char* msg, int64_t arg0)
+  { record(level, file, line, msg, 1, arg0, 0); }
+
+  static void record(Logger::LogLevel level, const char* file, int line,
+                     const char* msg, int64_t arg0, int64_t arg1)
+  { record(level, file, line, msg, 2, arg0, arg1); }
+
+  // Async-signal-safe, writes to fd.
+  static void dump(int fd);
+  static void dump(Logger::OutputFunc output);
+  static string dumpToString();
+
+  // Called by LOG_FATAL and the signal handlers, dumps only once per process.
+  static void dumpOnCrash(Logger::OutputFunc output);
+
+  // Dump to stderr on SIGSEGV, SIGBUS, SIGFPE, SIGILL and SIGABRT,
+  // then re-raise with the default action.
+  static void installSignalHandlers();
+
+ private:
+  static void record(Logger::LogLevel level, const char* file, int line,
+                     const char* msg, int numArgs, int64_t arg0, int64_t arg1);
+};
+
+}  // namespace muduo
+
+// RECORD_DEBUG("peer closed, fd", fd);
+// RECORD_TRACE("bytes read, buffer", n, buf.readableBytes());
+#define RECORD_TRACE(...) \
+  muduo::FlightRecorder::record(muduo::Logger::TRACE, __FILE__, __LINE__, __VA_ARGS__)
+#define RECORD_DEBUG(...) \
+  muduo::FlightRecorder::record(muduo::Logger::DEBUG, __FILE__, __LINE__, __VA_ARGS__)
+
+#endif  // MUDUO_BASE_FLIGHTRECORDER_H
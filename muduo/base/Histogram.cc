@@ -0,0 +1,139 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/base/Histogram.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+using namespace muduo;
+
+Histogram::Snapshot::Snapshot()
+  : counts_(kNumBuckets),
+    count_(0),
+    sum_(0)
+{
+}
+
+void Histogram::Snapshot::merge(const Snapshot& rhs)
+{
+  for (int i = 0; i < kNumBuckets; ++i)
+  {
+    counts_[i] += rhs.counts_[i];
+  }
+  count_ += rhs.count_;
+  sum_ += rhs.sum_;
+}
+
+double Histogram::Snapshot::mean() const
+{
+  return count_ > 0 ? static_cast<double>(sum_) / static_cast<double>(count_) : 0.0;
+}
+
+int64_t Histogram::Snapshot::percentile(double percent) const
+{
+  if (count_ == 0)
+    return 0;
+  int64_t rank = static_cast<int64_t>(percent / 100.0 * static_cast<double>(count_) + 0.5);
+  if (rank < 1)
+    rank = 1;
+  int64_t seen = 0;
+  int last = 0;
+  for (int i = 0; i < kNumBuckets; ++i)
+  {
+    if (counts_[i] > 0)
+    {
+      last = i;
+      seen += counts_[i];
+      if (seen >= rank)
+        return bucketUpperBound(i);
+    }
+  }
+  return bucketUpperBound(last);
+}
+
+string Histogram::Snapshot::toString() const
+{
+  char buf[256];
+  snprintf(buf, sizeof buf,
+           "count %" PRId64 " mean %.1f p50 %" PRId64 " p90 %" PRId64
+           " p99 %" PRId64 " p999 %" PRId64 " max %" PRId64,
+           count_, mean(), percentile(50), percentile(90),
+           percentile(99), percentile(99.9), max());
+  return buf;
+}
+
+Histogram::Histogram()
+{
+  for (auto& shard : shards_)
+  {
+    shard.store(NULL, std::memory_order_relaxed);
+  }
+}
+
+Histogram::~Histogram()
+{
+  for (auto& shard : shards_)
+  {
+    delete shard.load(std::memory_order_relaxed);
+  }
+}
+
+Histogram::Shard* Histogram::newShard(int index)
+{
+  Shard* shard = new Shard;
+  for (auto& count : shard->counts)
+  {
+    count.store(0, std::memory_order_relaxed);
+  }
+  shard->sum.store(0, std::memory_order_relaxed);
+
+  Shard* expected = NULL;
+  if (!shards_[index].compare_exchange_strong(expected, shard,
+                                              std::memory_order_acq_rel))
+  {
+    // another thread of the same shard won
+    delete shard;
+    shard = expected;
+  }
+  return shard;
+}
+
+Histogram::Snapshot Histogram::snapshot() const
+{
+  Snapshot result;
+  for (const auto& s : shards_)
+  {
+    const Shard* shard = s.load(std::memory_order_acquire);
+    if (shard == NULL)
+      continue;
+    for (int i = 0; i < kNumBuckets; ++i)
+    {
+      int64_t count = shard->counts[i].load(std::memory_order_relaxed);
+      result.counts_[i] += count;
+      result.count_ += count;
+    }
+    result.sum_ += shard->sum.load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+int64_t Histogram::bucketLowerBound(int index)
+{
+  if (index < kSubBuckets)
+    return index;
+  int shift = index / kSubBuckets - 1;
+  return static_cast<int64_t>(index % kSubBuckets + kSubBuckets) << shift;
+}
+
+int64_t Histogram::bucketUpperBound(int index)
+{
+  if (index < kSubBuckets)
+    return index;
+  if (index == kNumBuckets - 1)
+    return INT64_MAX;
+  int shift = index / kSubBuckets - 1;
+  return bucketLowerBound(index) + (static_cast<int64_t>(1) << shift) - 1;
+}
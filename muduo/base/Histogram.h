@@ -0,0 +1,105 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_HISTOGRAM_H
+#define MUDUO_BASE_HISTOGRAM_H
+
+#include "muduo/base/copyable.h"
+#include "muduo/base/ShardedCounter.h"
+#include "muduo/base/Types.h"
+
+#include <vector>
+
+namespace muduo
+{
+
+///
+/// Log-linear histogram of non-negative values, like HdrHistogram.
+///
+/// Every power of 2 is divided into kSubBuckets linear buckets, so the
+/// relative error is below 1/kSubBuckets across the whole int64_t range.
+/// Values below kSubBuckets are exact.
+///
+/// record() is lock-free and, like ShardedCounter, writes to a shard of
+/// its own thread. Shards are allocated on first use.
+///
+class Histogram : noncopyable
+{
+ public:
+  static const int kSubBucketBits = 5;
+  static const int kSubBuckets = 1 << kSubBucketBits;
+  static const int kNumBuckets = (64 - kSubBucketBits) * kSubBuckets;
+
+  class Snapshot : public muduo::copyable
+  {
+   public:
+    Snapshot();
+
+    void merge(const Snapshot& rhs);
+
+    int64_t count() const { return count_; }
+    int64_t sum() const { return sum_; }
+    double mean() const;
+    // upper bound of the bucket holding the value at percent in [0, 100],
+    // 0 if empty.
+    int64_t percentile(double percent) const;
+    int64_t max() const { return percentile(100.0); }
+
+    // count 1000 mean 52.3 p50 47 p90 95 p99 191 p999 255 max 511
+    string toString() const;
+
+   private:
+    friend class Histogram;
+
+    std::vector<int64_t> counts_;
+    int64_t count_;
+    int64_t sum_;
+  };
+
+  Histogram();
+  ~Histogram();
+
+  // negative values are recorded as 0.
+  void record(int64_t value)
+  {
+    Shard* shard = shards_[detail::shardIndex()].load(std::memory_order_acquire);
+    if (__builtin_expect(shard == NULL, 0))
+    {
+      shard = newShard(detail::shardIndex());
+    }
+    shard->counts[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    shard->sum.fetch_add(value > 0 ? value : 0, std::memory_order_relaxed);
+  }
+
+  // Not atomic with concurrent record(), each bucket is read once.
+  Snapshot snapshot() const;
+
+  static int bucketIndex(int64_t value)
+  {
+    if (value < kSubBuckets)
+      return value > 0 ? static_cast<int>(value) : 0;
+    int shift = 63 - __builtin_clzll(static_cast<uint64_t>(value)) - kSubBucketBits;
+    return (shift + 1) * kSubBuckets + static_cast<int>(value >> shift) - kSubBuckets;
+  }
+
+  // [lower, upper] of values in the bucket
+  static int64_t bucketLowerBound(int index);
+  static int64_t bucketUpperBound(int index);
+
+ private:
+  struct Shard
+  {
+    std::atomic<int64_t> counts[kNumBuckets];
+    std::atomic<int64_t> sum;
+  };
+
+  Shard* newShard(int index);
+
+  std::atomic<Shard*> shards_[detail::kNumShards];
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_HISTOGRAM_H
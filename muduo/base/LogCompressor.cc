@@ -0,0 +1,263 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/base/LogCompressor.h"
+
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/CurrentThread.h"
+#include "muduo/base/Timestamp.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+#include <zlib.h>
+
+using namespace muduo;
+
+namespace
+{
+
+// from linux/ioprio.h
+const int kIoprioWhoProcess = 1;
+const int kIoprioClassIdle = 3;
+const int kIoprioClassShift = 13;
+
+// return bytes read, -1 on error
+ssize_t readFully(int fd, char* buf, size_t len)
+{
+  size_t n = 0;
+  while (n < len)
+  {
+    ssize_t nr = ::read(fd, buf + n, len - n);
+    if (nr > 0)
+    {
+      n += nr;
+    }
+    else if (nr == 0)
+    {
+      break;
+    }
+    else if (errno != EINTR)
+    {
+      return -1;
+    }
+  }
+  return static_cast<ssize_t>(n);
+}
+
+}  // namespace
+
+LogCompressor::LogCompressor(int numThreads, const string& nameArg)
+  : numThreads_(numThreads),
+    chunkSize_(1024*1024),
+    level_(Z_DEFAULT_COMPRESSION),
+    nice_(19),
+    maxBytesPerSecond_(0),
+    keepOriginal_(false),
+    running_(false),
+    pool_(nameArg + "Pool"),
+    thread_(std::bind(&LogCompressor::threadFunc, this), nameArg)
+{
+}
+
+LogCompressor::~LogCompressor()
+{
+  if (running_)
+  {
+    stop();
+  }
+}
+
+void LogCompressor::start()
+{
+  assert(!running_);
+  assert(chunkSize_ > 0);
+  running_ = true;
+  pool_.setThreadInitCallback(std::bind(&LogCompressor::lowerPriority, this));
+  // chunks are compressed in the dispatching thread when numThreads_ == 0,
+  // lowerPriority() then runs in start()'s caller, so defer it to threadFunc().
+  if (numThreads_ > 0)
+  {
+    pool_.start(numThreads_);
+  }
+  thread_.start();
+}
+
+void LogCompressor::stop()
+{
+  assert(running_);
+  running_ = false;
+  queue_.put(string());
+  thread_.join();
+  if (numThreads_ > 0)
+  {
+    pool_.stop();
+  }
+}
+
+void LogCompressor::compress(const string& filename)
+{
+  if (!filename.empty())
+  {
+    queue_.put(filename);
+  }
+}
+
+void LogCompressor::threadFunc()
+{
+  lowerPriority();
+  while (true)
+  {
+    string filename(queue_.take());
+    if (filename.empty())
+    {
+      break;
+    }
+    compressFile(filename);
+  }
+}
+
+void LogCompressor::lowerPriority()
+{
+  pid_t tid = CurrentThread::tid();
+  // On Linux, nice value and I/O priority are per thread.
+  if (::setpriority(PRIO_PROCESS, static_cast<id_t>(tid), nice_) < 0)
+  {
+    fprintf(stderr, "LogCompressor::lowerPriority setpriority failed %d\n", errno);
+  }
+  ::syscall(SYS_ioprio_set, kIoprioWhoProcess, tid, kIoprioClassIdle << kIoprioClassShift);
+}
+
+bool LogCompressor::compressFile(const string& filename)
+{
+  int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    fprintf(stderr, "LogCompressor failed to open %s, errno %d\n", filename.c_str(), errno);
+    return false;
+  }
+
+  string gzname = filename + ".gz";
+  string tmpname = gzname + ".tmp";
+  FILE* fp = ::fopen(tmpname.c_str(), "we");
+  if (fp == NULL)
+  {
+    fprintf(stderr, "LogCompressor failed to create %s, errno %d\n", tmpname.c_str(), errno);
+    ::close(fd);
+    return false;
+  }
+
+  // one batch holds a chunk per worker, compressed in parallel and written in order.
+  const size_t batch = numThreads_ > 0 ? numThreads_ : 1;
+  std::vector<string> inputs(batch);
+  std::vector<string> outputs(batch);
+  std::vector<char> ok(batch);
+  int64_t totalIn = 0;
+  int64_t totalOut = 0;
+  Timestamp start(Timestamp::now());
+  bool good = true;
+  bool eof = false;
+  while (good && !eof)
+  {
+    size_t n = 0;
+    for (; n < batch && !eof; ++n)
+    {
+      inputs[n].resize(chunkSize_);
+      ssize_t nr = readFully(fd, &*inputs[n].begin(), chunkSize_);
+      if (nr < 0)
+      {
+        fprintf(stderr, "LogCompressor failed to read %s, errno %d\n", filename.c_str(), errno);
+        good = false;
+        break;
+      }
+      inputs[n].resize(nr);
+      eof = nr < chunkSize_;
+      if (nr == 0)
+      {
+        break;
+      }
+      totalIn += nr;
+    }
+    if (!good || n == 0)
+    {
+      break;
+    }
+
+    CountDownLatch latch(static_cast<int>(n));
+    for (size_t i = 0; i < n; ++i)
+    {
+      pool_.run([this, i, &inputs, &outputs, &ok, &latch]
+      {
+        outputs[i].clear();
+        ok[i] = compressChunk(inputs[i].data(), inputs[i].size(), level_, &outputs[i]);
+        latch.countDown();
+      });
+    }
+    latch.wait();
+
+    for (size_t i = 0; i < n && good; ++i)
+    {
+      good = ok[i] && ::fwrite(outputs[i].data(), 1, outputs[i].size(), fp) == outputs[i].size();
+      totalOut += outputs[i].size();
+    }
+
+    if (maxBytesPerSecond_ > 0)
+    {
+      double expected = static_cast<double>(totalIn) / static_cast<double>(maxBytesPerSecond_);
+      double elapsed = timeDifference(Timestamp::now(), start);
+      if (expected > elapsed)
+      {
+        CurrentThread::sleepUsec(static_cast<int64_t>((expected - elapsed) * Timestamp::kMicroSecondsPerSecond));
+      }
+    }
+  }
+  ::close(fd);
+
+  if (::fclose(fp) != 0)
+  {
+    good = false;
+  }
+  if (good && ::rename(tmpname.c_str(), gzname.c_str()) == 0)
+  {
+    if (!keepOriginal_)
+    {
+      ::unlink(filename.c_str());
+    }
+    filesCompressed_.increment();
+    inputBytes_.add(totalIn);
+    outputBytes_.add(totalOut);
+    return true;
+  }
+  fprintf(stderr, "LogCompressor failed to compress %s\n", filename.c_str());
+  ::unlink(tmpname.c_str());
+  return false;
+}
+
+bool LogCompressor::compressChunk(const char* data, size_t len, int level, string* output)
+{
+  z_stream zs;
+  memZero(&zs, sizeof zs);
+  // windowBits 15+16 writes a gzip header and trailer instead of a zlib one.
+  if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+  {
+    return false;
+  }
+  size_t offset = output->size();
+  output->resize(offset + deflateBound(&zs, static_cast<uLong>(len)));
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  zs.avail_in = static_cast<uInt>(len);
+  zs.next_out = reinterpret_cast<Bytef*>(&*output->begin() + offset);
+  zs.avail_out = static_cast<uInt>(output->size() - offset);
+  int err = ::deflate(&zs, Z_FINISH);
+  output->resize(offset + zs.total_out);
+  ::deflateEnd(&zs);
+  return err == Z_STREAM_END;
+}
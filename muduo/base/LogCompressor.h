@@ -0,0 +1,89 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_LOGCOMPRESSOR_H
+#define MUDUO_BASE_LOGCOMPRESSOR_H
+
+#include "muduo/base/Atomic.h"
+#include "muduo/base/BlockingQueue.h"
+#include "muduo/base/Thread.h"
+#include "muduo/base/ThreadPool.h"
+#include "muduo/base/Types.h"
+
+namespace muduo
+{
+
+///
+/// Compresses rolled log files in background, pigz style.
+///
+/// A file is cut into fixed size chunks, each chunk is deflated into
+/// a standalone gzip member on a worker thread, members are written in order,
+/// so 'foo.log' becomes 'foo.log.gz' readable by gunzip or GzipFile.
+/// All threads run at idle nice and idle I/O priority.
+///
+/// Usage:
+///   LogCompressor compressor(2);
+///   compressor.start();
+///   logFile.setRollCallback(
+///       std::bind(&LogCompressor::compress, &compressor, _1));
+///
+/// Needs zlib, link with muduo_logcompressor.
+class LogCompressor : noncopyable
+{
+ public:
+  explicit LogCompressor(int numThreads = 1,
+                         const string& nameArg = string("LogCompressor"));
+  ~LogCompressor();
+
+  // Must be called before start().
+  void setChunkSize(int bytes) { chunkSize_ = bytes; }
+  // zlib level, 1 (fastest) to 9 (best), -1 for default.
+  void setLevel(int level) { level_ = level; }
+  // nice value of compressing threads, 19 by default.
+  void setNice(int nice) { nice_ = nice; }
+  // Caps CPU usage by throttling input bytes per second, 0 for unlimited.
+  void setMaxBytesPerSecond(int64_t bytes) { maxBytesPerSecond_ = bytes; }
+  void setKeepOriginal(bool on) { keepOriginal_ = on; }
+
+  void start();
+  // Compresses queued files before return.
+  void stop();
+
+  // Thread safe, returns immediately.
+  void compress(const string& filename);
+
+  // Compresses filename to filename.gz in calling thread,
+  // using worker threads if started.
+  bool compressFile(const string& filename);
+
+  int64_t filesCompressed() { return filesCompressed_.get(); }
+  int64_t inputBytes() { return inputBytes_.get(); }
+  int64_t outputBytes() { return outputBytes_.get(); }
+
+  // Deflates data into a complete gzip member, appended to output.
+  static bool compressChunk(const char* data, size_t len, int level, string* output);
+
+ private:
+  void threadFunc();
+  void lowerPriority();
+
+  int numThreads_;
+  int chunkSize_;
+  int level_;
+  int nice_;
+  int64_t maxBytesPerSecond_;
+  bool keepOriginal_;
+  bool running_;
+  BlockingQueue<string> queue_;
+  ThreadPool pool_;
+  Thread thread_;
+  AtomicInt64 filesCompressed_;
+  AtomicInt64 inputBytes_;
+  AtomicInt64 outputBytes_;
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_LOGCOMPRESSOR_H
@@ -102,6 +102,11 @@ bool LogFile::rollFile()
     lastFlush_ = now;
     startOfPeriod_ = start;
     file_.reset(new FileUtil::AppendFile(filename));
+    filename.swap(filename_);
+    if (rollCallback_ && !filename.empty())
+    {
+      rollCallback_(filename);
+    }
     return true;
   }
   return false;
@@ -9,6 +9,7 @@
 #include "muduo/base/Mutex.h"
 #include "muduo/base/Types.h"
 
+#include <functional>
 #include <memory>
 
 namespace muduo
@@ -22,6 +23,10 @@ class AppendFile;
 class LogFile : noncopyable
 {
  public:
+  // called with the name of the file just closed by rollFile(),
+  // under the LogFile's lock, so it should only hand the name off.
+  typedef std::function<void (const string& filename)> RollCallback;
+
   LogFile(const string& basename,
           off_t rollSize,
           bool threadSafe = true,
@@ -33,6 +38,10 @@ class LogFile : noncopyable
   void flush();
   bool rollFile();
 
+  // Not thread safe, must be called before appending.
+  void setRollCallback(const RollCallback& cb)
+  { rollCallback_ = cb; }
+
  private:
   void append_unlocked(const char* logline, int len);
 
@@ -50,6 +59,8 @@ class LogFile : noncopyable
   time_t lastRoll_;
   time_t lastFlush_;
   std::unique_ptr<FileUtil::AppendFile> file_;
+  string filename_;
+  RollCallback rollCallback_;
 
   const static int kRollPerSeconds_ = 60*60*24;
 };
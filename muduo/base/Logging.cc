@@ -6,6 +6,7 @@
 #include "muduo/base/Logging.h"
 
 #include "muduo/base/CurrentThread.h"
+#include "muduo/base/FlightRecorder.h"
 #include "muduo/base/Timestamp.h"
 #include "muduo/base/TimeZone.h"
 
@@ -37,13 +38,40 @@ class LoggerImpl
 
 __thread char t_errnobuf[512];
 __thread char t_time[64];
-__thread time_t t_lastSecond;
+// UTC seconds in which the "YYYYmmdd HH:MM:" prefix of t_time holds
+__thread time_t t_minuteStart;
+__thread time_t t_minuteEnd;
+__thread int t_date;
 
 const char* strerror_tl(int savedErrno)
 {
   return strerror_r(savedErrno, t_errnobuf, sizeof t_errnobuf);
 }
 
+int64_t LogSite::everyT(double seconds)
+{
+  int64_t count = count_.fetch_add(1, std::memory_order_relaxed) + 1;
+  int64_t now = Timestamp::now().microSecondsSinceEpoch();
+  int64_t next = nextLogTime_.load(std::memory_order_relaxed);
+  if (now < next)
+    return -1;
+  int64_t interval = static_cast<int64_t>(seconds * Timestamp::kMicroSecondsPerSecond);
+  // only one thread wins the race for this period
+  if (!nextLogTime_.compare_exchange_strong(next, now + interval, std::memory_order_relaxed))
+    return -1;
+  int64_t last = logged_.exchange(count, std::memory_order_relaxed);
+  return count > last ? count - last - 1 : 0;
+}
+
+LogStream& operator<<(LogStream& s, LogSite::Suppressed v)
+{
+  if (v.count > 0)
+  {
+    s << "[suppressed " << v.count << " messages] ";
+  }
+  return s;
+}
+
 Logger::LogLevel initLogLevel()
 {
   if (::getenv("MUDUO_LOG_TRACE"))
@@ -130,41 +158,75 @@ Logger::Impl::Impl(LogLevel level, int savedErrno, const SourceFile& file, int l
   }
 }
 
-void Logger::Impl::formatTime()
+namespace
 {
-  int64_t microSecondsSinceEpoch = time_.microSecondsSinceEpoch();
-  time_t seconds = static_cast<time_t>(microSecondsSinceEpoch / Timestamp::kMicroSecondsPerSecond);
-  int microseconds = static_cast<int>(microSecondsSinceEpoch % Timestamp::kMicroSecondsPerSecond);
-  if (seconds != t_lastSecond)
+
+inline void formatTwoDigits(char* buf, int x)
+{
+  buf[0] = static_cast<char>('0' + x / 10);
+  buf[1] = static_cast<char>('0' + x % 10);
+}
+
+// Rewrites the date part only when it changes, which is once a day.
+// A transition of the time zone in the middle of a minute is seen at
+// the next minute.
+void updateMinute(time_t seconds)
+{
+  struct tm tm_time;
+  if (g_logTimeZone.valid())
   {
-    t_lastSecond = seconds;
-    struct tm tm_time;
-    if (g_logTimeZone.valid())
-    {
-      tm_time = g_logTimeZone.toLocalTime(seconds);
-    }
-    else
-    {
-      ::gmtime_r(&seconds, &tm_time); // FIXME TimeZone::fromUtcTime
-    }
+    tm_time = g_logTimeZone.toLocalTime(seconds);
+  }
+  else
+  {
+    ::gmtime_r(&seconds, &tm_time); // FIXME TimeZone::fromUtcTime
+  }
 
+  int date = (tm_time.tm_year + 1900) * 10000 + (tm_time.tm_mon + 1) * 100 + tm_time.tm_mday;
+  if (date != t_date)
+  {
+    t_date = date;
     int len = snprintf(t_time, sizeof(t_time), "%4d%02d%02d %02d:%02d:%02d",
         tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
         tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec);
     assert(len == 17); (void)len;
   }
+  else
+  {
+    formatTwoDigits(t_time + 9, tm_time.tm_hour);
+    formatTwoDigits(t_time + 12, tm_time.tm_min);
+  }
+  t_minuteStart = seconds - tm_time.tm_sec;
+  t_minuteEnd = t_minuteStart + 60;
+}
 
+}  // namespace
+
+void Logger::Impl::formatTime()
+{
+  int64_t microSecondsSinceEpoch = time_.microSecondsSinceEpoch();
+  time_t seconds = static_cast<time_t>(microSecondsSinceEpoch / Timestamp::kMicroSecondsPerSecond);
+  int microseconds = static_cast<int>(microSecondsSinceEpoch % Timestamp::kMicroSecondsPerSecond);
+  if (seconds < t_minuteStart || seconds >= t_minuteEnd)
+  {
+    updateMinute(seconds);
+  }
+  formatTwoDigits(t_time + 15, static_cast<int>(seconds - t_minuteStart));
+
+  char us[] = ".000000Z ";
+  for (int i = 6; i > 0; --i)
+  {
+    us[i] = static_cast<char>('0' + microseconds % 10);
+    microseconds /= 10;
+  }
   if (g_logTimeZone.valid())
   {
-    Fmt us(".%06d ", microseconds);
-    assert(us.length() == 8);
-    stream_ << T(t_time, 17) << T(us.data(), 8);
+    us[7] = ' ';
+    stream_ << T(t_time, 17) << T(us, 8);
   }
   else
   {
-    Fmt us(".%06dZ ", microseconds);
-    assert(us.length() == 9);
-    stream_ << T(t_time, 17) << T(us.data(), 9);
+    stream_ << T(t_time, 17) << T(us, 9);
   }
 }
 
@@ -201,6 +263,7 @@ Logger::~Logger()
   g_output(buf.data(), buf.length());
   if (impl_.level_ == FATAL)
   {
+    FlightRecorder::dumpOnCrash(g_output);
     g_flush();
     abort();
   }
@@ -224,4 +287,6 @@ void Logger::setFlush(FlushFunc flush)
 void Logger::setTimeZone(const TimeZone& tz)
 {
   g_logTimeZone = tz;
+  t_date = 0;
+  t_minuteEnd = 0;
 }
@@ -9,6 +9,8 @@
 #include "muduo/base/LogStream.h"
 #include "muduo/base/Timestamp.h"
 
+#include <atomic>
+
 namespace muduo
 {
 
@@ -135,6 +137,82 @@ inline Logger::LogLevel Logger::logLevel()
 
 const char* strerror_tl(int savedErrno);
 
+// Per call site state of LOG_EVERY_N, LOG_FIRST_N and LOG_EVERY_T,
+// lock free and constant initialized, so a static one costs no guard.
+class LogSite : noncopyable
+{
+ public:
+  struct Suppressed
+  {
+    explicit Suppressed(int64_t n) : count(n) { }
+    int64_t count;
+  };
+
+  constexpr LogSite()
+    : count_(0),
+      logged_(0),
+      nextLogTime_(0)
+  {
+  }
+
+  // The following return the number of messages suppressed since last logged,
+  // or -1 if this one should be suppressed.
+
+  int64_t everyN(int n)
+  {
+    if (n <= 1)  // every time, and no division by zero
+      return 0;
+    int64_t count = count_.fetch_add(1, std::memory_order_relaxed);
+    if (count % n != 0)
+      return -1;
+    return count == 0 ? 0 : n - 1;
+  }
+
+  int64_t firstN(int n)
+  {
+    int64_t count = count_.load(std::memory_order_relaxed);
+    if (count >= n)  // stop counting, save a locked instruction
+      return -1;
+    count = count_.fetch_add(1, std::memory_order_relaxed);
+    return count < n ? 0 : -1;
+  }
+
+  int64_t everyT(double seconds);
+
+ private:
+  std::atomic<int64_t> count_;
+  std::atomic<int64_t> logged_;
+  std::atomic<int64_t> nextLogTime_;
+};
+
+LogStream& operator<<(LogStream& s, LogSite::Suppressed v);
+
+// Get a distinct static LogSite for each expansion.
+#define MUDUO_LOG_SITE \
+  ([]() -> muduo::LogSite& { static muduo::LogSite site; return site; }())
+
+#define MUDUO_LOG_SAMPLED(severity, decision) \
+  for (int64_t muduo_suppressed_ = (decision); muduo_suppressed_ >= 0; muduo_suppressed_ = -1) \
+    LOG_##severity << muduo::LogSite::Suppressed(muduo_suppressed_)
+
+//
+// Sampled logging for hot paths, severity is one of TRACE, DEBUG, INFO,
+// WARN, ERROR, FATAL, SYSERR and SYSFATAL. The same CAUTION above applies.
+//
+// LOG_EVERY_N(WARN, 100) << "logged on 1st, 101st, 201st, ... occurrences";
+// LOG_FIRST_N(INFO, 10) << "logged on first 10 occurrences";
+// LOG_EVERY_T(SYSERR, 1.0) << "logged at most once per second";
+//
+// Logged messages are prefixed with "[suppressed N messages]" if any.
+// LOG_EVERY_N logs every occurrence if n <= 1.
+//
+#define LOG_EVERY_N(severity, n) \
+  MUDUO_LOG_SAMPLED(severity, MUDUO_LOG_SITE.everyN(n))
+#define LOG_FIRST_N(severity, n) \
+  MUDUO_LOG_SAMPLED(severity, MUDUO_LOG_SITE.firstN(n))
+#define LOG_EVERY_T(severity, seconds) \
+  MUDUO_LOG_SAMPLED(severity, MUDUO_LOG_SITE.everyT(seconds))
+
 // Taken from glog/logging.h
 //
 // Check that the input is non NULL.  This very useful in constructor
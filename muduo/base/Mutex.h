@@ -11,6 +11,10 @@
 #include <assert.h>
 #include <pthread.h>
 
+#ifdef MUDUO_MUTEX_PROFILING
+#include <atomic>
+#endif
+
 // Thread safety annotations {
 // https://clang.llvm.org/docs/ThreadSafetyAnalysis.html
 
@@ -107,6 +111,19 @@ __END_DECLS
 namespace muduo
 {
 
+#ifdef MUDUO_MUTEX_PROFILING
+namespace detail
+{
+// see MutexProfiler.h
+struct MutexStats;
+extern std::atomic<bool> g_mutexProfiling;
+MutexStats* mutexStats(const char* name);
+void recordMutexWait(MutexStats* stats, int64_t nanoseconds);
+void recordMutexHold(MutexStats* stats, int64_t nanoseconds);
+int64_t mutexClock();
+}  // namespace detail
+#endif
+
 // Use as data member of a class, eg.
 //
 // class Foo
@@ -118,6 +135,8 @@ namespace muduo
 //   mutable MutexLock mutex_;
 //   std::vector<int> data_ GUARDED_BY(mutex_);
 // };
+//
+// Give it a name to tell it apart in the report of MutexProfiler.
 class CAPABILITY("mutex") MutexLock : noncopyable
 {
  public:
@@ -125,6 +144,15 @@ class CAPABILITY("mutex") MutexLock : noncopyable
     : holder_(0)
   {
     MCHECK(pthread_mutex_init(&mutex_, NULL));
+    initProfiling(NULL);
+  }
+
+  // name must outlive the mutex, usually a string literal.
+  explicit MutexLock(const char* name)
+    : holder_(0)
+  {
+    MCHECK(pthread_mutex_init(&mutex_, NULL));
+    initProfiling(name);
   }
 
   ~MutexLock()
@@ -148,6 +176,13 @@ class CAPABILITY("mutex") MutexLock : noncopyable
 
   void lock() ACQUIRE()
   {
+#ifdef MUDUO_MUTEX_PROFILING
+    if (detail::g_mutexProfiling.load(std::memory_order_relaxed))
+    {
+      lockProfiled();
+      return;
+    }
+#endif
     MCHECK(pthread_mutex_lock(&mutex_));
     assignHolder();
   }
@@ -155,7 +190,16 @@ class CAPABILITY("mutex") MutexLock : noncopyable
   void unlock() RELEASE()
   {
     unassignHolder();
+#ifdef MUDUO_MUTEX_PROFILING
+    int64_t held = endHold();
     MCHECK(pthread_mutex_unlock(&mutex_));
+    if (held >= 0)
+    {
+      detail::recordMutexHold(stats(), held);
+    }
+#else
+    MCHECK(pthread_mutex_unlock(&mutex_));
+#endif
   }
 
   pthread_mutex_t* getPthreadMutex() /* non-const */
@@ -173,17 +217,79 @@ class CAPABILITY("mutex") MutexLock : noncopyable
       : owner_(owner)
     {
       owner_.unassignHolder();
+#ifdef MUDUO_MUTEX_PROFILING
+      // waiting on a condition does not count as holding
+      held_ = owner_.endHold();
+#endif
     }
 
     ~UnassignGuard()
     {
       owner_.assignHolder();
+#ifdef MUDUO_MUTEX_PROFILING
+      if (held_ >= 0)
+      {
+        detail::recordMutexHold(owner_.stats(), held_);
+        owner_.lockedAt_ = detail::mutexClock();
+      }
+#endif
     }
 
    private:
     MutexLock& owner_;
+#ifdef MUDUO_MUTEX_PROFILING
+    int64_t held_;
+#endif
   };
 
+#ifdef MUDUO_MUTEX_PROFILING
+  void initProfiling(const char* name)
+  {
+    name_ = name;
+    stats_.store(NULL, std::memory_order_relaxed);
+    lockedAt_ = 0;
+  }
+
+  detail::MutexStats* stats()
+  {
+    detail::MutexStats* result = stats_.load(std::memory_order_acquire);
+    if (result == NULL)
+    {
+      result = detail::mutexStats(name_);
+      stats_.store(result, std::memory_order_release);
+    }
+    return result;
+  }
+
+  void lockProfiled()
+  {
+    int64_t wait = 0;
+    if (pthread_mutex_trylock(&mutex_) != 0)
+    {
+      int64_t start = detail::mutexClock();
+      MCHECK(pthread_mutex_lock(&mutex_));
+      wait = detail::mutexClock() - start;
+    }
+    assignHolder();
+    lockedAt_ = detail::mutexClock();
+    detail::recordMutexWait(stats(), wait);
+  }
+
+  // returns -1 if not locked by lockProfiled()
+  int64_t endHold()
+  {
+    if (lockedAt_ == 0)
+      return -1;
+    int64_t held = detail::mutexClock() - lockedAt_;
+    lockedAt_ = 0;
+    return held;
+  }
+#else
+  void initProfiling(const char*)
+  {
+  }
+#endif
+
   void unassignHolder()
   {
     holder_ = 0;
@@ -196,6 +302,11 @@ class CAPABILITY("mutex") MutexLock : noncopyable
 
   pthread_mutex_t mutex_;
   pid_t holder_;
+#ifdef MUDUO_MUTEX_PROFILING
+  const char* name_;
+  std::atomic<detail::MutexStats*> stats_;
+  int64_t lockedAt_;  // guarded by mutex_, 0 if not profiled
+#endif
 };
 
 // Use as a stack variable, eg.
@@ -0,0 +1,241 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/base/MutexProfiler.h"
+
+#include "muduo/base/CurrentThread.h"
+#include "muduo/base/Histogram.h"
+#include "muduo/base/Mutex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <vector>
+
+#include <execinfo.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+namespace muduo
+{
+namespace detail
+{
+
+const int kMaxFrames = 16;
+const int kMaxSlowWaits = 8;
+
+struct SlowWait
+{
+  int64_t nanoseconds;
+  int tid;
+  int depth;
+  void* frames[kMaxFrames];
+};
+
+struct MutexStats
+{
+  string name;
+  Histogram wait;
+  Histogram hold;
+  ShardedCounter contended;
+
+  // slow path only, a raw mutex, not to be profiled itself
+  pthread_mutex_t slowMutex;
+  int64_t numSlowWaits;
+  SlowWait slowWaits[kMaxSlowWaits];
+};
+
+std::atomic<bool> g_mutexProfiling(false);
+std::atomic<int64_t> g_stackThreshold(0);  // in nanoseconds
+
+// Stats are never freed, they outlive the mutexes of the same name.
+pthread_mutex_t g_registryMutex = PTHREAD_MUTEX_INITIALIZER;
+std::map<string, MutexStats*>* g_registry;
+
+MutexStats* mutexStats(const char* name)
+{
+  string key(name ? name : "(unnamed)");
+  MCHECK(pthread_mutex_lock(&g_registryMutex));
+  if (g_registry == NULL)
+  {
+    g_registry = new std::map<string, MutexStats*>;
+  }
+  MutexStats*& stats = (*g_registry)[key];
+  if (stats == NULL)
+  {
+    stats = new MutexStats;
+    stats->name = key;
+    MCHECK(pthread_mutex_init(&stats->slowMutex, NULL));
+    stats->numSlowWaits = 0;
+  }
+  MutexStats* result = stats;
+  MCHECK(pthread_mutex_unlock(&g_registryMutex));
+  return result;
+}
+
+void recordMutexWait(MutexStats* stats, int64_t nanoseconds)
+{
+  stats->wait.record(nanoseconds);
+  if (nanoseconds > 0)
+  {
+    stats->contended.increment();
+    int64_t threshold = g_stackThreshold.load(std::memory_order_relaxed);
+    if (threshold > 0 && nanoseconds >= threshold)
+    {
+      SlowWait slow;
+      slow.nanoseconds = nanoseconds;
+      slow.tid = CurrentThread::tid();
+      slow.depth = ::backtrace(slow.frames, kMaxFrames);
+      MCHECK(pthread_mutex_lock(&stats->slowMutex));
+      stats->slowWaits[stats->numSlowWaits++ % kMaxSlowWaits] = slow;
+      MCHECK(pthread_mutex_unlock(&stats->slowMutex));
+    }
+  }
+}
+
+void recordMutexHold(MutexStats* stats, int64_t nanoseconds)
+{
+  stats->hold.record(nanoseconds);
+}
+
+int64_t mutexClock()
+{
+  struct timespec ts;
+  ::clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000 * 1000 * 1000 + ts.tv_nsec;
+}
+
+}  // namespace detail
+}  // namespace muduo
+
+using namespace muduo;
+
+namespace
+{
+
+struct Report
+{
+  detail::MutexStats* stats;
+  Histogram::Snapshot wait;
+  Histogram::Snapshot hold;
+
+  bool operator<(const Report& rhs) const
+  {
+    return wait.sum() > rhs.wait.sum();
+  }
+};
+
+void appendf(string* out, const char* fmt, ...) __attribute__ ((format (printf, 2, 3)));
+
+void appendf(string* out, const char* fmt, ...)
+{
+  char buf[512];
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf, sizeof buf, fmt, args);
+  va_end(args);
+  out->append(buf, std::min(static_cast<size_t>(n), sizeof buf - 1));
+}
+
+void appendSlowWaits(string* out, detail::MutexStats* stats)
+{
+  std::vector<detail::SlowWait> slowWaits;
+  MCHECK(pthread_mutex_lock(&stats->slowMutex));
+  int64_t total = stats->numSlowWaits;
+  int64_t first = std::max<int64_t>(0, total - detail::kMaxSlowWaits);
+  for (int64_t i = first; i < total; ++i)
+  {
+    slowWaits.push_back(stats->slowWaits[i % detail::kMaxSlowWaits]);
+  }
+  MCHECK(pthread_mutex_unlock(&stats->slowMutex));
+
+  if (total > 0)
+  {
+    appendf(out, "  slow waits, last %zd of %" PRId64 ":\n", slowWaits.size(), total);
+  }
+  for (const detail::SlowWait& slow : slowWaits)
+  {
+    appendf(out, "    %" PRId64 " us by thread %d\n", slow.nanoseconds / 1000, slow.tid);
+    char** symbols = ::backtrace_symbols(slow.frames, slow.depth);
+    if (symbols)
+    {
+      // skipping recordMutexWait()
+      for (int i = 1; i < slow.depth; ++i)
+      {
+        appendf(out, "      %s\n", symbols[i]);
+      }
+      ::free(symbols);
+    }
+  }
+}
+
+}  // namespace
+
+bool MutexProfiler::compiledIn()
+{
+#ifdef MUDUO_MUTEX_PROFILING
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool MutexProfiler::enable(double stackThresholdSeconds)
+{
+  if (!compiledIn())
+    return false;
+  detail::g_stackThreshold.store(static_cast<int64_t>(stackThresholdSeconds * 1e9));
+  detail::g_mutexProfiling.store(true);
+  return true;
+}
+
+void MutexProfiler::disable()
+{
+  detail::g_mutexProfiling.store(false);
+}
+
+bool MutexProfiler::enabled()
+{
+  return detail::g_mutexProfiling.load();
+}
+
+string MutexProfiler::report()
+{
+  string result;
+  if (!compiledIn())
+  {
+    return "mutex profiling is not built in, rebuild with -DMUDUO_MUTEX_PROFILING\n";
+  }
+  appendf(&result, "mutex profiling %s, stack threshold %" PRId64 " us, times in ns\n",
+          enabled() ? "enabled" : "disabled",
+          detail::g_stackThreshold.load() / 1000);
+
+  std::vector<Report> reports;
+  MCHECK(pthread_mutex_lock(&detail::g_registryMutex));
+  if (detail::g_registry)
+  {
+    for (const auto& it : *detail::g_registry)
+    {
+      Report r = { it.second, it.second->wait.snapshot(), it.second->hold.snapshot() };
+      reports.push_back(r);
+    }
+  }
+  MCHECK(pthread_mutex_unlock(&detail::g_registryMutex));
+  std::sort(reports.begin(), reports.end());
+
+  for (const Report& r : reports)
+  {
+    appendf(&result, "%s: locks %" PRId64 " contended %" PRId64 " total wait %.3f ms\n",
+            r.stats->name.c_str(), r.wait.count(), r.stats->contended.value(),
+            static_cast<double>(r.wait.sum()) / 1e6);
+    result += "  wait " + r.wait.toString() + "\n";
+    result += "  hold " + r.hold.toString() + "\n";
+    appendSlowWaits(&result, r.stats);
+  }
+  return result;
+}
@@ -0,0 +1,42 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_MUTEXPROFILER_H
+#define MUDUO_BASE_MUTEXPROFILER_H
+
+#include "muduo/base/noncopyable.h"
+#include "muduo/base/Types.h"
+
+namespace muduo
+{
+
+///
+/// Contention profile of MutexLock, aggregated by the name of mutex.
+///
+/// Needs building with -DMUDUO_MUTEX_PROFILING (cmake -DMUDUO_MUTEX_PROFILING=ON),
+/// which changes the layout of MutexLock, so the whole program must be built
+/// with it. Then it is off until enable() is called.
+///
+/// When enabled, each lock() records its wait time, and each unlock() the
+/// hold time, into Histograms of the name. A wait longer than the threshold
+/// also keeps the stack of the waiter.
+///
+class MutexProfiler : noncopyable
+{
+ public:
+  static bool compiledIn();
+
+  // Returns false if not compiledIn().
+  static bool enable(double stackThresholdSeconds = 0.001);
+  static void disable();
+  static bool enabled();
+
+  // Sorted by total wait time.
+  static string report();
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_MUTEXPROFILER_H
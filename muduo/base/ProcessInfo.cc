@@ -11,9 +11,11 @@
 
 #include <assert.h>
 #include <dirent.h>
+#include <fcntl.h>
 #include <pwd.h>
 #include <stdio.h> // snprintf
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/resource.h>
 #include <sys/times.h>
@@ -50,6 +52,31 @@ int scanDir(const char *dirpath, int (*filter)(const struct dirent *))
   return result;
 }
 
+// skips the field at p, and the spaces after it
+const char* skipField(const char* p, const char* end)
+{
+  while (p != end && *p != ' ')
+    ++p;
+  while (p != end && *p == ' ')
+    ++p;
+  return p;
+}
+
+const char* parseInt(const char* p, const char* end, int64_t* x)
+{
+  bool negative = p != end && *p == '-';
+  if (negative)
+    ++p;
+  int64_t result = 0;
+  while (p != end && *p >= '0' && *p <= '9')
+  {
+    result = result * 10 + (*p - '0');
+    ++p;
+  }
+  *x = negative ? -result : result;
+  return p;
+}
+
 Timestamp g_startTime = Timestamp::now();
 // assume those won't change during the life time of a process.
 int g_clockTicks = static_cast<int>(::sysconf(_SC_CLK_TCK));
@@ -244,3 +271,122 @@ std::vector<pid_t> ProcessInfo::threads()
   return result;
 }
 
+
+bool ProcessInfo::parseStat(StringPiece content, Stat* stat)
+{
+  // comm may contain spaces and parentheses, fields start after the last ')'
+  const char* end = content.end();
+  const char* p = static_cast<const char*>(::memrchr(content.data(), ')', content.size()));
+  if (p == NULL || end - p < 3)
+    return false;
+  p += 2;
+  memZero(stat, sizeof(*stat));
+  stat->state = *p;
+
+  // field numbers of proc(5) minus 3
+  const int kPpid = 1, kMinflt = 7, kMajflt = 9, kUtime = 11, kStime = 12,
+      kNumThreads = 17, kStarttime = 19, kVsize = 20, kRss = 21, kProcessor = 36;
+  int64_t x = 0;
+  int field = 0;
+  while (field < kProcessor)
+  {
+    p = skipField(p, end);
+    ++field;
+    if (p == end)
+      return false;
+    switch (field)
+    {
+      case kPpid: parseInt(p, end, &x); stat->ppid = static_cast<pid_t>(x); break;
+      case kMinflt: parseInt(p, end, &stat->minflt); break;
+      case kMajflt: parseInt(p, end, &stat->majflt); break;
+      case kUtime: parseInt(p, end, &stat->utime); break;
+      case kStime: parseInt(p, end, &stat->stime); break;
+      case kNumThreads: parseInt(p, end, &stat->numThreads); break;
+      case kStarttime: parseInt(p, end, &stat->starttime); break;
+      case kVsize: parseInt(p, end, &stat->vsize); break;
+      case kRss: parseInt(p, end, &stat->rss); break;
+      case kProcessor: parseInt(p, end, &x); stat->processor = static_cast<int>(x); break;
+      default: break;
+    }
+  }
+  return true;
+}
+
+ProcessInfo::StatSampler::StatSampler()
+{
+}
+
+ProcessInfo::StatSampler::~StatSampler()
+{
+  clear();
+}
+
+int ProcessInfo::StatSampler::open(pid_t pid, pid_t tid, const char* path)
+{
+  int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return -1;
+  Entry entry;
+  memZero(&entry, sizeof entry);
+  entry.fd = fd;
+  entry.pid = pid;
+  entry.tid = tid;
+  entries_.push_back(entry);
+  return size() - 1;
+}
+
+int ProcessInfo::StatSampler::add(pid_t pid)
+{
+  char path[64];
+  snprintf(path, sizeof path, "/proc/%d/stat", pid);
+  return open(pid, 0, path);
+}
+
+int ProcessInfo::StatSampler::add(pid_t pid, pid_t tid)
+{
+  char path[64];
+  snprintf(path, sizeof path, "/proc/%d/task/%d/stat", pid, tid);
+  return open(pid, tid, path);
+}
+
+int ProcessInfo::StatSampler::addThreads(pid_t pid)
+{
+  char path[64];
+  snprintf(path, sizeof path, "/proc/%d/task", pid);
+  std::vector<pid_t> tids;
+  t_pids = &tids;
+  scanDir(path, taskDirFilter);
+  t_pids = NULL;
+  std::sort(tids.begin(), tids.end());
+
+  int added = 0;
+  for (pid_t tid : tids)
+  {
+    if (add(pid, tid) >= 0)
+      ++added;
+  }
+  return added;
+}
+
+void ProcessInfo::StatSampler::clear()
+{
+  for (const Entry& entry : entries_)
+  {
+    ::close(entry.fd);
+  }
+  entries_.clear();
+}
+
+int ProcessInfo::StatSampler::sample()
+{
+  int succeeded = 0;
+  for (Entry& entry : entries_)
+  {
+    // a stat file is generated anew on every read from offset 0
+    ssize_t n = ::pread(entry.fd, buf_, sizeof buf_, 0);
+    entry.valid = n > 0 && parseStat(StringPiece(buf_, static_cast<int>(n)), &entry.stat);
+    if (entry.valid)
+      ++succeeded;
+  }
+  return succeeded;
+}
@@ -8,6 +8,7 @@
 #ifndef MUDUO_BASE_PROCESSINFO_H
 #define MUDUO_BASE_PROCESSINFO_H
 
+#include "muduo/base/noncopyable.h"
 #include "muduo/base/StringPiece.h"
 #include "muduo/base/Types.h"
 #include "muduo/base/Timestamp.h"
@@ -61,6 +62,70 @@ namespace ProcessInfo
 
   int numThreads();
   std::vector<pid_t> threads();
+
+  /// fields of /proc/pid/stat or /proc/pid/task/tid/stat, see proc(5)
+  struct Stat
+  {
+    char state;
+    pid_t ppid;
+    int processor;
+    int64_t minflt;
+    int64_t majflt;
+    int64_t utime;       // in clock ticks
+    int64_t stime;       // in clock ticks
+    int64_t numThreads;
+    int64_t starttime;   // in clock ticks after boot
+    int64_t vsize;       // in bytes
+    int64_t rss;         // in pages
+  };
+
+  /// parses without allocating, returns false if malformed.
+  bool parseStat(StringPiece content, Stat* stat);
+
+  ///
+  /// Samples the stat files of many processes and threads, keeping the
+  /// files open and re-reading them with pread(2) into a fixed buffer.
+  ///
+  /// Not thread safe.
+  class StatSampler : noncopyable
+  {
+   public:
+    StatSampler();
+    ~StatSampler();
+
+    /// returns the index, or -1 if the process or thread does not exist.
+    int add(pid_t pid);
+    int add(pid_t pid, pid_t tid);
+    /// adds every thread of pid, returns how many were added.
+    int addThreads(pid_t pid);
+    void clear();
+
+    int size() const { return static_cast<int>(entries_.size()); }
+    pid_t pid(int index) const { return entries_[index].pid; }
+    pid_t tid(int index) const { return entries_[index].tid; }  // 0 for process
+
+    /// Reads all of them, returns how many succeeded. Failed ones,
+    /// which usually have exited, are no longer valid().
+    int sample();
+
+    bool valid(int index) const { return entries_[index].valid; }
+    const Stat& stat(int index) const { return entries_[index].stat; }
+
+   private:
+    struct Entry
+    {
+      int fd;
+      pid_t pid;
+      pid_t tid;
+      bool valid;
+      Stat stat;
+    };
+
+    int open(pid_t pid, pid_t tid, const char* path);
+
+    std::vector<Entry> entries_;
+    char buf_[4096];
+  };
 }  // namespace ProcessInfo
 
 }  // namespace muduo
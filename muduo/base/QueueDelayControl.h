@@ -0,0 +1,97 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_QUEUEDELAYCONTROL_H
+#define MUDUO_BASE_QUEUEDELAYCONTROL_H
+
+#include "muduo/base/copyable.h"
+#include "muduo/base/Timestamp.h"
+
+#include <stdint.h>
+
+namespace muduo
+{
+
+///
+/// Controlled delay (CoDel) admission for task queues, after
+/// "Controlling Queue Delay", ACM Queue, May 2012.
+///
+/// A queue is overloaded when even the shortest sojourn time seen during
+/// an interval is above target, i.e. it has a standing queue, not a burst.
+/// While overloaded, new tasks are rejected unless the queue is empty,
+/// and queued tasks which have waited longer than target are rejected
+/// when dequeued, most likely their clients have timed out already.
+/// Overload ends when the queue drains or the minimum falls below target.
+///
+/// Not thread safe, guarded by the owner of the queue.
+///
+class QueueDelayControl : public muduo::copyable
+{
+ public:
+  QueueDelayControl()
+    : target_(0),
+      interval_(0),
+      intervalEnd_(0),
+      minDelay_(kNoDelay),
+      overloaded_(false)
+  {
+  }
+
+  // Typical values are 5ms and 100ms, interval should cover the RTT of clients.
+  void setTarget(double targetSeconds, double intervalSeconds)
+  {
+    target_ = static_cast<int64_t>(targetSeconds * Timestamp::kMicroSecondsPerSecond);
+    interval_ = static_cast<int64_t>(intervalSeconds * Timestamp::kMicroSecondsPerSecond);
+  }
+
+  bool enabled() const { return target_ > 0; }
+  bool overloaded() const { return overloaded_; }
+
+  // Returns false if a new task should be rejected.
+  bool admit(bool queueEmpty) const
+  { return !overloaded_ || queueEmpty; }
+
+  // Called when a task is dequeued, times are in microseconds.
+  // Returns false if the task should be rejected.
+  bool dequeue(int64_t enqueueTime, int64_t now)
+  {
+    int64_t delay = now - enqueueTime;
+    if (delay < minDelay_)
+    {
+      minDelay_ = delay;
+    }
+    if (now >= intervalEnd_)
+    {
+      if (intervalEnd_ > 0)
+      {
+        overloaded_ = minDelay_ > target_;
+      }
+      minDelay_ = kNoDelay;
+      intervalEnd_ = now + interval_;
+    }
+    return !overloaded_ || delay <= target_;
+  }
+
+  // Called when the queue drains.
+  void drained()
+  {
+    overloaded_ = false;
+    minDelay_ = kNoDelay;
+    intervalEnd_ = 0;
+  }
+
+ private:
+  static const int64_t kNoDelay = INT64_MAX;
+
+  int64_t target_;
+  int64_t interval_;
+  int64_t intervalEnd_;
+  int64_t minDelay_;
+  bool overloaded_;
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_QUEUEDELAYCONTROL_H
@@ -0,0 +1,25 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/base/ShardedCounter.h"
+
+namespace muduo
+{
+namespace detail
+{
+
+__thread int t_shard = 0;  // index + 1
+
+static_assert((kNumShards & (kNumShards - 1)) == 0, "kNumShards must be power of 2");
+
+int assignShard()
+{
+  static std::atomic<unsigned> next(0);
+  return static_cast<int>(next.fetch_add(1, std::memory_order_relaxed)
+                          & (kNumShards - 1));
+}
+
+}  // namespace detail
+}  // namespace muduo
@@ -0,0 +1,85 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_SHARDEDCOUNTER_H
+#define MUDUO_BASE_SHARDEDCOUNTER_H
+
+#include "muduo/base/noncopyable.h"
+
+#include <atomic>
+
+#include <stdint.h>
+
+namespace muduo
+{
+
+namespace detail
+{
+const int kNumShards = 16;  // must be power of 2
+const int kCacheLineSize = 64;
+
+// Threads take shards in turn on first use, so that up to kNumShards
+// threads never write to the same shard.
+int assignShard();
+extern __thread int t_shard;
+
+inline int shardIndex()
+{
+  if (__builtin_expect(t_shard == 0, 0))
+  {
+    t_shard = assignShard() + 1;
+  }
+  return t_shard - 1;
+}
+}  // namespace detail
+
+///
+/// Counter written by many threads, each writes to its own cache line
+/// and reads sum up all of them.
+///
+class ShardedCounter : noncopyable
+{
+ public:
+  ShardedCounter()
+  {
+    for (Shard& shard : shards_)
+    {
+      shard.value.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void add(int64_t x)
+  {
+    shards_[detail::shardIndex()].value.fetch_add(x, std::memory_order_relaxed);
+  }
+
+  void increment() { add(1); }
+
+  // Not a snapshot, concurrent adds may or may not be counted.
+  int64_t value() const
+  {
+    int64_t sum = 0;
+    for (const Shard& shard : shards_)
+    {
+      sum += shard.value.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+ private:
+  // values of adjacent shards are in different cache lines, alignas()
+  // is not respected by operator new before C++17.
+  struct Shard
+  {
+    std::atomic<int64_t> value;
+    char padding[detail::kCacheLineSize - sizeof(std::atomic<int64_t>)];
+  };
+
+  Shard shards_[detail::kNumShards];
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_SHARDEDCOUNTER_H
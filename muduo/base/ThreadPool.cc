@@ -7,19 +7,41 @@
 
 #include "muduo/base/Exception.h"
 
+#include <algorithm>
+
 #include <assert.h>
 #include <stdio.h>
 
 using namespace muduo;
 
+namespace
+{
+__thread ThreadPool* t_pool;
+}  // namespace
+
 ThreadPool::ThreadPool(const string& nameArg)
-  : mutex_(),
+  : mutex_("ThreadPool"),
     notEmpty_(mutex_),
     notFull_(mutex_),
+    noneStarting_(mutex_),
     name_(nameArg),
+    minThreads_(0),
+    maxThreads_(0),
+    growDelay_(0),
+    idleTimeout_(0),
+    numIdle_(0),
+    numBlocked_(0),
+    numStarting_(0),
+    nextId_(0),
+    seq_(0),
     maxQueueSize_(0),
+    numRejected_(0),
+    numExpired_(0),
     running_(false)
 {
+  slack_[kHighPriority] = 0;
+  slack_[kNormalPriority] = 50 * 1000;
+  slack_[kLowPriority] = 5 * 1000 * 1000;
 }
 
 ThreadPool::~ThreadPool()
@@ -32,18 +54,24 @@ ThreadPool::~ThreadPool()
 
 void ThreadPool::start(int numThreads)
 {
+  {
+  MutexLockGuard lock(mutex_);
   assert(threads_.empty());
   running_ = true;
-  threads_.reserve(numThreads);
+  minThreads_ = numThreads;
+  maxThreads_ = std::max(maxThreads_, numThreads);
+  threads_.reserve(maxThreads_);
+  }
   for (int i = 0; i < numThreads; ++i)
   {
-    char id[32];
-    snprintf(id, sizeof id, "%d", i+1);
-    threads_.emplace_back(new muduo::Thread(
-          std::bind(&ThreadPool::runInThread, this), name_+id));
-    threads_[i]->start();
+    Spawn s;
+    {
+    MutexLockGuard lock(mutex_);
+    prepareSpawn(&s);
+    }
+    spawn(&s);
   }
-  if (numThreads == 0 && threadInitCallback_)
+  if (maxThreads_ == 0 && threadInitCallback_)
   {
     threadInitCallback_();
   }
@@ -51,83 +79,340 @@ void ThreadPool::start(int numThreads)
 
 void ThreadPool::stop()
 {
+  std::vector<std::unique_ptr<muduo::Thread>> threads;
   {
   MutexLockGuard lock(mutex_);
   running_ = false;
   notEmpty_.notifyAll();
   notFull_.notifyAll();
+  // they won't take a task, but must be in threads_ to be joined
+  while (numStarting_ > 0)
+  {
+    noneStarting_.wait();
   }
-  for (auto& thr : threads_)
+  threads.swap(threads_);
+  for (auto& thr : retired_)
+  {
+    threads.push_back(std::move(thr));
+  }
+  retired_.clear();
+  }
+  for (auto& thr : threads)
   {
     thr->join();
   }
 }
 
+int ThreadPool::numThreads() const
+{
+  MutexLockGuard lock(mutex_);
+  return numThreadsLocked();
+}
+
+int ThreadPool::numThreadsLocked() const
+{
+  return static_cast<int>(threads_.size()) + numStarting_;
+}
+
+void ThreadPool::prepareSpawn(Spawn* s)
+{
+  assert(s->id == 0 && s->retired.empty());
+  s->retired.swap(retired_);
+  if (running_)
+  {
+    s->id = ++nextId_;
+    ++numStarting_;
+  }
+}
+
+void ThreadPool::spawn(Spawn* s)
+{
+  // retired threads have returned from runInThread() or are about to
+  for (auto& thr : s->retired)
+  {
+    thr->join();
+  }
+  s->retired.clear();
+  if (s->id == 0)
+  {
+    return;
+  }
+
+  char id[32];
+  snprintf(id, sizeof id, "%d", s->id);
+  std::unique_ptr<muduo::Thread> thr(new muduo::Thread(
+        std::bind(&ThreadPool::runInThread, this), name_+id));
+  thr->start();
+  MutexLockGuard lock(mutex_);
+  threads_.push_back(std::move(thr));
+  if (--numStarting_ == 0)
+  {
+    noneStarting_.notifyAll();
+  }
+}
+
+bool ThreadPool::retire()
+{
+  for (size_t i = 0; i < threads_.size(); ++i)
+  {
+    if (threads_[i]->tid() == CurrentThread::tid())
+    {
+      retired_.push_back(std::move(threads_[i]));
+      threads_.erase(threads_.begin() + i);
+      return true;
+    }
+  }
+  // just started, not in threads_ yet
+  return false;
+}
+
+bool ThreadPool::shouldGrow(int64_t oldest) const
+{
+  if (numIdle_ > 0
+      || maxThreads_ <= minThreads_
+      || numThreadsLocked() >= maxThreads_ + numBlocked_)
+  {
+    return false;
+  }
+  // nobody is going to take it soon
+  if (numBlocked_ >= numThreadsLocked())
+  {
+    return true;
+  }
+  return MonotonicTimestamp::now().microSeconds() - oldest > growDelay_;
+}
+
 size_t ThreadPool::queueSize() const
 {
   MutexLockGuard lock(mutex_);
-  return queue_.size();
+  return queue_.size() + scheduled_.size();
+}
+
+size_t ThreadPool::numRejected() const
+{
+  MutexLockGuard lock(mutex_);
+  return numRejected_;
+}
+
+size_t ThreadPool::numExpired() const
+{
+  MutexLockGuard lock(mutex_);
+  return numExpired_;
 }
 
 void ThreadPool::run(Task task)
 {
-  if (threads_.empty())
+  int64_t now = MonotonicTimestamp::now().microSeconds();
+  put(QueuedTask(std::move(task), Task(), now, now + slack_[kNormalPriority], false), true);
+}
+
+void ThreadPool::run(Task task, Task rejected)
+{
+  if (!delayControl_.enabled())
+  {
+    run(std::move(task));
+    return;
+  }
+
+  int64_t now = MonotonicTimestamp::now().microSeconds();
+  Spawn s;
+  bool inCaller = false;
+  bool admitted = false;
+  {
+  MutexLockGuard lock(mutex_);
+  if (runsInCaller())
+  {
+    inCaller = true;
+  }
+  else
+  {
+    if (!running_) return;
+    admitted = !isFull() && delayControl_.admit(queue_.empty() && scheduled_.empty());
+    if (admitted)
+    {
+      push(QueuedTask(std::move(task), std::move(rejected), now,
+                      now + slack_[kNormalPriority], false), true, &s);
+    }
+    else
+    {
+      ++numRejected_;
+    }
+  }
+  }
+  spawn(&s);
+  if (inCaller)
   {
     task();
   }
+  else if (!admitted && rejected)
+  {
+    rejected();
+  }
+}
+
+void ThreadPool::run(Task task, Priority priority)
+{
+  int64_t now = MonotonicTimestamp::now().microSeconds();
+  put(QueuedTask(std::move(task), Task(), now, now + slack_[priority], false),
+      priority == kNormalPriority);
+}
+
+void ThreadPool::run(Task task, Timestamp deadline)
+{
+  int64_t now = MonotonicTimestamp::now().microSeconds();
+  // to the monotonic clock, which the queue is scheduled in
+  int64_t timeout = deadline.microSecondsSinceEpoch() - Timestamp::now().microSecondsSinceEpoch();
+  put(QueuedTask(std::move(task), Task(), now, now + timeout, true), false);
+}
+
+bool ThreadPool::runsInCaller() const
+{
+  // before start(), or started with no threads, tasks run in the caller.
+  // After stop() they are dropped, unless there never was a thread.
+  return running_ ? maxThreads_ == 0 : nextId_ == 0;
+}
+
+void ThreadPool::put(QueuedTask&& entry, bool fifo)
+{
+  Spawn s;
+  Task task;
+  {
+  MutexLockGuard lock(mutex_);
+  if (runsInCaller())
+  {
+    task = std::move(entry.task);
+  }
   else
   {
-    MutexLockGuard lock(mutex_);
     while (isFull() && running_)
     {
       notFull_.wait();
     }
     if (!running_) return;
     assert(!isFull());
+    push(std::move(entry), fifo, &s);
+  }
+  }
+  spawn(&s);
+  if (task)
+  {
+    task();
+  }
+}
 
-    queue_.push_back(std::move(task));
-    notEmpty_.notify();
+void ThreadPool::push(QueuedTask&& entry, bool fifo, Spawn* s)
+{
+  int64_t enqueueTime = entry.enqueueTime;
+  entry.seq = seq_++;
+  if (fifo)
+  {
+    queue_.push_back(std::move(entry));
+  }
+  else
+  {
+    scheduled_.push_back(std::move(entry));
+    std::push_heap(scheduled_.begin(), scheduled_.end(), Later());
+  }
+  notEmpty_.notify();
+  if (shouldGrow(queue_.empty() ? enqueueTime : queue_.front().enqueueTime))
+  {
+    prepareSpawn(s);
   }
 }
 
-ThreadPool::Task ThreadPool::take()
+ThreadPool::QueuedTask ThreadPool::pop()
 {
-  MutexLockGuard lock(mutex_);
-  // always use a while-loop, due to spurious wakeup
-  while (queue_.empty() && running_)
+  // queue_ is in deadline order as well, merge it with the heap.
+  if (!scheduled_.empty() && (queue_.empty() || Later()(queue_.front(), scheduled_.front())))
   {
-    notEmpty_.wait();
+    std::pop_heap(scheduled_.begin(), scheduled_.end(), Later());
+    QueuedTask entry(std::move(scheduled_.back()));
+    scheduled_.pop_back();
+    return entry;
   }
-  Task task;
-  if (!queue_.empty())
+  QueuedTask entry(std::move(queue_.front()));
+  queue_.pop_front();
+  return entry;
+}
+
+ThreadPool::Task ThreadPool::take(bool* retired, Spawn* s)
+{
+  MutexLockGuard lock(mutex_);
+  while (true)
   {
-    task = queue_.front();
-    queue_.pop_front();
+    // always use a while-loop, due to spurious wakeup
+    while (queue_.empty() && scheduled_.empty() && running_)
+    {
+      delayControl_.drained();
+      ++numIdle_;
+      bool timeout = false;
+      if (maxThreads_ > minThreads_)
+      {
+        timeout = notEmpty_.waitForSeconds(idleTimeout_);
+      }
+      else
+      {
+        notEmpty_.wait();
+      }
+      --numIdle_;
+      if (timeout && queue_.empty() && scheduled_.empty() && running_
+          && numThreadsLocked() > minThreads_ && retire())
+      {
+        *retired = true;
+        return Task();
+      }
+    }
+    if (queue_.empty() && scheduled_.empty())
+    {
+      return Task();
+    }
+
+    QueuedTask entry(pop());
     if (maxQueueSize_ > 0)
     {
       notFull_.notify();
     }
+    int64_t now = MonotonicTimestamp::now().microSeconds();
+    if (entry.expires && entry.deadline < now)
+    {
+      ++numExpired_;
+      continue;
+    }
+    if (!(queue_.empty() && scheduled_.empty()) && shouldGrow(entry.enqueueTime))
+    {
+      prepareSpawn(s);
+    }
+    if (delayControl_.enabled() && !delayControl_.dequeue(entry.enqueueTime, now)
+        && entry.rejected)
+    {
+      ++numRejected_;
+      return std::move(entry.rejected);
+    }
+    return std::move(entry.task);
   }
-  return task;
 }
 
 bool ThreadPool::isFull() const
 {
   mutex_.assertLocked();
-  return maxQueueSize_ > 0 && queue_.size() >= maxQueueSize_;
+  return maxQueueSize_ > 0 && queue_.size() + scheduled_.size() >= maxQueueSize_;
 }
 
 void ThreadPool::runInThread()
 {
+  t_pool = this;
   try
   {
     if (threadInitCallback_)
     {
       threadInitCallback_();
     }
-    while (running_)
+    bool retired = false;
+    while (running_ && !retired)
     {
-      Task task(take());
+      Spawn s;
+      Task task(take(&retired, &s));
+      spawn(&s);
       if (task)
       {
         task();
@@ -154,3 +439,33 @@ void ThreadPool::runInThread()
   }
 }
 
+ThreadPool::BlockingScope::BlockingScope()
+  : pool_(t_pool)
+{
+  if (pool_)
+  {
+    Spawn s;
+    {
+    MutexLockGuard lock(pool_->mutex_);
+    ++pool_->numBlocked_;
+    if (pool_->running_
+        && pool_->numIdle_ == 0
+        && !(pool_->queue_.empty() && pool_->scheduled_.empty())
+        && pool_->maxThreads_ > pool_->minThreads_
+        && pool_->numThreadsLocked() < pool_->maxThreads_ + pool_->numBlocked_)
+    {
+      pool_->prepareSpawn(&s);
+    }
+    }
+    pool_->spawn(&s);
+  }
+}
+
+ThreadPool::BlockingScope::~BlockingScope()
+{
+  if (pool_)
+  {
+    MutexLockGuard lock(pool_->mutex_);
+    --pool_->numBlocked_;
+  }
+}
@@ -8,28 +8,71 @@
 
 #include "muduo/base/Condition.h"
 #include "muduo/base/Mutex.h"
+#include "muduo/base/QueueDelayControl.h"
 #include "muduo/base/Thread.h"
+#include "muduo/base/Timestamp.h"
 #include "muduo/base/Types.h"
+#include "muduo/base/UniqueFunction.h"
 
+#include <atomic>
 #include <deque>
 #include <vector>
 
 namespace muduo
 {
 
+///
+/// Thread pool of fixed size, or elastic if setMaxThreads() is called.
+///
+/// An elastic pool adds a thread when no thread is idle and the task at
+/// the head of the queue has waited longer than the grow delay, or when
+/// a task enters a BlockingScope with tasks pending. Threads blocked in
+/// a BlockingScope don't count towards the maximum. A thread above the
+/// initial number exits after being idle for the idle timeout.
+///
+/// Tasks from run(task) are FIFO. Tasks with a priority or a deadline are
+/// scheduled earliest deadline first, a task of priority p gets a deadline of
+/// its enqueue time plus the slack of p. Plain tasks have kNormalPriority.
+/// So a kLowPriority task waits for kHighPriority tasks queued no later than
+/// slack(kLowPriority) - slack(kHighPriority) after it, and never starves.
+///
 class ThreadPool : noncopyable
 {
  public:
-  typedef std::function<void ()> Task;
+  typedef UniqueFunction<void ()> Task;
+  typedef std::function<void ()> ThreadInitCallback;
+
+  enum Priority
+  {
+    kHighPriority,
+    kNormalPriority,
+    kLowPriority,
+  };
+  static const int kNumPriorities = kLowPriority + 1;
 
   explicit ThreadPool(const string& nameArg = string("ThreadPool"));
   ~ThreadPool();
 
   // Must be called before start().
   void setMaxQueueSize(int maxSize) { maxQueueSize_ = maxSize; }
-  void setThreadInitCallback(const Task& cb)
+  void setThreadInitCallback(const ThreadInitCallback& cb)
   { threadInitCallback_ = cb; }
+  // Enables controlled delay admission, see QueueDelayControl.
+  void setQueueDelayTarget(double targetSeconds, double intervalSeconds)
+  { delayControl_.setTarget(targetSeconds, intervalSeconds); }
+  // Defaults are 0, 50ms and 5s.
+  void setPrioritySlack(Priority priority, double seconds)
+  { slack_[priority] = static_cast<int64_t>(seconds * Timestamp::kMicroSecondsPerSecond); }
+  // Defaults are 10ms and 60s.
+  void setMaxThreads(int maxThreads, double growDelaySeconds = 0.01,
+                     double idleTimeoutSeconds = 60.0)
+  {
+    maxThreads_ = maxThreads;
+    growDelay_ = static_cast<int64_t>(growDelaySeconds * Timestamp::kMicroSecondsPerSecond);
+    idleTimeout_ = idleTimeoutSeconds;
+  }
 
+  // numThreads is the minimum if setMaxThreads() is called.
   void start(int numThreads);
   void stop();
 
@@ -37,29 +80,123 @@ class ThreadPool : noncopyable
   { return name_; }
 
   size_t queueSize() const;
+  size_t numRejected() const;
+  size_t numExpired() const;
+  int numThreads() const;
 
   // Could block if maxQueueSize > 0
+  // Runs f in this thread before start(), or if started with no threads.
   // Call after stop() will return immediately.
-  // There is no move-only version of std::function in C++ as of C++14.
-  // So we don't need to overload a const& and an && versions
-  // as we do in (Bounded)BlockingQueue.
-  // https://stackoverflow.com/a/25408989
+  // Task is move-only, so it is taken by value and moved.
   void run(Task f);
 
+  // With queue delay target set, never blocks. If the pool is overloaded
+  // or full, rejected is called in this thread instead of task.
+  // If task has been queued for too long, rejected is called in the pool.
+  // Tasks from run(Task) are never rejected, but are counted in delay.
+  // Same as run(Task) if no queue delay target is set.
+  void run(Task task, Task rejected);
+
+  // Could block if maxQueueSize > 0, as run(Task).
+  void run(Task task, Priority priority);
+  // Dropped if not started before deadline, counted in numExpired().
+  void run(Task task, Timestamp deadline);
+
+  ///
+  /// Wraps a blocking call in a task, e.g. read(2) or getaddrinfo(3),
+  /// so that an elastic pool adds a thread to run queued tasks meanwhile.
+  /// Does nothing if not in a pool thread.
+  ///
+  class BlockingScope : noncopyable
+  {
+   public:
+    BlockingScope();
+    ~BlockingScope();
+
+   private:
+    ThreadPool* pool_;
+  };
+
  private:
+  struct QueuedTask
+  {
+    QueuedTask(Task&& t, Task&& r, int64_t time, int64_t d, bool e)
+      : task(std::move(t)),
+        rejected(std::move(r)),
+        enqueueTime(time),
+        deadline(d),
+        seq(0),
+        expires(e)
+    {
+    }
+
+    Task task;
+    Task rejected;
+    // of MonotonicTimestamp, immune to steps of the wall clock
+    int64_t enqueueTime;
+    int64_t deadline;  // for scheduling
+    uint64_t seq;      // FIFO among equal deadlines
+    bool expires;
+  };
+
+  // min-heap order
+  struct Later
+  {
+    bool operator()(const QueuedTask& lhs, const QueuedTask& rhs) const
+    {
+      return lhs.deadline > rhs.deadline
+          || (lhs.deadline == rhs.deadline && lhs.seq > rhs.seq);
+    }
+  };
+
+  // A thread to add, decided under mutex_ by prepareSpawn(), then
+  // created by spawn() after unlocking, along with joining the retired.
+  struct Spawn
+  {
+    Spawn() : id(0) {}
+
+    int id;  // 0 if none
+    std::vector<std::unique_ptr<muduo::Thread>> retired;
+  };
+
+  void put(QueuedTask&& entry, bool fifo);
+  void push(QueuedTask&& entry, bool fifo, Spawn* spawn) REQUIRES(mutex_);
+  QueuedTask pop() REQUIRES(mutex_);
   bool isFull() const REQUIRES(mutex_);
+  bool runsInCaller() const REQUIRES(mutex_);
+  int numThreadsLocked() const REQUIRES(mutex_);
+  bool shouldGrow(int64_t oldest) const REQUIRES(mutex_);
+  void prepareSpawn(Spawn* spawn) REQUIRES(mutex_);
+  void spawn(Spawn* spawn) EXCLUDES(mutex_);
+  bool retire() REQUIRES(mutex_);
   void runInThread();
-  Task take();
+  Task take(bool* retired, Spawn* spawn);
 
   mutable MutexLock mutex_;
   Condition notEmpty_ GUARDED_BY(mutex_);
   Condition notFull_ GUARDED_BY(mutex_);
+  Condition noneStarting_ GUARDED_BY(mutex_);
   string name_;
-  Task threadInitCallback_;
-  std::vector<std::unique_ptr<muduo::Thread>> threads_;
-  std::deque<Task> queue_ GUARDED_BY(mutex_);
+  ThreadInitCallback threadInitCallback_;
+  std::vector<std::unique_ptr<muduo::Thread>> threads_ GUARDED_BY(mutex_);
+  std::vector<std::unique_ptr<muduo::Thread>> retired_ GUARDED_BY(mutex_);
+  int minThreads_;
+  int maxThreads_;
+  int64_t growDelay_;
+  double idleTimeout_;
+  int numIdle_ GUARDED_BY(mutex_);
+  int numBlocked_ GUARDED_BY(mutex_);
+  int numStarting_ GUARDED_BY(mutex_);  // being created by spawn()
+  int nextId_ GUARDED_BY(mutex_);
+  std::deque<QueuedTask> queue_ GUARDED_BY(mutex_);  // kNormalPriority
+  std::vector<QueuedTask> scheduled_ GUARDED_BY(mutex_);  // heap of the others
+  uint64_t seq_ GUARDED_BY(mutex_);
   size_t maxQueueSize_;
-  bool running_;
+  int64_t slack_[kNumPriorities];
+  QueueDelayControl delayControl_;  // target set before start(), state guarded by mutex_
+  size_t numRejected_ GUARDED_BY(mutex_);
+  size_t numExpired_ GUARDED_BY(mutex_);
+  std::atomic<bool> running_;
 };
 
 }  // namespace muduo
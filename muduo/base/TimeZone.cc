@@ -81,8 +81,19 @@ inline void fillHMS(unsigned seconds, struct tm* utc)
   utc->tm_hour = minutes / 60;
 }
 
+// Index of the last transition at or before the start of every
+// kSecondsPerYear long span, so that a lookup scans at most the few
+// transitions inside one span, instead of searching all of them.
+struct YearTable
+{
+  time_t start;
+  std::vector<int> lastBefore;  // -1 if before the first transition
+};
+
 }  // namespace detail
 const int kSecondsPerDay = 24*60*60;
+const int kSecondsPerYear = 365*kSecondsPerDay;
+const int kMaxTableYears = 1000;
 }  // namespace muduo
 
 using namespace muduo;
@@ -94,6 +105,8 @@ struct TimeZone::Data
   vector<detail::Localtime> localtimes;
   vector<string> names;
   string abbreviation;
+  detail::YearTable gmtTable;
+  detail::YearTable localTable;
 };
 
 namespace muduo
@@ -222,6 +235,25 @@ bool readTimeZoneFile(const char* zonefile, struct TimeZone::Data* data)
 
 const Localtime* findLocaltime(const TimeZone::Data& data, Transition sentry, Comp comp)
 {
+  const YearTable& table = comp.compareGmt ? data.gmtTable : data.localTable;
+  time_t seconds = comp.compareGmt ? sentry.gmttime : sentry.localtime;
+  if (!table.lastBefore.empty() && seconds >= table.start)
+  {
+    time_t span = (seconds - table.start) / kSecondsPerYear;
+    if (span < static_cast<time_t>(table.lastBefore.size()))
+    {
+      int idx = table.lastBefore[span];
+      const int n = static_cast<int>(data.transitions.size());
+      while (idx + 1 < n && !comp(sentry, data.transitions[idx + 1]))
+      {
+        ++idx;
+      }
+      // FIXME: should be first non dst time zone
+      return idx < 0 ? &data.localtimes.front()
+                     : &data.localtimes[data.transitions[idx].localtimeIdx];
+    }
+  }
+
   const Localtime* local = NULL;
 
   if (data.transitions.empty() || comp(sentry, data.transitions.front()))
@@ -254,6 +286,33 @@ const Localtime* findLocaltime(const TimeZone::Data& data, Transition sentry, Co
   return local;
 }
 
+void buildYearTable(const vector<Transition>& transitions, Comp comp, YearTable* table)
+{
+  table->lastBefore.clear();
+  if (transitions.empty())
+    return;
+
+  time_t first = comp.compareGmt ? transitions.front().gmttime : transitions.front().localtime;
+  time_t last = comp.compareGmt ? transitions.back().gmttime : transitions.back().localtime;
+  time_t years = (last - first) / kSecondsPerYear + 1;
+  if (years > kMaxTableYears)
+    return;
+
+  table->start = first;
+  table->lastBefore.reserve(years);
+  int idx = -1;
+  const int n = static_cast<int>(transitions.size());
+  for (time_t y = 0; y < years; ++y)
+  {
+    Transition sentry(first + y * kSecondsPerYear, first + y * kSecondsPerYear, 0);
+    while (idx + 1 < n && !comp(sentry, transitions[idx + 1]))
+    {
+      ++idx;
+    }
+    table->lastBefore.push_back(idx);
+  }
+}
+
 }  // namespace detail
 }  // namespace muduo
 
@@ -265,6 +324,11 @@ TimeZone::TimeZone(const char* zonefile)
   {
     data_.reset();
   }
+  else
+  {
+    detail::buildYearTable(data_->transitions, detail::Comp(true), &data_->gmtTable);
+    detail::buildYearTable(data_->transitions, detail::Comp(false), &data_->localTable);
+  }
 }
 
 TimeZone::TimeZone(int eastOfUtc, const char* name)
@@ -4,9 +4,11 @@
 // Author: Shuo Chen (chenshuo at chenshuo dot com)
 
 #include "muduo/base/Timestamp.h"
+#include "muduo/base/TscClock.h"
 
 #include <sys/time.h>
 #include <stdio.h>
+#include <time.h>
 
 #ifndef __STDC_FORMAT_MACROS
 #define __STDC_FORMAT_MACROS
@@ -54,9 +56,24 @@ string Timestamp::toFormattedString(bool showMicroseconds) const
 
 Timestamp Timestamp::now()
 {
+  if (TscClock::enabled())
+  {
+    return Timestamp(TscClock::realtimeMicroseconds());
+  }
   struct timeval tv;
   gettimeofday(&tv, NULL);
   int64_t seconds = tv.tv_sec;
   return Timestamp(seconds * kMicroSecondsPerSecond + tv.tv_usec);
 }
 
+MonotonicTimestamp MonotonicTimestamp::now()
+{
+  if (TscClock::enabled())
+  {
+    return MonotonicTimestamp(TscClock::monotonicMicroseconds());
+  }
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  int64_t seconds = ts.tv_sec;
+  return MonotonicTimestamp(seconds * Timestamp::kMicroSecondsPerSecond + ts.tv_nsec / 1000);
+}
@@ -60,7 +60,7 @@ class Timestamp : public muduo::copyable,
   { return static_cast<time_t>(microSecondsSinceEpoch_ / kMicroSecondsPerSecond); }
 
   ///
-  /// Get time of now.
+  /// Get time of now, from TscClock if enabled.
   ///
   static Timestamp now();
   static Timestamp invalid()
@@ -118,6 +118,61 @@ inline Timestamp addTime(Timestamp timestamp, double seconds)
   return Timestamp(timestamp.microSecondsSinceEpoch() + delta);
 }
 
+///
+/// Time stamp since an unspecified point, in microseconds resolution.
+///
+/// Unlike Timestamp, it is not affected by changes of the wall clock,
+/// use it for measuring intervals.
+///
+class MonotonicTimestamp : public muduo::copyable,
+                           public boost::equality_comparable<MonotonicTimestamp>,
+                           public boost::less_than_comparable<MonotonicTimestamp>
+{
+ public:
+  MonotonicTimestamp()
+    : microSeconds_(0)
+  {
+  }
+
+  explicit MonotonicTimestamp(int64_t microSecondsArg)
+    : microSeconds_(microSecondsArg)
+  {
+  }
+
+  bool valid() const { return microSeconds_ > 0; }
+  int64_t microSeconds() const { return microSeconds_; }
+
+  ///
+  /// CLOCK_MONOTONIC, or TscClock if enabled.
+  ///
+  static MonotonicTimestamp now();
+
+ private:
+  int64_t microSeconds_;
+};
+
+inline bool operator<(MonotonicTimestamp lhs, MonotonicTimestamp rhs)
+{
+  return lhs.microSeconds() < rhs.microSeconds();
+}
+
+inline bool operator==(MonotonicTimestamp lhs, MonotonicTimestamp rhs)
+{
+  return lhs.microSeconds() == rhs.microSeconds();
+}
+
+inline double timeDifference(MonotonicTimestamp high, MonotonicTimestamp low)
+{
+  int64_t diff = high.microSeconds() - low.microSeconds();
+  return static_cast<double>(diff) / Timestamp::kMicroSecondsPerSecond;
+}
+
+inline MonotonicTimestamp addTime(MonotonicTimestamp timestamp, double seconds)
+{
+  int64_t delta = static_cast<int64_t>(seconds * Timestamp::kMicroSecondsPerSecond);
+  return MonotonicTimestamp(timestamp.microSeconds() + delta);
+}
+
 }  // namespace muduo
 
 #endif  // MUDUO_BASE_TIMESTAMP_H
@@ -0,0 +1,218 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/base/TscClock.h"
+
+#include <atomic>
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+using namespace muduo;
+
+namespace
+{
+
+#if defined(__x86_64__) || defined(__i386__)
+inline uint64_t readTsc()
+{
+  return __rdtsc();
+}
+
+bool hasInvariantTsc()
+{
+  unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+  if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007)
+    return false;
+  __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+  return (edx & (1u << 8)) != 0;
+}
+#else
+inline uint64_t readTsc()
+{
+  return 0;
+}
+
+bool hasInvariantTsc()
+{
+  return false;
+}
+#endif
+
+int64_t clockNanoseconds(clockid_t clock)
+{
+  struct timespec ts;
+  ::clock_gettime(clock, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000 * 1000 * 1000 + ts.tv_nsec;
+}
+
+// nanoseconds per tick in 32.32 fixed point
+typedef unsigned __int128 uint128;
+
+int64_t ticksToNanoseconds(int64_t ticks, uint64_t mult)
+{
+  if (ticks >= 0)
+    return static_cast<int64_t>((static_cast<uint128>(ticks) * mult) >> 32);
+  else
+    return -static_cast<int64_t>((static_cast<uint128>(-ticks) * mult) >> 32);
+}
+
+struct Params
+{
+  uint64_t tscBase;
+  int64_t realBase;  // ns, CLOCK_REALTIME at tscBase
+  int64_t monoBase;  // ns, continuous across resyncs
+  uint64_t mult;
+};
+
+// A seqlock, written only by who holds g_syncing.
+std::atomic<uint32_t> g_seq(0);
+std::atomic<uint64_t> g_tscBase(0);
+std::atomic<int64_t> g_realBase(0);
+std::atomic<int64_t> g_monoBase(0);
+std::atomic<uint64_t> g_mult(0);
+
+std::atomic<uint64_t> g_resyncTicks(0);
+std::atomic<bool> g_enabled(false);
+std::atomic<bool> g_syncing(false);
+
+// where the rate is measured from, guarded by g_syncing
+uint64_t g_rateTsc;
+int64_t g_rateMono;
+
+Params load()
+{
+  Params p;
+  uint32_t seq;
+  do
+  {
+    seq = g_seq.load(std::memory_order_acquire);
+    p.tscBase = g_tscBase.load(std::memory_order_relaxed);
+    p.realBase = g_realBase.load(std::memory_order_relaxed);
+    p.monoBase = g_monoBase.load(std::memory_order_relaxed);
+    p.mult = g_mult.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((seq & 1) || seq != g_seq.load(std::memory_order_relaxed));
+  return p;
+}
+
+void store(const Params& p)
+{
+  g_seq.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  g_tscBase.store(p.tscBase, std::memory_order_relaxed);
+  g_realBase.store(p.realBase, std::memory_order_relaxed);
+  g_monoBase.store(p.monoBase, std::memory_order_relaxed);
+  g_mult.store(p.mult, std::memory_order_relaxed);
+  g_seq.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t rateMult(uint64_t ticks, int64_t nanoseconds)
+{
+  return static_cast<uint64_t>((static_cast<uint128>(nanoseconds) << 32) / ticks);
+}
+
+void resync()
+{
+  if (g_syncing.exchange(true, std::memory_order_acquire))
+    return;  // someone else is doing it
+
+  Params old = load();
+  Params p;
+  p.tscBase = readTsc();
+  int64_t mono = clockNanoseconds(CLOCK_MONOTONIC);
+  p.realBase = clockNanoseconds(CLOCK_REALTIME);
+  // keep the monotonic clock continuous, let it drift from CLOCK_MONOTONIC
+  p.monoBase = old.monoBase + ticksToNanoseconds(static_cast<int64_t>(p.tscBase - old.tscBase),
+                                                 old.mult);
+  p.mult = p.tscBase > g_rateTsc ? rateMult(p.tscBase - g_rateTsc, mono - g_rateMono) : old.mult;
+  store(p);
+  g_rateTsc = p.tscBase;
+  g_rateMono = mono;
+
+  g_syncing.store(false, std::memory_order_release);
+}
+
+int64_t nowNanoseconds(bool realtime)
+{
+  uint64_t tsc = readTsc();
+  Params p = load();
+  int64_t ticks = static_cast<int64_t>(tsc - p.tscBase);
+  if (ticks > static_cast<int64_t>(g_resyncTicks.load(std::memory_order_relaxed)))
+  {
+    resync();
+    p = load();
+    ticks = static_cast<int64_t>(tsc - p.tscBase);
+  }
+  return (realtime ? p.realBase : p.monoBase) + ticksToNanoseconds(ticks, p.mult);
+}
+
+}  // namespace
+
+bool TscClock::available()
+{
+  static const bool invariant = hasInvariantTsc();
+  return invariant;
+}
+
+bool TscClock::enable(double calibrationSeconds, double resyncSeconds)
+{
+  if (!available())
+    return false;
+
+  while (g_syncing.exchange(true, std::memory_order_acquire))
+  {
+  }
+  uint64_t tsc0 = readTsc();
+  int64_t mono0 = clockNanoseconds(CLOCK_MONOTONIC);
+  int64_t ns = static_cast<int64_t>(calibrationSeconds * 1e9);
+  struct timespec ts = { static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000) };
+  ::nanosleep(&ts, NULL);
+
+  Params p;
+  p.tscBase = readTsc();
+  p.monoBase = clockNanoseconds(CLOCK_MONOTONIC);
+  p.realBase = clockNanoseconds(CLOCK_REALTIME);
+  p.mult = rateMult(p.tscBase - tsc0, p.monoBase - mono0);
+  store(p);
+  g_rateTsc = p.tscBase;
+  g_rateMono = p.monoBase;
+  g_resyncTicks.store(static_cast<uint64_t>(
+      (static_cast<uint128>(static_cast<uint64_t>(resyncSeconds * 1e9)) << 32) / p.mult));
+  g_enabled.store(true, std::memory_order_release);
+
+  g_syncing.store(false, std::memory_order_release);
+  return true;
+}
+
+void TscClock::disable()
+{
+  g_enabled.store(false, std::memory_order_release);
+}
+
+bool TscClock::enabled()
+{
+  return g_enabled.load(std::memory_order_acquire);
+}
+
+double TscClock::ticksPerMicrosecond()
+{
+  uint64_t mult = load().mult;
+  return mult ? 1000.0 * 4294967296.0 / static_cast<double>(mult) : 0.0;
+}
+
+int64_t TscClock::realtimeMicroseconds()
+{
+  return nowNanoseconds(true) / 1000;
+}
+
+int64_t TscClock::monotonicMicroseconds()
+{
+  return nowNanoseconds(false) / 1000;
+}
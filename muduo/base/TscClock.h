@@ -0,0 +1,47 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_TSCCLOCK_H
+#define MUDUO_BASE_TSCCLOCK_H
+
+#include "muduo/base/noncopyable.h"
+
+#include <stdint.h>
+
+namespace muduo
+{
+
+///
+/// Clock source reading the invariant TSC of x86, calibrated against
+/// the system clocks.
+///
+/// Once enabled, Timestamp::now() and MonotonicTimestamp::now() read
+/// the TSC instead of calling into the vDSO. The rate is re-estimated
+/// and the wall clock re-synced every resync interval, lazily by whoever
+/// calls now() first after that, so it follows NTP adjustments and
+/// jumps of the wall clock with at most one interval of delay.
+///
+class TscClock : noncopyable
+{
+ public:
+  // Invariant TSC ticks at constant rate in all power states and is synced
+  // across cores. Always false on other architectures.
+  static bool available();
+
+  // Blocks for calibrationSeconds, returns false if not available().
+  static bool enable(double calibrationSeconds = 0.01, double resyncSeconds = 1.0);
+  static void disable();
+  static bool enabled();
+
+  static double ticksPerMicrosecond();
+
+  // Valid only if enabled().
+  static int64_t realtimeMicroseconds();
+  static int64_t monotonicMicroseconds();
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_TSCCLOCK_H
@@ -0,0 +1,262 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_UNIQUEFUNCTION_H
+#define MUDUO_BASE_UNIQUEFUNCTION_H
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace muduo
+{
+
+namespace detail
+{
+
+template<typename F, typename Signature>
+struct IsCallable;
+
+template<typename F, typename R, typename... Args>
+struct IsCallable<F, R (Args...)>
+{
+  template<typename G>
+  static auto test(int) -> decltype(
+      std::declval<G&>()(std::declval<Args>()...), std::true_type());
+  template<typename G>
+  static std::false_type test(...);
+
+  static const bool value = decltype(test<F>(0))::value;
+};
+
+}  // namespace detail
+
+template<typename Signature, size_t kInlineSize = 64>
+class UniqueFunction;
+
+///
+/// Move-only replacement of std::function, without RTTI.
+///
+/// Callables up to kInlineSize bytes which are nothrow move constructible
+/// are stored inline, larger ones are allocated on heap. Unlike
+/// std::function, it can hold a lambda capturing a std::unique_ptr.
+///
+template<typename R, typename... Args, size_t kInlineSize>
+class UniqueFunction<R (Args...), kInlineSize>
+{
+ public:
+  UniqueFunction() noexcept
+    : ops_(NULL)
+  {
+  }
+
+  UniqueFunction(std::nullptr_t) noexcept  // NOLINT(runtime/explicit)
+    : ops_(NULL)
+  {
+  }
+
+  template<typename F,
+           typename = typename std::enable_if<
+               !std::is_same<typename std::decay<F>::type, UniqueFunction>::value
+               && detail::IsCallable<typename std::decay<F>::type, R (Args...)>::value>::type>
+  UniqueFunction(F&& f)  // NOLINT(runtime/explicit)
+    : ops_(NULL)
+  {
+    typedef typename std::decay<F>::type Functor;
+    if (!isNull(f))
+    {
+      init<Functor>(std::forward<F>(f), std::integral_constant<bool, StoredInline<Functor>::value>());
+    }
+  }
+
+  UniqueFunction(UniqueFunction&& rhs) noexcept
+    : ops_(rhs.ops_)
+  {
+    if (ops_)
+    {
+      ops_->relocate(&rhs.storage_, &storage_);
+      rhs.ops_ = NULL;
+    }
+  }
+
+  UniqueFunction& operator=(UniqueFunction&& rhs) noexcept
+  {
+    if (this != &rhs)
+    {
+      reset();
+      if (rhs.ops_)
+      {
+        rhs.ops_->relocate(&rhs.storage_, &storage_);
+        ops_ = rhs.ops_;
+        rhs.ops_ = NULL;
+      }
+    }
+    return *this;
+  }
+
+  UniqueFunction& operator=(std::nullptr_t) noexcept
+  {
+    reset();
+    return *this;
+  }
+
+  template<typename F>
+  typename std::enable_if<!std::is_same<typename std::decay<F>::type, UniqueFunction>::value,
+                          UniqueFunction&>::type
+  operator=(F&& f)
+  {
+    return *this = UniqueFunction(std::forward<F>(f));
+  }
+
+  UniqueFunction(const UniqueFunction&) = delete;
+  UniqueFunction& operator=(const UniqueFunction&) = delete;
+
+  ~UniqueFunction()
+  {
+    reset();
+  }
+
+  explicit operator bool() const noexcept
+  {
+    return ops_ != NULL;
+  }
+
+  // Like std::function, calls the target as non-const.
+  R operator()(Args... args) const
+  {
+    if (ops_ == NULL)
+    {
+      throw std::bad_function_call();
+    }
+    return ops_->invoke(&storage_, std::forward<Args>(args)...);
+  }
+
+  void swap(UniqueFunction& rhs) noexcept
+  {
+    UniqueFunction tmp(std::move(rhs));
+    rhs = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+ private:
+  struct Ops
+  {
+    R (*invoke)(void* storage, Args&&... args);
+    void (*relocate)(void* from, void* to);  // move constructs to, destroys from
+    void (*destroy)(void* storage);
+  };
+
+  template<typename F>
+  struct StoredInline
+  {
+    static const bool value = sizeof(F) <= kInlineSize
+        && alignof(F) <= alignof(std::max_align_t)
+        && std::is_nothrow_move_constructible<F>::value;
+  };
+
+  template<typename F>
+  struct Inline
+  {
+    static R invoke(void* storage, Args&&... args)
+    {
+      return (*static_cast<F*>(storage))(std::forward<Args>(args)...);
+    }
+
+    static void relocate(void* from, void* to)
+    {
+      F* f = static_cast<F*>(from);
+      new (to) F(std::move(*f));
+      f->~F();
+    }
+
+    static void destroy(void* storage)
+    {
+      static_cast<F*>(storage)->~F();
+    }
+
+    static const Ops ops;
+  };
+
+  template<typename F>
+  struct Heap
+  {
+    static F*& target(void* storage)
+    {
+      return *static_cast<F**>(storage);
+    }
+
+    static R invoke(void* storage, Args&&... args)
+    {
+      return (*target(storage))(std::forward<Args>(args)...);
+    }
+
+    static void relocate(void* from, void* to)
+    {
+      new (to) F*(target(from));
+    }
+
+    static void destroy(void* storage)
+    {
+      delete target(storage);
+    }
+
+    static const Ops ops;
+  };
+
+  template<typename F, typename G>
+  void init(G&& f, std::true_type /* inline */)
+  {
+    new (&storage_) F(std::forward<G>(f));
+    ops_ = &Inline<F>::ops;
+  }
+
+  template<typename F, typename G>
+  void init(G&& f, std::false_type /* inline */)
+  {
+    new (&storage_) F*(new F(std::forward<G>(f)));
+    ops_ = &Heap<F>::ops;
+  }
+
+  template<typename T>
+  static bool isNull(T* f) { return f == NULL; }
+  template<typename S>
+  static bool isNull(const std::function<S>& f) { return !f; }
+  template<typename T>
+  static bool isNull(const T&) { return false; }
+
+  void reset() noexcept
+  {
+    if (ops_)
+    {
+      ops_->destroy(&storage_);
+      ops_ = NULL;
+    }
+  }
+
+  const Ops* ops_;
+  mutable typename std::aligned_storage<kInlineSize, alignof(std::max_align_t)>::type storage_;
+};
+
+template<typename R, typename... Args, size_t kInlineSize>
+template<typename F>
+const typename UniqueFunction<R (Args...), kInlineSize>::Ops
+UniqueFunction<R (Args...), kInlineSize>::Inline<F>::ops =
+{
+  &Inline<F>::invoke, &Inline<F>::relocate, &Inline<F>::destroy
+};
+
+template<typename R, typename... Args, size_t kInlineSize>
+template<typename F>
+const typename UniqueFunction<R (Args...), kInlineSize>::Ops
+UniqueFunction<R (Args...), kInlineSize>::Heap<F>::ops =
+{
+  &Heap<F>::invoke, &Heap<F>::relocate, &Heap<F>::destroy
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_UNIQUEFUNCTION_H
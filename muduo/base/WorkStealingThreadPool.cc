@@ -0,0 +1,338 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/base/WorkStealingThreadPool.h"
+
+#include "muduo/base/Exception.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+using namespace muduo;
+
+namespace
+{
+// the pool and index of the worker running in this thread
+__thread const WorkStealingThreadPool* t_pool;
+__thread int t_index;
+}  // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(const string& nameArg)
+  : mutex_("WorkStealingThreadPool"),
+    notEmpty_(mutex_),
+    name_(nameArg),
+    freeList_(NULL),
+    numIdle_(0),
+    running_(false)
+{
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+  if (running_)
+  {
+    stop();
+  }
+  for (auto& worker : workers_)
+  {
+    while (Node* node = worker->deque.pop())
+    {
+      delete node;
+    }
+    deleteList(worker->freeList);
+  }
+  MutexLockGuard lock(mutex_);
+  for (Node* node : injection_)
+  {
+    delete node;
+  }
+  deleteList(freeList_);
+}
+
+void WorkStealingThreadPool::start(int numThreads)
+{
+  assert(threads_.empty());
+  running_ = true;
+  threads_.reserve(numThreads);
+  workers_.reserve(numThreads);
+  for (int i = 0; i < numThreads; ++i)
+  {
+    workers_.emplace_back(new Worker);
+  }
+  for (int i = 0; i < numThreads; ++i)
+  {
+    char id[32];
+    snprintf(id, sizeof id, "%d", i+1);
+    threads_.emplace_back(new muduo::Thread(
+          std::bind(&WorkStealingThreadPool::runInThread, this, i), name_+id));
+    threads_[i]->start();
+  }
+  if (numThreads == 0 && threadInitCallback_)
+  {
+    threadInitCallback_();
+  }
+}
+
+void WorkStealingThreadPool::stop()
+{
+  {
+  MutexLockGuard lock(mutex_);
+  running_ = false;
+  notEmpty_.notifyAll();
+  }
+  for (auto& thr : threads_)
+  {
+    thr->join();
+  }
+}
+
+size_t WorkStealingThreadPool::queueSize() const
+{
+  size_t size = 0;
+  for (const auto& worker : workers_)
+  {
+    size += worker->deque.size();
+  }
+  MutexLockGuard lock(mutex_);
+  return size + injection_.size();
+}
+
+void WorkStealingThreadPool::run(Task task)
+{
+  if (threads_.empty())
+  {
+    task();
+    return;
+  }
+  if (!running_)
+    return;
+
+  if (t_pool == this)
+  {
+    Worker* worker = workers_[t_index].get();
+    Node* node = worker->freeList;
+    if (node)
+    {
+      worker->freeList = node->next;
+      --worker->numFree;
+    }
+    else
+    {
+      MutexLockGuard lock(mutex_);
+      node = newNodeLocked();
+    }
+    node->task = std::move(task);
+    if (worker->deque.push(node))
+    {
+      // pairs with numIdle_.fetch_add() before hasTask() in runInThread()
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (numIdle_.load(std::memory_order_relaxed) > 0)
+      {
+        MutexLockGuard lock(mutex_);
+        notEmpty_.notify();
+      }
+    }
+    else
+    {
+      MutexLockGuard lock(mutex_);
+      injection_.push_back(node);
+      notEmpty_.notify();
+    }
+  }
+  else
+  {
+    MutexLockGuard lock(mutex_);
+    Node* node = newNodeLocked();
+    node->task = std::move(task);
+    injection_.push_back(node);
+    notEmpty_.notify();
+  }
+}
+
+void WorkStealingThreadPool::runBatch(std::vector<Task>* tasks)
+{
+  if (threads_.empty())
+  {
+    for (Task& task : *tasks)
+    {
+      task();
+    }
+    tasks->clear();
+    return;
+  }
+  if (!running_ || tasks->empty())
+  {
+    tasks->clear();
+    return;
+  }
+
+  MutexLockGuard lock(mutex_);
+  for (Task& task : *tasks)
+  {
+    Node* node = newNodeLocked();
+    node->task = std::move(task);
+    injection_.push_back(node);
+  }
+  if (tasks->size() > 1)
+  {
+    notEmpty_.notifyAll();
+  }
+  else
+  {
+    notEmpty_.notify();
+  }
+  tasks->clear();
+}
+
+WorkStealingThreadPool::Node* WorkStealingThreadPool::newNodeLocked()
+{
+  Node* node = freeList_;
+  if (node)
+  {
+    freeList_ = node->next;
+  }
+  else
+  {
+    node = new Node;
+  }
+  return node;
+}
+
+void WorkStealingThreadPool::recycle(Worker* worker, Node* node)
+{
+  node->next = worker->freeList;
+  worker->freeList = node;
+  if (++worker->numFree > kMaxFreePerWorker)
+  {
+    // give half to threads outside the pool, which take from freeList_
+    Node* head = worker->freeList;
+    Node* tail = head;
+    for (int i = 1; i < kMaxFreePerWorker / 2; ++i)
+    {
+      tail = tail->next;
+    }
+    worker->freeList = tail->next;
+    worker->numFree -= kMaxFreePerWorker / 2;
+    MutexLockGuard lock(mutex_);
+    tail->next = freeList_;
+    freeList_ = head;
+  }
+}
+
+void WorkStealingThreadPool::deleteList(Node* head)
+{
+  while (head)
+  {
+    Node* next = head->next;
+    delete head;
+    head = next;
+  }
+}
+
+WorkStealingThreadPool::Node* WorkStealingThreadPool::findTask(int index)
+{
+  Node* node = workers_[index]->deque.pop();
+  if (node == NULL)
+  {
+    node = takeFromInjection(index);
+  }
+  const int n = static_cast<int>(workers_.size());
+  for (int i = 1; i < n && node == NULL; ++i)
+  {
+    node = workers_[(index + i) % n]->deque.steal();
+  }
+  return node;
+}
+
+WorkStealingThreadPool::Node* WorkStealingThreadPool::takeFromInjection(int index)
+{
+  MutexLockGuard lock(mutex_);
+  if (injection_.empty())
+    return NULL;
+
+  Node* node = injection_.front();
+  injection_.pop_front();
+  // take a fair share into own deque, so that next ones are lock free,
+  // and idle workers could steal them.
+  size_t share = injection_.size() / threads_.size();
+  size_t batch = std::min(share, static_cast<size_t>(kInjectionBatch));
+  Deque* deque = &workers_[index]->deque;
+  size_t moved = 0;
+  while (moved < batch && deque->push(injection_.front()))
+  {
+    injection_.pop_front();
+    ++moved;
+  }
+  if (moved > 0 && numIdle_.load() > 0)
+  {
+    notEmpty_.notify();
+  }
+  return node;
+}
+
+bool WorkStealingThreadPool::hasTask() const
+{
+  for (const auto& worker : workers_)
+  {
+    if (worker->deque.size() > 0)
+      return true;
+  }
+  return false;
+}
+
+void WorkStealingThreadPool::runInThread(int index)
+{
+  t_pool = this;
+  t_index = index;
+  Worker* worker = workers_[index].get();
+  try
+  {
+    if (threadInitCallback_)
+    {
+      threadInitCallback_();
+    }
+    while (running_)
+    {
+      Node* node = findTask(index);
+      if (node)
+      {
+        node->task();
+        node->task = nullptr;  // releases what it captures, in this thread
+        recycle(worker, node);
+      }
+      else
+      {
+        numIdle_.fetch_add(1);
+        {
+        MutexLockGuard lock(mutex_);
+        // always use a while-loop, due to spurious wakeup
+        while (running_ && injection_.empty() && !hasTask())
+        {
+          notEmpty_.wait();
+        }
+        }
+        numIdle_.fetch_sub(1);
+      }
+    }
+  }
+  catch (const Exception& ex)
+  {
+    fprintf(stderr, "exception caught in WorkStealingThreadPool %s\n", name_.c_str());
+    fprintf(stderr, "reason: %s\n", ex.what());
+    fprintf(stderr, "stack trace: %s\n", ex.stackTrace());
+    abort();
+  }
+  catch (const std::exception& ex)
+  {
+    fprintf(stderr, "exception caught in WorkStealingThreadPool %s\n", name_.c_str());
+    fprintf(stderr, "reason: %s\n", ex.what());
+    abort();
+  }
+  catch (...)
+  {
+    fprintf(stderr, "unknown exception caught in WorkStealingThreadPool %s\n", name_.c_str());
+    throw; // rethrow
+  }
+}
@@ -0,0 +1,209 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_WORKSTEALINGTHREADPOOL_H
+#define MUDUO_BASE_WORKSTEALINGTHREADPOOL_H
+
+#include "muduo/base/Condition.h"
+#include "muduo/base/Mutex.h"
+#include "muduo/base/Thread.h"
+#include "muduo/base/Types.h"
+#include "muduo/base/UniqueFunction.h"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace muduo
+{
+
+namespace detail
+{
+
+// Chase-Lev deque of fixed capacity, after
+// "Correct and Efficient Work-Stealing for Weak Memory Models", PPoPP'13.
+// push() and pop() are called by the owner only, steal() by anyone.
+template<typename T>
+class WorkStealingDeque : noncopyable
+{
+ public:
+  explicit WorkStealingDeque(int capacity)
+    : top_(0),
+      bottom_(0),
+      mask_(capacity - 1),
+      buffer_(new std::atomic<T*>[capacity])
+  {
+    assert(capacity > 0 && (capacity & mask_) == 0);
+  }
+
+  // return false if full
+  bool push(T* x)
+  {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    if (b - t > mask_)
+      return false;
+    buffer_[b & mask_].store(x, std::memory_order_relaxed);
+    bottom_.store(b + 1, std::memory_order_release);
+    return true;
+  }
+
+  // LIFO, return NULL if empty
+  T* pop()
+  {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    T* x = NULL;
+    if (t <= b)
+    {
+      x = buffer_[b & mask_].load(std::memory_order_relaxed);
+      if (t == b)
+      {
+        // the last one, race against steal()
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed))
+        {
+          x = NULL;
+        }
+        bottom_.store(b + 1, std::memory_order_relaxed);
+      }
+    }
+    else
+    {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return x;
+  }
+
+  // FIFO, return NULL if empty or lost the race
+  T* steal()
+  {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    T* x = NULL;
+    if (t < b)
+    {
+      x = buffer_[t & mask_].load(std::memory_order_relaxed);
+      if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed))
+      {
+        x = NULL;
+      }
+    }
+    return x;
+  }
+
+  // approximate
+  size_t size() const
+  {
+    int64_t n = bottom_.load() - top_.load();
+    return n > 0 ? static_cast<size_t>(n) : 0;
+  }
+
+ private:
+  // top_ and bottom_ are written by different threads, keep them apart.
+  std::atomic<int64_t> top_;
+  char pad_[64 - sizeof(std::atomic<int64_t>)] __attribute__((unused));
+  std::atomic<int64_t> bottom_;
+  const int64_t mask_;
+  std::unique_ptr<std::atomic<T*>[]> buffer_;
+};
+
+}  // namespace detail
+
+///
+/// Thread pool with a Chase-Lev deque per worker and a global injection queue.
+///
+/// Tasks run() from a worker go to its own deque without locking,
+/// tasks from other threads go to the injection queue, which idle workers
+/// drain in batches into their deques. Idle workers steal from busy ones.
+/// There is no FIFO order among tasks, nor any bound on queue size.
+///
+/// Tasks are move-only, each is queued in a node recycled through
+/// the free list of the worker which ran it, no allocation once warmed up.
+///
+class WorkStealingThreadPool : noncopyable
+{
+ public:
+  typedef UniqueFunction<void ()> Task;
+  typedef std::function<void ()> ThreadInitCallback;
+
+  explicit WorkStealingThreadPool(const string& nameArg = string("WorkStealingPool"));
+  ~WorkStealingThreadPool();
+
+  // Must be called before start().
+  void setThreadInitCallback(const ThreadInitCallback& cb)
+  { threadInitCallback_ = cb; }
+
+  void start(int numThreads);
+  // Pending tasks are discarded.
+  void stop();
+
+  const string& name() const
+  { return name_; }
+
+  // approximate
+  size_t queueSize() const;
+
+  // Never blocks. Call after stop() will return immediately.
+  void run(Task task);
+  // Submits all tasks with one lock, tasks is cleared.
+  void runBatch(std::vector<Task>* tasks);
+
+ private:
+  struct Node
+  {
+    Task task;
+    Node* next;  // in a free list
+  };
+
+  typedef detail::WorkStealingDeque<Node> Deque;
+
+  // freeList is used by the worker thread only, others steal from deque.
+  struct Worker
+  {
+    Worker()
+      : deque(kDequeCapacity),
+        freeList(NULL),
+        numFree(0)
+    {
+    }
+
+    Deque deque;
+    Node* freeList;
+    int numFree;
+  };
+
+  void runInThread(int index);
+  Node* findTask(int index);
+  Node* takeFromInjection(int index);
+  bool hasTask() const;
+  Node* newNodeLocked() REQUIRES(mutex_);
+  void recycle(Worker* worker, Node* node);
+  static void deleteList(Node* head);
+
+  static const int kDequeCapacity = 4096;
+  static const int kInjectionBatch = 32;
+  static const int kMaxFreePerWorker = 256;  // the rest goes to freeList_
+
+  mutable MutexLock mutex_;
+  Condition notEmpty_ GUARDED_BY(mutex_);
+  string name_;
+  ThreadInitCallback threadInitCallback_;
+  std::vector<std::unique_ptr<muduo::Thread>> threads_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::deque<Node*> injection_ GUARDED_BY(mutex_);
+  Node* freeList_ GUARDED_BY(mutex_);
+  std::atomic<int> numIdle_;
+  std::atomic<bool> running_;
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_WORKSTEALINGTHREADPOOL_H
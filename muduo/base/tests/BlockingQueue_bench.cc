@@ -1,4 +1,6 @@
 #include "muduo/base/BlockingQueue.h"
+#include "muduo/base/BoundedBlockingQueue.h"
+#include "muduo/base/BoundedLockFreeQueue.h"
 #include "muduo/base/CountDownLatch.h"
 #include "muduo/base/Thread.h"
 #include "muduo/base/Timestamp.h"
@@ -96,6 +98,54 @@ class Bench
   std::vector<std::unique_ptr<muduo::Thread>> threads_;
 };
 
+// Passes kMessages small messages from producers to consumers.
+template<typename Queue>
+void throughput(const char* name, Queue* queue, int producers, int consumers)
+{
+  const int kMessages = 1000*1000;
+  std::vector<std::unique_ptr<muduo::Thread>> threads;
+  for (int i = 0; i < consumers; ++i)
+  {
+    threads.emplace_back(new muduo::Thread([queue]
+    {
+      while (queue->take() >= 0)
+      {
+      }
+    }));
+  }
+  for (int i = 0; i < producers; ++i)
+  {
+    threads.emplace_back(new muduo::Thread([queue, producers]
+    {
+      for (int j = 0; j < kMessages / producers; ++j)
+      {
+        queue->put(j);
+      }
+    }));
+  }
+
+  muduo::Timestamp start(muduo::Timestamp::now());
+  for (auto& thr : threads)
+  {
+    thr->start();
+  }
+  for (int i = 0; i < producers; ++i)
+  {
+    threads[consumers + i]->join();
+  }
+  for (int i = 0; i < consumers; ++i)
+  {
+    queue->put(-1);
+  }
+  for (int i = 0; i < consumers; ++i)
+  {
+    threads[i]->join();
+  }
+  double seconds = timeDifference(muduo::Timestamp::now(), start);
+  printf("%-22s %2d producers %2d consumers %8.3f seconds %12.0f msg/s\n",
+         name, producers, consumers, seconds, kMessages / seconds);
+}
+
 int main(int argc, char* argv[])
 {
   int threads = argc > 1 ? atoi(argv[1]) : 1;
@@ -103,4 +153,16 @@ int main(int argc, char* argv[])
   Bench t(threads);
   t.run(10000);
   t.joinAll();
+
+  const int kCapacity = 1024;
+  const int numThreads[] = { 1, 4, 16 };
+  for (int n : numThreads)
+  {
+    muduo::BlockingQueue<int> q1;
+    throughput("BlockingQueue", &q1, n, n);
+    muduo::BoundedBlockingQueue<int> q2(kCapacity);
+    throughput("BoundedBlockingQueue", &q2, n, n);
+    muduo::BoundedLockFreeQueue<int> q3(kCapacity);
+    throughput("BoundedLockFreeQueue", &q3, n, n);
+  }
 }
@@ -0,0 +1,93 @@
+#undef NDEBUG
+#include "muduo/base/BoundedLockFreeQueue.h"
+#include "muduo/base/Thread.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+void testSingleThread()
+{
+  muduo::BoundedLockFreeQueue<std::string> queue(5);
+  assert(queue.capacity() == 8);
+  assert(queue.empty());
+  for (int i = 0; i < 8; ++i)
+  {
+    queue.put(std::to_string(i));
+  }
+  assert(queue.full());
+  assert(queue.size() == 8);
+  std::string x("overflow");
+  bool ok = queue.tryPut(std::move(x));
+  assert(!ok && x == "overflow");
+  for (int i = 0; i < 8; ++i)
+  {
+    x = queue.take();
+    assert(x == std::to_string(i));
+  }
+  assert(queue.empty());
+  ok = queue.tryTake(&x);
+  assert(!ok);
+}
+
+// every producer puts 1..kCount, consumers sum them up.
+void testMultiThreads(int producers, int consumers)
+{
+  printf("testMultiThreads %d producers, %d consumers\n", producers, consumers);
+  const int64_t kCount = 100*1000;
+  muduo::BoundedLockFreeQueue<int64_t> queue(64);
+  std::atomic<int64_t> sum(0);
+  std::vector<std::unique_ptr<muduo::Thread>> threads;
+  for (int i = 0; i < consumers; ++i)
+  {
+    threads.emplace_back(new muduo::Thread([&queue, &sum]
+    {
+      int64_t local = 0;
+      int64_t x = 0;
+      while ((x = queue.take()) > 0)
+      {
+        local += x;
+      }
+      sum += local;
+    }));
+  }
+  for (int i = 0; i < producers; ++i)
+  {
+    threads.emplace_back(new muduo::Thread([&queue, kCount]
+    {
+      for (int64_t x = 1; x <= kCount; ++x)
+      {
+        queue.put(x);
+      }
+    }));
+  }
+  for (auto& thr : threads)
+  {
+    thr->start();
+  }
+  for (int i = 0; i < producers; ++i)
+  {
+    threads[consumers + i]->join();
+  }
+  for (int i = 0; i < consumers; ++i)
+  {
+    queue.put(0);
+  }
+  for (int i = 0; i < consumers; ++i)
+  {
+    threads[i]->join();
+  }
+  assert(sum == producers * kCount * (kCount + 1) / 2);
+  assert(queue.empty());
+}
+
+int main()
+{
+  testSingleThread();
+  testMultiThreads(1, 1);
+  testMultiThreads(4, 1);
+  testMultiThreads(1, 4);
+  testMultiThreads(4, 4);
+  printf("PASSED\n");
+}
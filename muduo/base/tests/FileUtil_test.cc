@@ -26,5 +26,26 @@ int main()
   printf("%d %zd %" PRIu64 "\n", err, result.size(), size);
   err = FileUtil::readFile("/dev/zero", 102400, &result, NULL);
   printf("%d %zd %" PRIu64 "\n", err, result.size(), size);
+
+  FileUtil::MappedFile empty("/dev/null");
+  printf("%d %zd\n", empty.error(), empty.size());
+  FileUtil::MappedFile notexist("/notexist");
+  printf("%d %zd\n", notexist.error(), notexist.size());
+
+  FileUtil::MappedFile mapped("/etc/services");
+  mapped.advise(FileUtil::MappedFile::kSequential);
+  printf("%d %zd hugepage %d\n", mapped.error(), mapped.size(), mapped.adviseHugePage());
+  std::vector<FileUtil::MappedFile::Range> ranges = mapped.split(4);
+  for (const auto& r : ranges)
+  {
+    int lines = 0;
+    StringPiece line;
+    FileUtil::LineIterator it(r);
+    while (it.next(&line))
+    {
+      ++lines;
+    }
+    printf("%zd bytes %d lines\n", r.end - r.begin, lines);
+  }
 }
 
@@ -0,0 +1,78 @@
+#undef NDEBUG
+#include "muduo/base/FlightRecorder.h"
+#include "muduo/base/Thread.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+using muduo::string;
+
+int count(const string& str, const char* pattern)
+{
+  int n = 0;
+  for (size_t pos = str.find(pattern); pos != string::npos; pos = str.find(pattern, pos + 1))
+  {
+    ++n;
+  }
+  return n;
+}
+
+void threadFunc()
+{
+  for (int i = 0; i < 10; ++i)
+  {
+    RECORD_TRACE("in thread", i);
+  }
+}
+
+int main()
+{
+  muduo::Logger::setLogLevel(muduo::Logger::INFO);
+  assert(muduo::FlightRecorder::dumpToString().empty());
+
+  RECORD_DEBUG("no args");
+  RECORD_DEBUG("one arg", 42);
+  RECORD_TRACE("two args", -1, 1234567890123LL);
+  string dump = muduo::FlightRecorder::dumpToString();
+  printf("%s", dump.c_str());
+  assert(count(dump, "flight recorder of thread") == 1);
+  assert(count(dump, "DEBUG no args - FlightRecorder_unittest.cc:") == 1);
+  assert(count(dump, "DEBUG one arg 42 - ") == 1);
+  assert(count(dump, "TRACE two args -1 1234567890123 - ") == 1);
+
+  // recorded in ticks, dumped in wall clock time
+  string before = muduo::Timestamp::now().toFormattedString(false);
+  RECORD_DEBUG("timed");
+  dump = muduo::FlightRecorder::dumpToString();
+  string after = muduo::Timestamp::now().toFormattedString(false);
+  size_t timed = dump.find("DEBUG timed");
+  assert(timed != string::npos);
+  string time = dump.substr(dump.rfind('\n', timed) + 1, before.size());
+  assert(time == before || time == after);
+
+  // ring keeps the latest kRecordsPerThread records
+  for (int i = 0; i < 10000; ++i)
+  {
+    RECORD_TRACE("loop", i);
+  }
+  dump = muduo::FlightRecorder::dumpToString();
+  assert(count(dump, "TRACE loop") == muduo::FlightRecorder::kRecordsPerThread);
+  assert(count(dump, "TRACE loop 9999 ") == 1);
+  assert(count(dump, "two args") == 0);
+
+  muduo::Thread t1(threadFunc, "recorder1");
+  t1.start();
+  t1.join();
+  dump = muduo::FlightRecorder::dumpToString();
+  assert(count(dump, "recorder1 (exited), 10 of 10 records") == 1);
+
+  // a new thread reuses the ring of an exited one
+  muduo::Thread t2(threadFunc, "recorder2");
+  t2.start();
+  t2.join();
+  dump = muduo::FlightRecorder::dumpToString();
+  assert(count(dump, "recorder1") == 0);
+  assert(count(dump, "in thread 9 ") == 1);
+  printf("PASSED\n");
+}
@@ -0,0 +1,54 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// Replaces the global operator new and delete with ones counting heap
+// usage, for tests and benchmarks of allocations.
+// Include it in one source file of a program only.
+
+#ifndef MUDUO_BASE_TESTS_HEAPCOUNTER_H
+#define MUDUO_BASE_TESTS_HEAPCOUNTER_H
+
+#include <atomic>
+#include <malloc.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <new>
+
+std::atomic<int64_t> g_heapAllocations(0);  // calls of operator new
+std::atomic<int64_t> g_heapBlocks(0);       // in use
+std::atomic<int64_t> g_heapBytes(0);        // in use, including malloc overhead
+
+void* operator new(size_t size)
+{
+  void* p = ::malloc(size);
+  if (p == NULL)
+  {
+    throw std::bad_alloc();
+  }
+  g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+  g_heapBlocks.fetch_add(1, std::memory_order_relaxed);
+  g_heapBytes.fetch_add(static_cast<int64_t>(::malloc_usable_size(p)),
+                        std::memory_order_relaxed);
+  return p;
+}
+
+void operator delete(void* p) noexcept
+{
+  if (p)
+  {
+    g_heapBlocks.fetch_sub(1, std::memory_order_relaxed);
+    g_heapBytes.fetch_sub(static_cast<int64_t>(::malloc_usable_size(p)),
+                          std::memory_order_relaxed);
+    ::free(p);
+  }
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+  ::operator delete(p);
+}
+
+#endif  // MUDUO_BASE_TESTS_HEAPCOUNTER_H
@@ -0,0 +1,95 @@
+#undef NDEBUG
+#include "muduo/base/Histogram.h"
+#include "muduo/base/Thread.h"
+
+#include <memory>
+#include <vector>
+
+#include <assert.h>
+#include <stdio.h>
+
+using muduo::Histogram;
+
+void testBuckets()
+{
+  printf("testBuckets\n");
+  for (int i = 0; i < Histogram::kNumBuckets; ++i)
+  {
+    int64_t lower = Histogram::bucketLowerBound(i);
+    int64_t upper = Histogram::bucketUpperBound(i);
+    assert(lower <= upper);
+    assert(Histogram::bucketIndex(lower) == i);
+    assert(Histogram::bucketIndex(upper) == i);
+    if (i > 0)
+    {
+      assert(Histogram::bucketUpperBound(i - 1) + 1 == lower);
+    }
+    // relative error
+    assert(static_cast<double>(upper - lower) <= static_cast<double>(lower) / Histogram::kSubBuckets);
+    (void) lower;
+    (void) upper;
+  }
+  assert(Histogram::bucketIndex(-1) == 0);
+  assert(Histogram::bucketIndex(INT64_MAX) == Histogram::kNumBuckets - 1);
+}
+
+void testPercentile()
+{
+  printf("testPercentile\n");
+  Histogram h;
+  assert(h.snapshot().count() == 0);
+  assert(h.snapshot().percentile(99) == 0);
+  for (int i = 1; i <= 1000; ++i)
+  {
+    h.record(i);
+  }
+  Histogram::Snapshot s = h.snapshot();
+  printf("%s\n", s.toString().c_str());
+  assert(s.count() == 1000);
+  assert(s.sum() == 500500);
+  assert(s.percentile(50) >= 500 && s.percentile(50) <= 500 + 500 / Histogram::kSubBuckets);
+  assert(s.percentile(99) >= 990 && s.percentile(99) <= 990 + 990 / Histogram::kSubBuckets);
+  assert(s.max() >= 1000 && s.max() <= 1000 + 1000 / Histogram::kSubBuckets);
+  assert(s.percentile(0) == 1);
+
+  Histogram h2;
+  h2.record(1000 * 1000);
+  s.merge(h2.snapshot());
+  assert(s.count() == 1001);
+  assert(s.max() >= 1000 * 1000);
+}
+
+void testThreads()
+{
+  printf("testThreads\n");
+  Histogram h;
+  const int kThreads = 20;  // more than shards
+  const int kRecords = 100 * 1000;
+  std::vector<std::unique_ptr<muduo::Thread>> threads;
+  for (int i = 0; i < kThreads; ++i)
+  {
+    threads.emplace_back(new muduo::Thread([&h, i] {
+      for (int j = 0; j < kRecords; ++j)
+      {
+        h.record(i);
+      }
+    }));
+    threads.back()->start();
+  }
+  for (auto& thr : threads)
+  {
+    thr->join();
+  }
+  Histogram::Snapshot s = h.snapshot();
+  assert(s.count() == kThreads * kRecords);
+  assert(s.max() == kThreads - 1);
+  printf("%s\n", s.toString().c_str());
+}
+
+int main()
+{
+  testBuckets();
+  testPercentile();
+  testThreads();
+  printf("PASSED\n");
+}
@@ -0,0 +1,99 @@
+#include "muduo/base/LogCompressor.h"
+
+#include "muduo/base/GzipFile.h"
+#include "muduo/base/Logging.h"
+#include "muduo/base/Timestamp.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace muduo;
+
+string makeLogFile(const char* filename, int lines)
+{
+  string content;
+  FILE* fp = ::fopen(filename, "we");
+  for (int i = 0; i < lines; ++i)
+  {
+    char line[128];
+    snprintf(line, sizeof line, "%s line %d 1234567890 abcdefghijklmnopqrstuvwxyz\n",
+             Timestamp::now().toFormattedString().c_str(), i);
+    content += line;
+    fputs(line, fp);
+  }
+  fclose(fp);
+  return content;
+}
+
+string readGzip(const string& filename)
+{
+  string content;
+  GzipFile reader = GzipFile::openForRead(filename);
+  if (reader.valid())
+  {
+    char buf[64*1024];
+    int nr = 0;
+    while ((nr = reader.read(buf, sizeof buf)) > 0)
+    {
+      content.append(buf, nr);
+    }
+  }
+  return content;
+}
+
+void check(const string& filename, const string& expected)
+{
+  string gzname = filename + ".gz";
+  if (::access(filename.c_str(), F_OK) == 0 || readGzip(gzname) != expected)
+  {
+    printf("FAILED %s\n", gzname.c_str());
+    abort();
+  }
+  ::unlink(gzname.c_str());
+}
+
+int main()
+{
+  const char* filename = "/tmp/logcompressor_test.log";
+  const int kLines = 100*1000;
+
+  {
+  printf("testing inline compression\n");
+  string content = makeLogFile(filename, kLines);
+  LogCompressor compressor(0);
+  compressor.setChunkSize(64*1024);
+  if (!compressor.compressFile(filename))
+  {
+    printf("FAILED\n");
+    abort();
+  }
+  check(filename, content);
+  LOG_INFO << compressor.inputBytes() << " -> " << compressor.outputBytes();
+  }
+
+  {
+  printf("testing parallel compression\n");
+  LogCompressor compressor(3);
+  compressor.setChunkSize(100*1000);
+  compressor.setLevel(1);
+  compressor.start();
+  std::vector<string> contents;
+  for (int i = 0; i < 3; ++i)
+  {
+    char name[64];
+    snprintf(name, sizeof name, "%s.%d", filename, i);
+    contents.push_back(makeLogFile(name, kLines + i * 1000));
+    compressor.compress(name);
+  }
+  compressor.stop();
+  for (int i = 0; i < 3; ++i)
+  {
+    char name[64];
+    snprintf(name, sizeof name, "%s.%d", filename, i);
+    check(name, contents[i]);
+  }
+  LOG_INFO << compressor.filesCompressed() << " files "
+           << compressor.inputBytes() << " -> " << compressor.outputBytes();
+  }
+  printf("PASSED\n");
+}
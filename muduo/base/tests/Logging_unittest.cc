@@ -0,0 +1,91 @@
+#undef NDEBUG
+#include "muduo/base/Logging.h"
+#include "muduo/base/CurrentThread.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+using muduo::string;
+
+int g_lines;
+string g_last;
+
+void countOutput(const char* msg, int len)
+{
+  ++g_lines;
+  g_last.assign(msg, len);
+}
+
+void logEveryN(int times, int n)
+{
+  g_lines = 0;
+  for (int i = 0; i < times; ++i)
+  {
+    LOG_EVERY_N(WARN, n) << "every " << n << " " << i;
+  }
+}
+
+int main()
+{
+  muduo::Logger::setOutput(countOutput);
+
+  logEveryN(10, 1);
+  assert(g_lines == 10);
+  logEveryN(10, 0);
+  assert(g_lines == 10);
+  logEveryN(10, -1);
+  assert(g_lines == 10);
+  assert(strstr(g_last.c_str(), "suppressed") == NULL);
+  logEveryN(100, 10);
+  assert(g_lines == 10);
+  assert(strstr(g_last.c_str(), "[suppressed 9 messages] every 10 90") != NULL);
+  logEveryN(3, 10);
+  assert(g_lines == 1);
+  // each call site has its own counter
+  g_lines = 0;
+  for (int i = 0; i < 10; ++i)
+  {
+    LOG_EVERY_N(ERROR, 5) << "a";
+    LOG_EVERY_N(ERROR, 5) << "b";
+  }
+  assert(g_lines == 4);
+
+  g_lines = 0;
+  for (int i = 0; i < 100; ++i)
+  {
+    LOG_FIRST_N(INFO, 3) << "first " << i;
+  }
+  assert(g_lines == 3);
+  assert(strstr(g_last.c_str(), "first 2") != NULL);
+
+  g_lines = 0;
+  errno = EPIPE;
+  for (int i = 0; i < 1000; ++i)
+  {
+    LOG_EVERY_T(SYSERR, 3600) << "every hour " << i;
+  }
+  assert(g_lines == 1);
+  assert(strstr(g_last.c_str(), "every hour 0") != NULL);
+  assert(strstr(g_last.c_str(), "errno=32") != NULL);
+
+  g_lines = 0;
+  for (int i = 0; i < 50; ++i)
+  {
+    LOG_EVERY_T(WARN, 0.05) << "every 50ms " << i;
+    muduo::CurrentThread::sleepUsec(10*1000);
+  }
+  assert(g_lines >= 5 && g_lines <= 20);
+  assert(strstr(g_last.c_str(), "[suppressed ") != NULL);
+
+  // disabled levels are still sampled, but never formatted.
+  g_lines = 0;
+  for (int i = 0; i < 10; ++i)
+  {
+    LOG_EVERY_N(TRACE, 2) << "trace";
+  }
+  assert(g_lines == 0);
+
+  printf("PASSED\n");
+}
@@ -1,5 +1,6 @@
 #include "muduo/base/CountDownLatch.h"
 #include "muduo/base/Mutex.h"
+#include "muduo/base/MutexProfiler.h"
 #include "muduo/base/Thread.h"
 #include "muduo/base/Timestamp.h"
 
@@ -9,7 +10,7 @@
 using namespace muduo;
 using namespace std;
 
-MutexLock g_mutex;
+MutexLock g_mutex("g_mutex");
 vector<int> g_vec;
 const int kCount = 10*1000*1000;
 
@@ -78,5 +79,23 @@ int main()
     }
     printf("%d thread(s) with lock %f\n", nthreads, timeDifference(Timestamp::now(), start));
   }
-}
 
+  if (MutexProfiler::enable(0.001))
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    g_vec.clear();
+    start = Timestamp::now();
+    for (int i = 0; i < 4; ++i)
+    {
+      threads.emplace_back(new Thread(&threadFunc));
+      threads.back()->start();
+    }
+    for (auto& thr : threads)
+    {
+      thr->join();
+    }
+    printf("4 thread(s) with lock profiled %f\n", timeDifference(Timestamp::now(), start));
+    MutexProfiler::disable();
+  }
+  printf("%s", MutexProfiler::report().c_str());
+}
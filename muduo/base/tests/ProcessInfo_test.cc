@@ -1,4 +1,5 @@
 #include "muduo/base/ProcessInfo.h"
+#include "muduo/base/Timestamp.h"
 #include <stdio.h>
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
@@ -14,4 +15,29 @@ int main()
   printf("threads = %zd\n", muduo::ProcessInfo::threads().size());
   printf("num threads = %d\n", muduo::ProcessInfo::numThreads());
   printf("status = %s\n", muduo::ProcessInfo::procStatus().c_str());
+
+  muduo::ProcessInfo::Stat stat;
+  bool ok = muduo::ProcessInfo::parseStat(muduo::ProcessInfo::procStat(), &stat);
+  printf("parseStat %d state %c ppid %d threads %" PRId64 " vsize %" PRId64 " rss %" PRId64 "\n",
+         ok, stat.state, stat.ppid, stat.numThreads, stat.vsize, stat.rss);
+
+  muduo::ProcessInfo::StatSampler sampler;
+  sampler.add(muduo::ProcessInfo::pid());
+  sampler.add(1);
+  sampler.addThreads(muduo::ProcessInfo::pid());
+  const int kRounds = 10000;
+  muduo::Timestamp start = muduo::Timestamp::now();
+  for (int i = 0; i < kRounds; ++i)
+  {
+    sampler.sample();
+  }
+  double seconds = timeDifference(muduo::Timestamp::now(), start);
+  printf("sampled %d files %d times, %.2f us each\n",
+         sampler.size(), kRounds, seconds * 1e6 / kRounds / sampler.size());
+  for (int i = 0; i < sampler.size(); ++i)
+  {
+    printf("%d/%d valid %d utime %" PRId64 " stime %" PRId64 " cpu %d\n",
+           sampler.pid(i), sampler.tid(i), sampler.valid(i),
+           sampler.stat(i).utime, sampler.stat(i).stime, sampler.stat(i).processor);
+  }
 }
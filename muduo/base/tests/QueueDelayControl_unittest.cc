@@ -0,0 +1,125 @@
+#undef NDEBUG
+#include "muduo/base/QueueDelayControl.h"
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/CurrentThread.h"
+#include "muduo/base/ThreadPool.h"
+
+#include <atomic>
+#include <assert.h>
+#include <stdio.h>
+
+using muduo::QueueDelayControl;
+
+const int64_t kMs = 1000;
+
+void testControl()
+{
+  printf("testControl\n");
+  QueueDelayControl control;
+  assert(!control.enabled());
+  control.setTarget(0.005, 0.1);
+  assert(control.enabled());
+
+  // bursts are fine as long as the queue drains once per interval
+  int64_t now = 1000 * kMs;
+  for (int i = 0; i < 10; ++i, now += 50 * kMs)
+  {
+    bool accepted = control.dequeue(now - 20 * kMs, now);
+    assert(accepted);
+    accepted = control.dequeue(now - 1 * kMs, now);
+    assert(accepted);
+  }
+  assert(!control.overloaded());
+
+  // standing queue, every task waits 20ms
+  for (int i = 0; i < 10; ++i, now += 20 * kMs)
+  {
+    control.dequeue(now - 20 * kMs, now);
+  }
+  assert(control.overloaded());
+  bool admitted = control.admit(false);
+  assert(!admitted);
+  admitted = control.admit(true);
+  assert(admitted);
+  bool accepted = control.dequeue(now - 20 * kMs, now);
+  assert(!accepted);
+  accepted = control.dequeue(now - 1 * kMs, now);
+  assert(accepted);
+
+  // minimum falls below target for a whole interval
+  for (int i = 0; i < 10; ++i, now += 20 * kMs)
+  {
+    control.dequeue(now - 2 * kMs, now);
+  }
+  assert(!control.overloaded());
+
+  for (int i = 0; i < 10; ++i, now += 20 * kMs)
+  {
+    control.dequeue(now - 20 * kMs, now);
+  }
+  assert(control.overloaded());
+  control.drained();
+  assert(!control.overloaded());
+  admitted = control.admit(false);
+  assert(admitted);
+}
+
+void testThreadPool()
+{
+  printf("testThreadPool\n");
+  muduo::ThreadPool pool("DelayPool");
+  pool.setQueueDelayTarget(0.005, 0.05);
+  pool.start(1);
+
+  std::atomic<int> done(0);
+  std::atomic<int> rejected(0);
+  const int kTasks = 200;
+  muduo::CountDownLatch latch(kTasks);
+  // each task takes 2ms, so the queue never drains
+  for (int i = 0; i < kTasks; ++i)
+  {
+    pool.run([&] { muduo::CurrentThread::sleepUsec(2000); ++done; latch.countDown(); },
+             [&] { ++rejected; latch.countDown(); });
+  }
+  latch.wait();
+  printf("done %d rejected %d\n", done.load(), rejected.load());
+  assert(done + rejected == kTasks);
+  assert(rejected > 0);
+  assert(pool.numRejected() == static_cast<size_t>(rejected.load()));
+
+  // once drained, admits again
+  muduo::CurrentThread::sleepUsec(10 * 1000);
+  muduo::CountDownLatch latch2(1);
+  bool ok = false;
+  pool.run([&] { ok = true; latch2.countDown(); }, [&] { latch2.countDown(); });
+  latch2.wait();
+  assert(ok);
+  pool.stop();
+}
+
+void testThreadPoolDisabled()
+{
+  printf("testThreadPoolDisabled\n");
+  muduo::ThreadPool pool("NoDelayPool");
+  pool.start(1);
+  const int kTasks = 20;
+  muduo::CountDownLatch latch(kTasks);
+  std::atomic<int> rejected(0);
+  for (int i = 0; i < kTasks; ++i)
+  {
+    pool.run([&] { muduo::CurrentThread::sleepUsec(2000); latch.countDown(); },
+             [&] { ++rejected; });
+  }
+  latch.wait();
+  assert(rejected == 0);
+  assert(pool.numRejected() == 0);
+  pool.stop();
+}
+
+int main()
+{
+  testControl();
+  testThreadPool();
+  testThreadPoolDisabled();
+  printf("PASSED\n");
+}
@@ -0,0 +1,57 @@
+#undef NDEBUG
+#include "muduo/base/ShardedCounter.h"
+#include "muduo/base/Atomic.h"
+#include "muduo/base/Thread.h"
+#include "muduo/base/Timestamp.h"
+
+#include <memory>
+#include <vector>
+
+#include <assert.h>
+#include <stdio.h>
+
+const int kThreads = 8;
+const int kIncrements = 1000 * 1000;
+
+template<typename Counter>
+double bench(Counter* counter)
+{
+  std::vector<std::unique_ptr<muduo::Thread>> threads;
+  for (int i = 0; i < kThreads; ++i)
+  {
+    threads.emplace_back(new muduo::Thread([counter] {
+      for (int j = 0; j < kIncrements; ++j)
+      {
+        counter->increment();
+      }
+    }));
+  }
+  muduo::Timestamp start = muduo::Timestamp::now();
+  for (auto& thr : threads)
+  {
+    thr->start();
+  }
+  for (auto& thr : threads)
+  {
+    thr->join();
+  }
+  return timeDifference(muduo::Timestamp::now(), start);
+}
+
+int main()
+{
+  muduo::ShardedCounter counter;
+  assert(counter.value() == 0);
+  counter.add(10);
+  counter.add(-3);
+  assert(counter.value() == 7);
+
+  double sharded = bench(&counter);
+  assert(counter.value() == 7 + static_cast<int64_t>(kThreads) * kIncrements);
+
+  muduo::AtomicInt64 atomic;
+  double shared = bench(&atomic);
+  assert(atomic.get() == static_cast<int64_t>(kThreads) * kIncrements);
+  printf("ShardedCounter %.3fs, AtomicInt64 %.3fs\n", sharded, shared);
+  printf("PASSED\n");
+}
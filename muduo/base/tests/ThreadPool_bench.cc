@@ -0,0 +1,97 @@
+#include "muduo/base/ThreadPool.h"
+#include "muduo/base/WorkStealingThreadPool.h"
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/Timestamp.h"
+
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Throughput of small tasks, like the sudoku server_threadpool offload.
+
+const int kTasks = 1000*1000;
+
+void smallTask(muduo::CountDownLatch* latch)
+{
+  int64_t x = 0;
+  for (int i = 0; i < 100; ++i)
+  {
+    x += i * i;
+  }
+  __asm__ __volatile__("" : : "r"(x));
+  latch->countDown();
+}
+
+template<typename Pool>
+void submitOneByOne(Pool* pool, muduo::CountDownLatch* latch)
+{
+  for (int i = 0; i < kTasks; ++i)
+  {
+    pool->run(std::bind(smallTask, latch));
+  }
+}
+
+void submitBatch(muduo::WorkStealingThreadPool* pool, muduo::CountDownLatch* latch)
+{
+  const int kBatch = 256;
+  std::vector<muduo::WorkStealingThreadPool::Task> tasks;
+  tasks.reserve(kBatch);
+  for (int i = 0; i < kTasks; i += kBatch)
+  {
+    for (int j = i; j < std::min(i + kBatch, kTasks); ++j)
+    {
+      tasks.push_back(std::bind(smallTask, latch));
+    }
+    pool->runBatch(&tasks);
+  }
+}
+
+// every task of the first level spawns from inside worker
+template<typename Pool>
+void submitNested(Pool* pool, muduo::CountDownLatch* latch)
+{
+  const int kFanOut = 1000;
+  for (int i = 0; i < kTasks / kFanOut; ++i)
+  {
+    pool->run([pool, latch]
+    {
+      for (int j = 0; j < kFanOut; ++j)
+      {
+        pool->run(std::bind(smallTask, latch));
+      }
+    });
+  }
+}
+
+template<typename Pool, typename Submit>
+void bench(const char* name, int numThreads, Submit submit)
+{
+  Pool pool;
+  pool.start(numThreads);
+  muduo::CountDownLatch latch(kTasks);
+  muduo::Timestamp start(muduo::Timestamp::now());
+  submit(&pool, &latch);
+  latch.wait();
+  double seconds = timeDifference(muduo::Timestamp::now(), start);
+  printf("%-28s %2d threads %8.3f seconds %12.0f tasks/s\n",
+         name, numThreads, seconds, kTasks / seconds);
+  pool.stop();
+}
+
+int main(int argc, char* argv[])
+{
+  int maxThreads = argc > 1 ? atoi(argv[1]) : 8;
+  for (int n = 1; n <= maxThreads; n *= 2)
+  {
+    bench<muduo::ThreadPool>("ThreadPool run", n,
+        submitOneByOne<muduo::ThreadPool>);
+    bench<muduo::WorkStealingThreadPool>("WorkStealing run", n,
+        submitOneByOne<muduo::WorkStealingThreadPool>);
+    bench<muduo::WorkStealingThreadPool>("WorkStealing runBatch", n,
+        submitBatch);
+    bench<muduo::ThreadPool>("ThreadPool nested", n,
+        submitNested<muduo::ThreadPool>);
+    bench<muduo::WorkStealingThreadPool>("WorkStealing nested", n,
+        submitNested<muduo::WorkStealingThreadPool>);
+  }
+}
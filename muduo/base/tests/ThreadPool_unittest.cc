@@ -0,0 +1,176 @@
+#undef NDEBUG
+#include "muduo/base/ThreadPool.h"
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/CurrentThread.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+using muduo::ThreadPool;
+using muduo::Timestamp;
+
+std::vector<int> g_order;  // written by the only worker
+
+void append(int x)
+{
+  g_order.push_back(x);
+}
+
+// Blocks the only worker, so that following tasks are all queued.
+void block(ThreadPool* pool, muduo::CountDownLatch* gate)
+{
+  muduo::CountDownLatch started(1);
+  pool->run([&started, gate] { started.countDown(); gate->wait(); });
+  started.wait();
+}
+
+void testPriority()
+{
+  printf("testPriority\n");
+  ThreadPool pool;
+  pool.start(1);
+  g_order.clear();
+  muduo::CountDownLatch gate(1);
+  block(&pool, &gate);
+
+  pool.run(std::bind(append, 1), ThreadPool::kLowPriority);
+  pool.run(std::bind(append, 2));
+  pool.run(std::bind(append, 3), ThreadPool::kHighPriority);
+  pool.run(std::bind(append, 4), ThreadPool::kNormalPriority);
+  pool.run(std::bind(append, 5), ThreadPool::kHighPriority);
+  pool.run(std::bind(append, 6), ThreadPool::kLowPriority);
+  assert(pool.queueSize() == 6);
+  gate.countDown();
+
+  muduo::CountDownLatch done(1);
+  pool.run([&done] { done.countDown(); }, ThreadPool::kLowPriority);
+  done.wait();
+  assert(g_order == std::vector<int>({ 3, 5, 2, 4, 1, 6 }));
+  pool.stop();
+}
+
+void testStarvation()
+{
+  printf("testStarvation\n");
+  ThreadPool pool;
+  pool.setPrioritySlack(ThreadPool::kLowPriority, 0.01);
+  pool.start(1);
+  g_order.clear();
+  muduo::CountDownLatch gate(1);
+  block(&pool, &gate);
+
+  pool.run(std::bind(append, 1), ThreadPool::kLowPriority);
+  muduo::CurrentThread::sleepUsec(20 * 1000);
+  pool.run(std::bind(append, 2), ThreadPool::kHighPriority);
+  gate.countDown();
+
+  muduo::CountDownLatch done(1);
+  pool.run([&done] { done.countDown(); }, ThreadPool::kLowPriority);
+  done.wait();
+  assert(g_order == std::vector<int>({ 1, 2 }));
+  pool.stop();
+}
+
+void testDeadline()
+{
+  printf("testDeadline\n");
+  ThreadPool pool;
+  pool.start(1);
+  g_order.clear();
+  muduo::CountDownLatch gate(1);
+  block(&pool, &gate);
+
+  Timestamp now = Timestamp::now();
+  pool.run(std::bind(append, 1), addTime(now, 10.0));
+  pool.run(std::bind(append, 2), addTime(now, 0.01));
+  pool.run(std::bind(append, 3), addTime(now, 5.0));
+  muduo::CurrentThread::sleepUsec(20 * 1000);
+  gate.countDown();
+
+  muduo::CountDownLatch done(1);
+  pool.run([&done] { done.countDown(); }, addTime(now, 20.0));
+  done.wait();
+  assert(g_order == std::vector<int>({ 3, 1 }));
+  assert(pool.numExpired() == 1);
+  pool.stop();
+}
+
+void testElastic()
+{
+  printf("testElastic\n");
+  ThreadPool pool;
+  pool.setMaxThreads(4, 0.001, 0.1);
+  pool.start(1);
+  assert(pool.numThreads() == 1);
+
+  const int kTasks = 20;
+  muduo::CountDownLatch latch(kTasks);
+  for (int i = 0; i < kTasks; ++i)
+  {
+    pool.run([&latch] { muduo::CurrentThread::sleepUsec(10 * 1000); latch.countDown(); });
+  }
+  latch.wait();
+  int peak = pool.numThreads();
+  printf("peak %d threads\n", peak);
+  assert(peak > 1 && peak <= 4);
+
+  muduo::CurrentThread::sleepUsec(500 * 1000);
+  assert(pool.numThreads() == 1);
+
+  // grows again after retiring
+  muduo::CountDownLatch latch2(kTasks);
+  for (int i = 0; i < kTasks; ++i)
+  {
+    pool.run([&latch2] { muduo::CurrentThread::sleepUsec(10 * 1000); latch2.countDown(); });
+  }
+  latch2.wait();
+  assert(pool.numThreads() > 1);
+  pool.stop();
+}
+
+void testBlockingScope()
+{
+  printf("testBlockingScope\n");
+  ThreadPool pool;
+  pool.setMaxThreads(2, 100.0, 0.1);
+  pool.start(1);
+
+  // the first task waits for the second one, which needs another thread
+  muduo::CountDownLatch second(1);
+  muduo::CountDownLatch first(1);
+  pool.run([&] {
+    first.countDown();
+    ThreadPool::BlockingScope blocking;
+    second.wait();
+  });
+  first.wait();
+  pool.run([&second] { second.countDown(); });
+  second.wait();
+  assert(pool.numThreads() == 2);
+  pool.stop();
+}
+
+void testRunBeforeStart()
+{
+  printf("testRunBeforeStart\n");
+  ThreadPool pool;
+  pool.setMaxThreads(4);
+  pid_t tid = 0;
+  pool.run([&tid] { tid = muduo::CurrentThread::tid(); });
+  assert(tid == muduo::CurrentThread::tid());
+  pool.run([&tid] { tid = 0; }, ThreadPool::kLowPriority);
+  assert(tid == 0);
+  pool.start(1);
+  pool.stop();
+}
+
+int main()
+{
+  testRunBeforeStart();
+  testPriority();
+  testStarvation();
+  testDeadline();
+  testElastic();
+  testBlockingScope();
+  printf("PASSED\n");
+}
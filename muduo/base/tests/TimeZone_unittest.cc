@@ -265,6 +265,28 @@ void testFixedTimezone()
   }
 }
 
+// every hour of 1970~2037 against localtime_r(3)
+void testLibc(const char* name)
+{
+  char zonefile[256];
+  snprintf(zonefile, sizeof zonefile, "/usr/share/zoneinfo/%s", name);
+  TimeZone tz(zonefile);
+  setenv("TZ", name, 1);
+  tzset();
+  for (time_t t = 0; t < 0x7fffffff - 3600; t += 3599)
+  {
+    struct tm expected;
+    localtime_r(&t, &expected);
+    struct tm local = tz.toLocalTime(t);
+    if (local.tm_hour != expected.tm_hour || local.tm_mday != expected.tm_mday
+        || local.tm_gmtoff != expected.tm_gmtoff || local.tm_isdst != expected.tm_isdst)
+    {
+      printf("WRONG %s: %ld\n", name, static_cast<long>(t));
+      assert(0);
+    }
+  }
+}
+
 int main()
 {
   testNewYork();
@@ -273,4 +295,7 @@ int main()
   testHongKong();
   testFixedTimezone();
   testUtc();
+  testLibc("America/New_York");
+  testLibc("Europe/London");
+  testLibc("Australia/Sydney");
 }
@@ -1,8 +1,15 @@
 #include "muduo/base/Timestamp.h"
+#include "muduo/base/TscClock.h"
 #include <vector>
+#include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <time.h>
 
+using muduo::MonotonicTimestamp;
 using muduo::Timestamp;
+using muduo::TscClock;
 
 void passByConstReference(const Timestamp& x)
 {
@@ -55,6 +62,83 @@ void benchmark()
   }
 }
 
+int64_t gettimeofdayMicroseconds()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return static_cast<int64_t>(tv.tv_sec) * Timestamp::kMicroSecondsPerSecond + tv.tv_usec;
+}
+
+template<typename Clock>
+void benchmarkNow(const char* name, Clock clock)
+{
+  const int kNumber = 1000*1000;
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  int64_t sum = 0;
+  for (int i = 0; i < kNumber; ++i)
+  {
+    sum += clock();
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double ns = static_cast<double>((end.tv_sec - start.tv_sec) * 1000000000 + end.tv_nsec - start.tv_nsec);
+  printf("%-24s %6.1f ns/call (%ld)\n", name, ns / kNumber, static_cast<long>(sum & 1));
+}
+
+void benchmarkClocks()
+{
+  benchmarkNow("gettimeofday", gettimeofdayMicroseconds);
+  benchmarkNow("Timestamp::now", [] { return Timestamp::now().microSecondsSinceEpoch(); });
+  benchmarkNow("MonotonicTimestamp::now", [] { return MonotonicTimestamp::now().microSeconds(); });
+}
+
+void testMonotonic()
+{
+  MonotonicTimestamp last = MonotonicTimestamp::now();
+  assert(last.valid());
+  for (int i = 0; i < 1000*1000; ++i)
+  {
+    MonotonicTimestamp now = MonotonicTimestamp::now();
+    assert(!(now < last));
+    last = now;
+  }
+}
+
+// TSC clock stays within bound of the system clock, across resyncs.
+void testTscDrift()
+{
+  if (!TscClock::enable(0.01, 0.05))
+  {
+    printf("invariant TSC not available\n");
+    return;
+  }
+  printf("TSC %.3f ticks/us\n", TscClock::ticksPerMicrosecond());
+  const int64_t kMaxDriftUs = 500;
+  int64_t maxDrift = 0;
+  for (int i = 0; i < 20; ++i)
+  {
+    for (int j = 0; j < 1000; ++j)
+    {
+      int64_t before = gettimeofdayMicroseconds();
+      int64_t tsc = Timestamp::now().microSecondsSinceEpoch();
+      int64_t after = gettimeofdayMicroseconds();
+      int64_t drift = tsc < before ? before - tsc : (tsc > after ? tsc - after : 0);
+      if (drift > maxDrift)
+        maxDrift = drift;
+    }
+    struct timespec ts = { 0, 10 * 1000 * 1000 };
+    nanosleep(&ts, NULL);
+  }
+  printf("max drift %ld us\n", static_cast<long>(maxDrift));
+  if (maxDrift > kMaxDriftUs)
+  {
+    abort();
+  }
+  testMonotonic();
+  benchmarkClocks();
+  TscClock::disable();
+}
+
 int main()
 {
   Timestamp now(Timestamp::now());
@@ -62,5 +146,8 @@ int main()
   passByValue(now);
   passByConstReference(now);
   benchmark();
+  testMonotonic();
+  benchmarkClocks();
+  testTscDrift();
 }
 
@@ -0,0 +1,135 @@
+#undef NDEBUG
+#include "muduo/base/UniqueFunction.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <assert.h>
+#include <stdio.h>
+
+using muduo::UniqueFunction;
+
+int g_count = 0;
+int g_alive = 0;
+
+void inc()
+{
+  ++g_count;
+}
+
+struct Counted
+{
+  Counted() { ++g_alive; }
+  Counted(const Counted&) { ++g_alive; }
+  Counted(Counted&&) noexcept { ++g_alive; }
+  ~Counted() { --g_alive; }
+  void operator()() const { ++g_count; }
+};
+
+struct Big
+{
+  char data[200];
+  Counted counted;
+  void operator()() const { g_count += data[0]; }
+};
+
+void testBasic()
+{
+  printf("testBasic\n");
+  UniqueFunction<void ()> empty;
+  assert(!empty);
+  UniqueFunction<void ()> null(nullptr);
+  assert(!null);
+  void (*nullPointer)() = NULL;
+  UniqueFunction<void ()> fromNullPointer(nullPointer);
+  assert(!fromNullPointer);
+  std::function<void ()> emptyFunction;
+  UniqueFunction<void ()> fromEmptyFunction(emptyFunction);
+  assert(!fromEmptyFunction);
+
+  g_count = 0;
+  UniqueFunction<void ()> f(inc);
+  assert(f);
+  f();
+  assert(g_count == 1);
+
+  UniqueFunction<int (int, const std::string&)> add(
+      [](int x, const std::string& s) { return x + static_cast<int>(s.size()); });
+  int sum = add(1, "hello");
+  assert(sum == 6);
+
+  try
+  {
+    empty();
+    assert(false);
+  }
+  catch (const std::bad_function_call&)
+  {
+  }
+}
+
+void testMoveOnly()
+{
+  printf("testMoveOnly\n");
+  std::unique_ptr<int> p(new int(42));
+  UniqueFunction<int ()> f(std::bind([](const std::unique_ptr<int>& q) { return *q; },
+                                     std::move(p)));
+  int value = f();
+  assert(value == 42);
+
+  UniqueFunction<int ()> g(std::move(f));
+  assert(!f);
+  value = g();
+  assert(value == 42);
+
+  std::vector<UniqueFunction<int ()>> functors;
+  functors.push_back(std::move(g));
+  for (int i = 0; i < 100; ++i)
+  {
+    functors.push_back([i] { return i; });
+  }
+  value = functors[0]();
+  assert(value == 42);
+  value = functors[100]();
+  assert(value == 99);
+}
+
+void testLifetime()
+{
+  printf("testLifetime\n");
+  g_count = 0;
+  g_alive = 0;
+  {
+    UniqueFunction<void ()> small((Counted()));
+    assert(g_alive == 1);
+    Big big;
+    big.data[0] = 10;
+    UniqueFunction<void ()> large(big);
+    assert(g_alive == 3);
+
+    UniqueFunction<void ()> moved(std::move(small));
+    assert(g_alive == 3);
+    moved = std::move(large);
+    assert(g_alive == 2);
+    moved();
+    assert(g_count == 10);
+    moved = nullptr;
+    assert(g_alive == 1);
+
+    moved = Counted();
+    moved.swap(small);
+    assert(!moved);
+    small();
+    assert(g_count == 11);
+  }
+  assert(g_alive == 0);
+}
+
+int main()
+{
+  testBasic();
+  testMoveOnly();
+  testLifetime();
+  printf("PASSED\n");
+}
@@ -0,0 +1,145 @@
+#undef NDEBUG
+#include "muduo/base/WorkStealingThreadPool.h"
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/CurrentThread.h"
+
+#include <assert.h>
+#include <memory>
+#include <stdio.h>
+
+std::atomic<int> g_count(0);
+
+void inc()
+{
+  ++g_count;
+}
+
+// spawns 2^depth - 1 tasks from inside workers
+void spawn(muduo::WorkStealingThreadPool* pool, int depth, muduo::CountDownLatch* latch)
+{
+  ++g_count;
+  if (depth > 1)
+  {
+    pool->run(std::bind(spawn, pool, depth - 1, latch));
+    pool->run(std::bind(spawn, pool, depth - 1, latch));
+  }
+  else
+  {
+    latch->countDown();
+  }
+}
+
+void testRun(int numThreads)
+{
+  printf("testRun %d threads\n", numThreads);
+  muduo::WorkStealingThreadPool pool;
+  pool.start(numThreads);
+  g_count = 0;
+  const int kTasks = 100*1000;
+  for (int i = 0; i < kTasks; ++i)
+  {
+    pool.run(inc);
+  }
+  while (g_count < kTasks)
+  {
+    muduo::CurrentThread::sleepUsec(1000);
+  }
+  pool.stop();
+  assert(g_count == kTasks);
+}
+
+void testNested(int numThreads)
+{
+  printf("testNested %d threads\n", numThreads);
+  muduo::WorkStealingThreadPool pool;
+  pool.start(numThreads);
+  g_count = 0;
+  const int kDepth = 16;
+  muduo::CountDownLatch latch(1 << (kDepth - 1));
+  pool.run(std::bind(spawn, &pool, kDepth, &latch));
+  latch.wait();
+  pool.stop();
+  assert(g_count == (1 << kDepth) - 1);
+}
+
+void testBatch(int numThreads)
+{
+  printf("testBatch %d threads\n", numThreads);
+  muduo::WorkStealingThreadPool pool;
+  pool.start(numThreads);
+  g_count = 0;
+  const int kBatches = 1000;
+  const int kBatchSize = 100;
+  muduo::CountDownLatch latch(kBatches * kBatchSize);
+  std::vector<muduo::WorkStealingThreadPool::Task> tasks;
+  for (int i = 0; i < kBatches; ++i)
+  {
+    for (int j = 0; j < kBatchSize; ++j)
+    {
+      tasks.push_back([&latch] { ++g_count; latch.countDown(); });
+    }
+    pool.runBatch(&tasks);
+    assert(tasks.empty());
+  }
+  latch.wait();
+  pool.stop();
+  assert(g_count == kBatches * kBatchSize);
+}
+
+// owns its argument, can't be a std::function
+struct MoveOnlyTask
+{
+  std::unique_ptr<int> value;
+  muduo::CountDownLatch* latch;
+
+  void operator()() const
+  {
+    g_count += *value;
+    latch->countDown();
+  }
+};
+
+void testMoveOnly(int numThreads)
+{
+  printf("testMoveOnly %d threads\n", numThreads);
+  muduo::WorkStealingThreadPool pool;
+  pool.start(numThreads);
+  g_count = 0;
+  const int kTasks = 10*1000;
+  muduo::CountDownLatch latch(kTasks);
+  for (int i = 0; i < kTasks; ++i)
+  {
+    MoveOnlyTask task = { std::unique_ptr<int>(new int(2)), &latch };
+    pool.run(std::move(task));
+  }
+  latch.wait();
+  pool.stop();
+  assert(g_count == 2 * kTasks);
+}
+
+void testStopEarly()
+{
+  printf("testStopEarly\n");
+  muduo::WorkStealingThreadPool pool;
+  pool.start(2);
+  for (int i = 0; i < 1000; ++i)
+  {
+    pool.run([] { muduo::CurrentThread::sleepUsec(1000); });
+  }
+  pool.stop();  // pending ones are discarded
+  pool.run(inc);
+}
+
+int main()
+{
+  int threads[] = { 0, 1, 2, 4, 8 };
+  for (int n : threads)
+  {
+    testRun(n);
+    testNested(n);
+    testBatch(n);
+    testMoveOnly(n);
+  }
+  testStopEarly();
+  printf("PASSED\n");
+}
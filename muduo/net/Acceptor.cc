@@ -8,20 +8,46 @@
 
 #include "muduo/net/Acceptor.h"
 
+#include "muduo/base/FlightRecorder.h"
 #include "muduo/base/Logging.h"
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/InetAddress.h"
 #include "muduo/net/SocketsOps.h"
+#include "muduo/net/UnixAddress.h"
 
 #include <errno.h>
 #include <fcntl.h>
 //#include <sys/types.h>
-//#include <sys/stat.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
+namespace
+{
+
+// Removes the socket file if nobody has bound to it.
+void removeStaleSocket(const UnixAddress& addr)
+{
+  string path = addr.path();
+  struct stat st;
+  if (addr.isAbstract() || ::lstat(path.c_str(), &st) < 0 || !S_ISSOCK(st.st_mode))
+    return;
+
+  // EPROTOTYPE if it's bound to a socket of other type, so it's not stale
+  int sockfd = sockets::createNonblockingUnixOrDie(SOCK_STREAM);
+  if (sockets::connect(sockfd, addr.getSockAddr(), addr.length()) < 0
+      && errno == ECONNREFUSED)
+  {
+    LOG_WARN << "Acceptor - removing stale socket " << path;
+    ::unlink(path.c_str());
+  }
+  sockets::close(sockfd);
+}
+
+}  // namespace
+
 Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reuseport)
   : loop_(loop),
     acceptSocket_(sockets::createNonblockingOrDie(listenAddr.family())),
@@ -37,11 +63,33 @@ Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reusepor
       std::bind(&Acceptor::handleRead, this));
 }
 
+Acceptor::Acceptor(EventLoop* loop, const UnixAddress& listenAddr, int socketType)
+  : loop_(loop),
+    acceptSocket_(sockets::createNonblockingUnixOrDie(socketType)),
+    acceptChannel_(loop, acceptSocket_.fd()),
+    listening_(false),
+    idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC))
+{
+  assert(idleFd_ >= 0);
+  removeStaleSocket(listenAddr);
+  acceptSocket_.bindAddress(listenAddr);
+  if (!listenAddr.isAbstract())
+  {
+    unixPath_ = listenAddr.path();
+  }
+  acceptChannel_.setReadCallback(
+      std::bind(&Acceptor::handleRead, this));
+}
+
 Acceptor::~Acceptor()
 {
   acceptChannel_.disableAll();
   acceptChannel_.remove();
   ::close(idleFd_);
+  if (!unixPath_.empty())
+  {
+    ::unlink(unixPath_.c_str());
+  }
 }
 
 void Acceptor::listen()
@@ -62,6 +110,7 @@ void Acceptor::handleRead()
   {
     // string hostport = peerAddr.toIpPort();
     // LOG_TRACE << "Accepts of " << hostport;
+    RECORD_DEBUG("Acceptor::handleRead accepted fd", connfd);
     if (newConnectionCallback_)
     {
       newConnectionCallback_(connfd, peerAddr);
@@ -73,7 +122,7 @@ void Acceptor::handleRead()
   }
   else
   {
-    LOG_SYSERR << "in Acceptor::handleRead";
+    LOG_EVERY_T(SYSERR, 1) << "in Acceptor::handleRead";
     // Read the section named "The special problem of
     // accept()ing when you can't" in libev's doc.
     // By Marc Lehmann, author of libev.
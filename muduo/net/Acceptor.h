@@ -23,9 +23,11 @@ namespace net
 
 class EventLoop;
 class InetAddress;
+class UnixAddress;
 
 ///
-/// Acceptor of incoming TCP connections.
+/// Acceptor of incoming TCP connections,
+/// or of Unix domain stream or seqpacket connections.
 ///
 class Acceptor : noncopyable
 {
@@ -33,11 +35,19 @@ class Acceptor : noncopyable
   typedef std::function<void (int sockfd, const InetAddress&)> NewConnectionCallback;
 
   Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reuseport);
+  /// @c socketType is SOCK_STREAM or SOCK_SEQPACKET.
+  /// A stale socket file left by a dead process is removed before binding,
+  /// and the socket file is removed on destruction.
+  Acceptor(EventLoop* loop, const UnixAddress& listenAddr, int socketType);
   ~Acceptor();
 
   void setNewConnectionCallback(const NewConnectionCallback& cb)
   { newConnectionCallback_ = cb; }
 
+  /// TCP only, before listen(). See Socket.
+  void setTcpFastOpen(int queueLength) { acceptSocket_.setTcpFastOpen(queueLength); }
+  void setDeferAccept(int seconds) { acceptSocket_.setDeferAccept(seconds); }
+
   void listen();
 
   bool listening() const { return listening_; }
@@ -55,6 +65,7 @@ class Acceptor : noncopyable
   NewConnectionCallback newConnectionCallback_;
   bool listening_;
   int idleFd_;
+  string unixPath_;  // to unlink
 };
 
 }  // namespace net
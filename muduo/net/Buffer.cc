@@ -12,6 +12,7 @@
 #include "muduo/net/SocketsOps.h"
 
 #include <errno.h>
+#include <sys/socket.h>
 #include <sys/uio.h>
 
 using namespace muduo;
@@ -23,6 +24,11 @@ const size_t Buffer::kCheapPrepend;
 const size_t Buffer::kInitialSize;
 
 ssize_t Buffer::readFd(int fd, int* savedErrno)
+{
+  return readFd(fd, savedErrno, NULL, NULL);
+}
+
+ssize_t Buffer::readFd(int fd, int* savedErrno, std::vector<int>* passedFds, bool* truncated)
 {
   // saved an ioctl()/FIONREAD call to tell how much to read
   char extrabuf[65536];
@@ -35,7 +41,27 @@ ssize_t Buffer::readFd(int fd, int* savedErrno)
   // when there is enough space in this buffer, don't read into extrabuf.
   // when extrabuf is used, we read 128k-1 bytes at most.
   const int iovcnt = (writable < sizeof extrabuf) ? 2 : 1;
-  const ssize_t n = sockets::readv(fd, vec, iovcnt);
+  ssize_t n;
+  if (passedFds || truncated)
+  {
+    int fds[sockets::kMaxPassedFds];
+    int numFds = 0;
+    int flags = 0;
+    n = sockets::readvWithFds(fd, vec, iovcnt, passedFds ? fds : NULL,
+                              sockets::kMaxPassedFds, &numFds, &flags);
+    if (passedFds)
+    {
+      passedFds->insert(passedFds->end(), fds, fds + numFds);
+    }
+    if (truncated)
+    {
+      *truncated = n >= 0 && (flags & MSG_TRUNC);
+    }
+  }
+  else
+  {
+    n = sockets::readv(fd, vec, iovcnt);
+  }
   if (n < 0)
   {
     *savedErrno = errno;
@@ -378,6 +378,11 @@ class Buffer : public muduo::copyable
   /// It may implement with readv(2)
   /// @return result of read(2), @c errno is saved
   ssize_t readFd(int fd, int* savedErrno);
+  /// A socket only, read with recvmsg(2). Also receives SCM_RIGHTS fds
+  /// of a Unix domain socket if @c passedFds is not NULL, appends them.
+  /// Sets @c *truncated if not NULL and a SOCK_SEQPACKET record was longer
+  /// than the writable bytes plus 64KiB, the rest of it is discarded.
+  ssize_t readFd(int fd, int* savedErrno, std::vector<int>* passedFds, bool* truncated);
 
  private:
 
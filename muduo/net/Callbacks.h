@@ -12,6 +12,7 @@
 #define MUDUO_NET_CALLBACKS_H
 
 #include "muduo/base/Timestamp.h"
+#include "muduo/base/UniqueFunction.h"
 
 #include <functional>
 #include <memory>
@@ -60,7 +61,7 @@ namespace net
 class Buffer;
 class TcpConnection;
 typedef std::shared_ptr<TcpConnection> TcpConnectionPtr;
-typedef std::function<void()> TimerCallback;
+typedef UniqueFunction<void()> TimerCallback;
 typedef std::function<void (const TcpConnectionPtr&)> ConnectionCallback;
 typedef std::function<void (const TcpConnectionPtr&)> CloseCallback;
 typedef std::function<void (const TcpConnectionPtr&)> WriteCompleteCallback;
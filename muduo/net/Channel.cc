@@ -6,6 +6,7 @@
 
 // Author: Shuo Chen (chenshuo at chenshuo dot com)
 
+#include "muduo/base/FlightRecorder.h"
 #include "muduo/base/Logging.h"
 #include "muduo/net/Channel.h"
 #include "muduo/net/EventLoop.h"
@@ -84,6 +85,7 @@ void Channel::handleEventWithGuard(Timestamp receiveTime)
 {
   eventHandling_ = true;
   LOG_TRACE << reventsToString();
+  RECORD_TRACE("Channel::handleEvent fd, revents", fd_, revents_);
   if ((revents_ & POLLHUP) && !(revents_ & POLLIN))
   {
     if (logHup_)
@@ -9,12 +9,15 @@
 
 #include "muduo/net/Connector.h"
 
+#include "muduo/base/FlightRecorder.h"
 #include "muduo/base/Logging.h"
 #include "muduo/net/Channel.h"
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/SocketsOps.h"
 
 #include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 
 using namespace muduo;
 using namespace muduo::net;
@@ -24,9 +27,25 @@ const int Connector::kMaxRetryDelayMs;
 Connector::Connector(EventLoop* loop, const InetAddress& serverAddr)
   : loop_(loop),
     serverAddr_(serverAddr),
+    socketType_(SOCK_STREAM),
     connect_(false),
     state_(kDisconnected),
-    retryDelayMs_(kInitRetryDelayMs)
+    retryDelayMs_(kInitRetryDelayMs),
+    fastOpen_(false),
+    deferred_(false)
+{
+  LOG_DEBUG << "ctor[" << this << "]";
+}
+
+Connector::Connector(EventLoop* loop, const UnixAddress& serverAddr, int socketType)
+  : loop_(loop),
+    unixAddr_(new UnixAddress(serverAddr)),
+    socketType_(socketType),
+    connect_(false),
+    state_(kDisconnected),
+    retryDelayMs_(kInitRetryDelayMs),
+    fastOpen_(false),
+    deferred_(false)
 {
   LOG_DEBUG << "ctor[" << this << "]";
 }
@@ -37,6 +56,11 @@ Connector::~Connector()
   assert(!channel_);
 }
 
+string Connector::serverName() const
+{
+  return unixAddr_ ? unixAddr_->path() : serverAddr_.toIpPort();
+}
+
 void Connector::start()
 {
   connect_ = true;
@@ -54,6 +78,7 @@ void Connector::startInLoop()
   else
   {
     LOG_DEBUG << "do not connect";
+    RECORD_DEBUG("Connector do not connect, state", state_);
   }
 }
 
@@ -77,9 +102,26 @@ void Connector::stopInLoop()
 
 void Connector::connect()
 {
-  int sockfd = sockets::createNonblockingOrDie(serverAddr_.family());
-  int ret = sockets::connect(sockfd, serverAddr_.getSockAddr());
+  int sockfd;
+  int ret;
+  if (unixAddr_)
+  {
+    sockfd = sockets::createNonblockingUnixOrDie(socketType_);
+    ret = sockets::connect(sockfd, unixAddr_->getSockAddr(), unixAddr_->length());
+  }
+  else
+  {
+    sockfd = sockets::createNonblockingOrDie(serverAddr_.family());
+    if (fastOpen_)
+    {
+      setTcpFastOpenConnect(sockfd);
+    }
+    ret = sockets::connect(sockfd, serverAddr_.getSockAddr());
+  }
   int savedErrno = (ret == 0) ? 0 : errno;
+  // a non-blocking connect() returns 0 with TCP Fast Open cookie,
+  // when no SYN is sent yet, or on loopback sometimes.
+  deferred_ = fastOpen_ && ret == 0;
   switch (savedErrno)
   {
     case 0:
@@ -94,6 +136,7 @@ void Connector::connect()
     case EADDRNOTAVAIL:
     case ECONNREFUSED:
     case ENETUNREACH:
+    case ENOENT:  // Unix domain socket not yet created
       retry(sockfd);
       break;
 
@@ -116,6 +159,21 @@ void Connector::connect()
   }
 }
 
+void Connector::setTcpFastOpenConnect(int sockfd)
+{
+#ifdef TCP_FASTOPEN_CONNECT
+  int optval = 1;
+  if (::setsockopt(sockfd, IPPROTO_TCP, TCP_FASTOPEN_CONNECT,
+                   &optval, static_cast<socklen_t>(sizeof optval)) < 0)
+  {
+    LOG_SYSERR << "TCP_FASTOPEN_CONNECT failed.";
+  }
+#else
+  (void)sockfd;
+  LOG_ERROR << "TCP_FASTOPEN_CONNECT is not supported.";
+#endif
+}
+
 void Connector::restart()
 {
   loop_->assertInLoopThread();
@@ -158,6 +216,7 @@ void Connector::resetChannel()
 void Connector::handleWrite()
 {
   LOG_TRACE << "Connector::handleWrite " << state_;
+  RECORD_TRACE("Connector::handleWrite state", state_);
 
   if (state_ == kConnecting)
   {
@@ -167,9 +226,11 @@ void Connector::handleWrite()
     {
       LOG_WARN << "Connector::handleWrite - SO_ERROR = "
                << err << " " << strerror_tl(err);
+      RECORD_DEBUG("Connector::handleWrite fd, SO_ERROR", sockfd, err);
       retry(sockfd);
     }
-    else if (sockets::isSelfConnect(sockfd))
+    // no peer address before the handshake, can't be a self connect either
+    else if (!deferred_ && sockets::isSelfConnect(sockfd))
     {
       LOG_WARN << "Connector::handleWrite - Self connect";
       retry(sockfd);
@@ -202,6 +263,7 @@ void Connector::handleError()
     int sockfd = removeAndResetChannel();
     int err = sockets::getSocketError(sockfd);
     LOG_TRACE << "SO_ERROR = " << err << " " << strerror_tl(err);
+    RECORD_DEBUG("Connector::handleError fd, SO_ERROR", sockfd, err);
     retry(sockfd);
   }
 }
@@ -212,7 +274,7 @@ void Connector::retry(int sockfd)
   setState(kDisconnected);
   if (connect_)
   {
-    LOG_INFO << "Connector::retry - Retry connecting to " << serverAddr_.toIpPort()
+    LOG_INFO << "Connector::retry - Retry connecting to " << serverName()
              << " in " << retryDelayMs_ << " milliseconds. ";
     loop_->runAfter(retryDelayMs_/1000.0,
                     std::bind(&Connector::startInLoop, shared_from_this()));
@@ -221,6 +283,7 @@ void Connector::retry(int sockfd)
   else
   {
     LOG_DEBUG << "do not connect";
+    RECORD_DEBUG("Connector do not connect, state", state_);
   }
 }
 
@@ -13,6 +13,7 @@
 
 #include "muduo/base/noncopyable.h"
 #include "muduo/net/InetAddress.h"
+#include "muduo/net/UnixAddress.h"
 
 #include <functional>
 #include <memory>
@@ -32,16 +33,29 @@ class Connector : noncopyable,
   typedef std::function<void (int sockfd)> NewConnectionCallback;
 
   Connector(EventLoop* loop, const InetAddress& serverAddr);
+  /// @c socketType is SOCK_STREAM or SOCK_SEQPACKET.
+  Connector(EventLoop* loop, const UnixAddress& serverAddr, int socketType);
   ~Connector();
 
   void setNewConnectionCallback(const NewConnectionCallback& cb)
   { newConnectionCallback_ = cb; }
 
+  /// Sets TCP_FASTOPEN_CONNECT, TCP only, before start().
+  /// With a cookie from an earlier connection to the server, the handshake
+  /// is deferred, the connection is called back at once, and the first
+  /// write goes in the SYN. Otherwise it connects as usual and asks for
+  /// a cookie. Needs bit 0x1 of sysctl net.ipv4.tcp_fastopen.
+  void setTcpFastOpen(bool on) { fastOpen_ = on; }
+  bool tcpFastOpen() const { return fastOpen_; }
+
   void start();  // can be called in any thread
   void restart();  // must be called in loop thread
   void stop();  // can be called in any thread
 
+  /// Not meaningful for Unix domain sockets, use serverName() instead.
   const InetAddress& serverAddress() const { return serverAddr_; }
+  /// "ip:port" or the path of Unix domain socket
+  string serverName() const;
 
  private:
   enum States { kDisconnected, kConnecting, kConnected };
@@ -52,6 +66,7 @@ class Connector : noncopyable,
   void startInLoop();
   void stopInLoop();
   void connect();
+  void setTcpFastOpenConnect(int sockfd);
   void connecting(int sockfd);
   void handleWrite();
   void handleError();
@@ -61,11 +76,15 @@ class Connector : noncopyable,
 
   EventLoop* loop_;
   InetAddress serverAddr_;
+  std::unique_ptr<UnixAddress> unixAddr_;  // not null for Unix domain sockets
+  int socketType_;
   bool connect_; // atomic
   States state_;  // FIXME: use atomic variable
   std::unique_ptr<Channel> channel_;
   NewConnectionCallback newConnectionCallback_;
   int retryDelayMs_;
+  bool fastOpen_;
+  bool deferred_;  // connect() returned before sending SYN
 };
 
 }  // namespace net
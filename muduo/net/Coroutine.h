@@ -0,0 +1,541 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_COROUTINE_H
+#define MUDUO_NET_COROUTINE_H
+
+// Header only, the library itself is built as C++11.
+#if !defined(__cpp_impl_coroutine)
+#error "muduo/net/Coroutine.h needs C++20 coroutines, compile with -std=c++20"
+#endif
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpClient.h"
+#include "muduo/net/TcpConnection.h"
+
+#include <algorithm>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace muduo
+{
+namespace net
+{
+///
+/// Coroutines over EventLoop and TcpConnection.
+///
+///   co::Task<> serve(TcpConnectionPtr conn)
+///   {
+///     co::Stream stream(conn);
+///     while (true)
+///     {
+///       StringPiece line = co_await stream.readUntil("\r\n");
+///       if (stream.closed())
+///         break;
+///       co_await stream.write(line);
+///     }
+///   }
+///
+///   void onConnection(const TcpConnectionPtr& conn)
+///   {
+///     if (conn->connected())
+///       co::spawn(serve(conn));
+///   }
+///
+/// A coroutine runs in the loop thread where it's resumed, which is the
+/// loop of the connection for Stream, and @c loop for sleep().
+/// State of a protocol lives in the coroutine frame, frames are
+/// allocated from a per-thread pool, thus per loop.
+///
+namespace co
+{
+
+namespace detail
+{
+
+// Frames of finished coroutines are cached by size in free lists of
+// the thread, coroutines of a loop reuse frames of each other.
+class FramePool
+{
+ public:
+  static const size_t kGranularity = 64;
+  static const size_t kNumClasses = 64;  // up to 4KiB
+  static const int kMaxCached = 256;  // of each size
+
+  static void* allocate(size_t size)
+  {
+    size_t index = (size + kGranularity - 1) / kGranularity;
+    if (index < kNumClasses)
+    {
+      FreeList& list = lists()[index];
+      if (list.head)
+      {
+        Block* block = list.head;
+        list.head = block->next;
+        --list.count;
+        return block;
+      }
+      return ::operator new(index * kGranularity);
+    }
+    return ::operator new(size);
+  }
+
+  static void deallocate(void* p, size_t size)
+  {
+    size_t index = (size + kGranularity - 1) / kGranularity;
+    if (index < kNumClasses && lists()[index].count < kMaxCached)
+    {
+      FreeList& list = lists()[index];
+      Block* block = static_cast<Block*>(p);
+      block->next = list.head;
+      list.head = block;
+      ++list.count;
+      return;
+    }
+    ::operator delete(p);
+  }
+
+ private:
+  struct Block
+  {
+    Block* next;
+  };
+
+  struct FreeList
+  {
+    Block* head = nullptr;
+    int count = 0;
+
+    ~FreeList()
+    {
+      while (head)
+      {
+        Block* next = head->next;
+        ::operator delete(head);
+        head = next;
+      }
+    }
+  };
+
+  static FreeList* lists()
+  {
+    thread_local FreeList t_lists[kNumClasses];
+    return t_lists;
+  }
+};
+
+class PromiseBase
+{
+ public:
+  static void* operator new(size_t size)
+  { return FramePool::allocate(size); }
+  static void operator delete(void* p, size_t size)
+  { FramePool::deallocate(p, size); }
+
+  // resumes the awaiting coroutine, or frees a spawned one
+  struct FinalAwaiter
+  {
+    bool await_ready() const noexcept { return false; }
+
+    template<typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept
+    {
+      PromiseBase& promise = h.promise();
+      if (promise.continuation_)
+      {
+        return promise.continuation_;
+      }
+      if (promise.exception_)
+      {
+        LOG_FATAL << "unhandled exception in a spawned coroutine";
+      }
+      h.destroy();
+      return std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept { }
+  };
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() { exception_ = std::current_exception(); }
+
+  void setContinuation(std::coroutine_handle<> h) { continuation_ = h; }
+
+ protected:
+  void rethrowIfAny()
+  {
+    if (exception_)
+    {
+      std::rethrow_exception(exception_);
+    }
+  }
+
+ private:
+  std::coroutine_handle<> continuation_;
+  std::exception_ptr exception_;
+};
+
+template<typename T>
+class Promise : public PromiseBase
+{
+ public:
+  template<typename U>
+  void return_value(U&& value) { value_.emplace(std::forward<U>(value)); }
+
+  T result()
+  {
+    rethrowIfAny();
+    return std::move(*value_);
+  }
+
+ private:
+  std::optional<T> value_;
+};
+
+template<>
+class Promise<void> : public PromiseBase
+{
+ public:
+  void return_void() { }
+  void result() { rethrowIfAny(); }
+};
+
+}  // namespace detail
+
+///
+/// A lazy coroutine, started by co_await in another coroutine,
+/// or by spawn().
+///
+template<typename T = void>
+class Task : noncopyable
+{
+ public:
+  class promise_type : public detail::Promise<T>
+  {
+   public:
+    Task get_return_object()
+    { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+  };
+
+  Task(Task&& rhs) noexcept
+    : coroutine_(std::exchange(rhs.coroutine_, nullptr))
+  {
+  }
+
+  ~Task()
+  {
+    if (coroutine_)
+    {
+      coroutine_.destroy();
+    }
+  }
+
+  bool await_ready() const noexcept { return false; }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+  {
+    coroutine_.promise().setContinuation(awaiting);
+    return coroutine_;
+  }
+
+  T await_resume() { return coroutine_.promise().result(); }
+
+ private:
+  template<typename U>
+  friend void spawn(Task<U>&& task);
+
+  explicit Task(std::coroutine_handle<promise_type> h)
+    : coroutine_(h)
+  {
+  }
+
+  std::coroutine_handle<promise_type> coroutine_;
+};
+
+///
+/// Runs @c task until it first suspends, then lets it go. The frame is
+/// freed when it finishes, the result is dropped, an exception aborts.
+/// Call in the loop thread it's going to run in.
+///
+template<typename T>
+void spawn(Task<T>&& task)
+{
+  std::exchange(task.coroutine_, nullptr).resume();
+}
+
+///
+/// Resumes in @c loop after @c seconds. Allocates a timer.
+///
+class SleepAwaiter
+{
+ public:
+  SleepAwaiter(EventLoop* loop, double seconds)
+    : loop_(loop), seconds_(seconds)
+  {
+  }
+
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> h)
+  { loop_->runAfter(seconds_, [h] { h.resume(); }); }
+  void await_resume() const noexcept { }
+
+ private:
+  EventLoop* loop_;
+  double seconds_;
+};
+
+inline SleepAwaiter sleep(EventLoop* loop, double seconds)
+{
+  return SleepAwaiter(loop, seconds);
+}
+
+///
+/// Connects @c client, which must not be connecting, and resumes in its
+/// loop with the connection once it's up. It keeps retrying like TcpClient.
+///
+class ConnectAwaiter
+{
+ public:
+  explicit ConnectAwaiter(TcpClient* client)
+    : client_(client)
+  {
+  }
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> h)
+  {
+    client_->setConnectionCallback([h](const TcpConnectionPtr& conn) {
+      if (conn->connected())
+        h.resume();
+    });
+    client_->connect();
+  }
+
+  TcpConnectionPtr await_resume()
+  {
+    client_->setConnectionCallback(defaultConnectionCallback);
+    return client_->connection();
+  }
+
+ private:
+  TcpClient* client_;
+};
+
+inline ConnectAwaiter connect(TcpClient* client)
+{
+  return ConnectAwaiter(client);
+}
+
+///
+/// Awaitable reads and writes of a TcpConnection, in the loop of it.
+///
+/// It takes over message, write complete and connection callbacks of the
+/// connection, so the callbacks set by TcpServer or TcpClient don't get
+/// the DOWN event. After the stream is destroyed, input is discarded.
+///
+/// Reads return a view of the input buffer, valid until the coroutine
+/// suspends again, so it can be passed to write().
+/// Nothing is allocated when the buffers are large enough and writes
+/// complete at once.
+///
+class Stream : noncopyable
+{
+ private:
+  // shared with callbacks of the connection, which may outlive the stream
+  struct State
+  {
+    Buffer* input = nullptr;
+    std::coroutine_handle<> reader;
+    std::coroutine_handle<> writer;
+    size_t need = 0;  // for read()
+    StringPiece delim;  // for readUntil()
+    size_t scanned = 0;  // of input without delim, in this readUntil()
+    size_t found = 0;  // offset of delim
+    bool closed = false;
+    bool detached = false;
+
+    bool readable()
+    {
+      if (delim.empty())
+      {
+        return input->readableBytes() >= need;
+      }
+      const char* start = input->peek() + scanned;
+      const char* end = input->beginWrite();
+      const char* pos = std::search(start, end, delim.begin(), delim.end());
+      if (pos != end)
+      {
+        found = static_cast<size_t>(pos - input->peek());
+        return true;
+      }
+      // a delim may straddle the end
+      size_t tail = std::min(input->readableBytes(), static_cast<size_t>(delim.size()) - 1);
+      scanned = input->readableBytes() - tail;
+      return false;
+    }
+
+    StringPiece take()
+    {
+      StringPiece piece;
+      if (delim.empty())
+      {
+        if (input->readableBytes() >= need)
+        {
+          piece = StringPiece(input->peek(), static_cast<int>(need));
+          input->retrieve(need);
+        }
+      }
+      else if (readable())
+      {
+        piece = StringPiece(input->peek(), static_cast<int>(found));
+        input->retrieve(found + static_cast<size_t>(delim.size()));
+        scanned = 0;
+      }
+      // the bytes are left in place until the next read of the socket
+      return piece;
+    }
+
+    static void resume(std::coroutine_handle<>* waiting)
+    {
+      std::exchange(*waiting, nullptr).resume();
+    }
+  };
+
+ public:
+  class ReadAwaiter
+  {
+   public:
+    explicit ReadAwaiter(State* state) : state_(state) { }
+
+    bool await_ready() const { return state_->readable() || state_->closed; }
+    void await_suspend(std::coroutine_handle<> h) { state_->reader = h; }
+    /// Empty if closed before enough data arrived.
+    StringPiece await_resume() const { return state_->take(); }
+
+   private:
+    State* state_;
+  };
+
+  class WriteAwaiter
+  {
+   public:
+    WriteAwaiter(Stream* stream, StringPiece data)
+      : stream_(stream), data_(data)
+    {
+    }
+
+    bool await_ready() const
+    {
+      const TcpConnectionPtr& conn = stream_->conn_;
+      if (!conn->connected())
+        return true;
+      conn->send(data_);
+      return conn->outputBuffer()->readableBytes() == 0;
+    }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+      stream_->state_->writer = h;
+      // copied to a queued functor before being called, so it can be reset
+      stream_->conn_->setWriteCompleteCallback(
+          [state = stream_->state_](const TcpConnectionPtr& conn) {
+        conn->setWriteCompleteCallback(WriteCompleteCallback());
+        if (!state->detached && state->writer)
+          State::resume(&state->writer);
+      });
+    }
+
+    /// false if the connection was closed before all data were written.
+    bool await_resume() const
+    { return stream_->conn_->connected() && !stream_->state_->closed; }
+
+   private:
+    Stream* stream_;
+    StringPiece data_;
+  };
+
+  explicit Stream(const TcpConnectionPtr& connection)
+    : conn_(connection),
+      state_(std::make_shared<State>())
+  {
+    conn_->getLoop()->assertInLoopThread();
+    state_->input = conn_->inputBuffer();
+    state_->closed = !conn_->connected();
+    std::shared_ptr<State> state(state_);
+    conn_->setMessageCallback([state](const TcpConnectionPtr&, Buffer* buf, Timestamp) {
+      if (state->detached)
+        buf->retrieveAll();
+      else if (state->reader && state->readable())
+        State::resume(&state->reader);
+    });
+    conn_->setConnectionCallback([state](const TcpConnectionPtr& conn) {
+      if (conn->connected() || state->detached)
+        return;
+      state->closed = true;
+      if (state->reader)
+        State::resume(&state->reader);
+      if (state->writer)
+        State::resume(&state->writer);
+    });
+  }
+
+  ~Stream()
+  {
+    // a coroutine destroyed while suspended on it is never resumed
+    state_->detached = true;
+    state_->reader = nullptr;
+    state_->writer = nullptr;
+    state_->input->retrieveAll();
+  }
+
+  const TcpConnectionPtr& connection() const { return conn_; }
+
+  /// The connection is DOWN, data left in the input buffer can still be read.
+  bool closed() const { return state_->closed; }
+
+  /// Resumes with the next @c n bytes.
+  ReadAwaiter read(size_t n)
+  {
+    state_->need = n;
+    state_->delim = StringPiece();
+    return ReadAwaiter(get_pointer(state_));
+  }
+
+  /// Resumes with the bytes before the next @c delim, which is consumed
+  /// too. @c delim must outlive the co_await.
+  ReadAwaiter readUntil(StringPiece delim)
+  {
+    assert(!delim.empty());
+    state_->delim = delim;
+    state_->scanned = 0;
+    return ReadAwaiter(get_pointer(state_));
+  }
+
+  /// Sends @c data and resumes when the output buffer is drained.
+  WriteAwaiter write(StringPiece data)
+  {
+    return WriteAwaiter(this, data);
+  }
+
+  void shutdown() { conn_->shutdown(); }
+  void forceClose() { conn_->forceClose(); }
+
+ private:
+  TcpConnectionPtr conn_;
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace co
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_COROUTINE_H
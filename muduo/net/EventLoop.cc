@@ -8,10 +8,12 @@
 
 #include "muduo/net/EventLoop.h"
 
+#include "muduo/base/FlightRecorder.h"
 #include "muduo/base/Logging.h"
 #include "muduo/base/Mutex.h"
 #include "muduo/net/Channel.h"
 #include "muduo/net/Poller.h"
+#include "muduo/net/SlabPool.h"
 #include "muduo/net/SocketsOps.h"
 #include "muduo/net/TimerQueue.h"
 
@@ -72,9 +74,14 @@ EventLoop::EventLoop()
     timerQueue_(new TimerQueue(this)),
     wakeupFd_(createEventfd()),
     wakeupChannel_(new Channel(this, wakeupFd_)),
-    currentActiveChannel_(NULL)
+    slabPool_(SlabPool::enabled() ? new SlabPool : NULL),
+    currentActiveChannel_(NULL),
+    mutex_("EventLoop"),
+    overloaded_(false),
+    numRejected_(0)
 {
   LOG_DEBUG << "EventLoop created " << this << " in thread " << threadId_;
+  RECORD_DEBUG("EventLoop created in thread", threadId_);
   if (t_loopInThisThread)
   {
     LOG_FATAL << "Another EventLoop " << t_loopInThisThread
@@ -94,9 +101,15 @@ EventLoop::~EventLoop()
 {
   LOG_DEBUG << "EventLoop " << this << " of thread " << threadId_
             << " destructs in thread " << CurrentThread::tid();
+  RECORD_DEBUG("EventLoop destructs, thread", threadId_);
   wakeupChannel_->disableAll();
   wakeupChannel_->remove();
   ::close(wakeupFd_);
+  if (slabPool_)
+  {
+    // stays until connections outliving this are gone
+    slabPool_->release();
+  }
   t_loopInThisThread = NULL;
 }
 
@@ -107,12 +120,16 @@ void EventLoop::loop()
   looping_ = true;
   quit_ = false;  // FIXME: what if someone calls quit() before loop() ?
   LOG_TRACE << "EventLoop " << this << " start looping";
+  RECORD_TRACE("EventLoop start looping, thread", threadId_);
 
   while (!quit_)
   {
     activeChannels_.clear();
     pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+    loopTime_ = pollReturnTime_;
     ++iteration_;
+    RECORD_TRACE("EventLoop::loop iteration, active channels",
+                 iteration_, static_cast<int64_t>(activeChannels_.size()));
     if (Logger::logLevel() <= Logger::TRACE)
     {
       printActiveChannels();
@@ -126,10 +143,12 @@ void EventLoop::loop()
     }
     currentActiveChannel_ = NULL;
     eventHandling_ = false;
+    loopTime_ = Timestamp::now();
     doPendingFunctors();
   }
 
   LOG_TRACE << "EventLoop " << this << " stop looping";
+  RECORD_TRACE("EventLoop stop looping, iteration", iteration_);
   looping_ = false;
 }
 
@@ -170,6 +189,40 @@ void EventLoop::queueInLoop(Functor cb)
   }
 }
 
+void EventLoop::queueInLoop(Functor cb, Functor rejected)
+{
+  if (!delayControl_.enabled())
+  {
+    queueInLoop(std::move(cb));
+    return;
+  }
+
+  int64_t now = MonotonicTimestamp::now().microSeconds();
+  bool admitted = false;
+  {
+  MutexLockGuard lock(mutex_);
+  if (!overloaded_ || pendingFunctors_.empty())
+  {
+    delayedFunctors_.emplace_back(pendingFunctors_.size(), now, std::move(rejected));
+    pendingFunctors_.push_back(std::move(cb));
+    admitted = true;
+  }
+  }
+
+  if (!admitted)
+  {
+    ++numRejected_;
+    if (rejected)
+    {
+      rejected();
+    }
+  }
+  else if (!isInLoopThread() || callingPendingFunctors_)
+  {
+    wakeup();
+  }
+}
+
 size_t EventLoop::queueSize() const
 {
   MutexLockGuard lock(mutex_);
@@ -254,20 +307,52 @@ void EventLoop::handleRead()
 void EventLoop::doPendingFunctors()
 {
   std::vector<Functor> functors;
+  std::vector<DelayedFunctor> delayed;
   callingPendingFunctors_ = true;
 
   {
   MutexLockGuard lock(mutex_);
   functors.swap(pendingFunctors_);
+  delayed.swap(delayedFunctors_);
   }
 
-  for (const Functor& functor : functors)
+  if (functors.empty() && delayControl_.enabled())
+  {
+    delayControl_.drained();
+    overloaded_ = false;
+  }
+  size_t next = 0;
+  for (size_t i = 0; i < functors.size(); ++i)
   {
-    functor();
+    if (next < delayed.size() && delayed[next].index == i)
+    {
+      doQueuedFunctor(delayed[next].enqueueTime, functors[i], delayed[next].rejected);
+      ++next;
+    }
+    else
+    {
+      functors[i]();
+    }
   }
   callingPendingFunctors_ = false;
 }
 
+void EventLoop::doQueuedFunctor(int64_t enqueueTime, const Functor& cb, const Functor& rejected)
+{
+  int64_t now = MonotonicTimestamp::now().microSeconds();
+  bool accepted = delayControl_.dequeue(enqueueTime, now);
+  overloaded_ = delayControl_.overloaded();
+  if (accepted || !rejected)
+  {
+    cb();
+  }
+  else
+  {
+    ++numRejected_;
+    rejected();
+  }
+}
+
 void EventLoop::printActiveChannels() const
 {
   for (const Channel* channel : activeChannels_)
@@ -19,7 +19,9 @@
 
 #include "muduo/base/Mutex.h"
 #include "muduo/base/CurrentThread.h"
+#include "muduo/base/QueueDelayControl.h"
 #include "muduo/base/Timestamp.h"
+#include "muduo/base/UniqueFunction.h"
 #include "muduo/net/Callbacks.h"
 #include "muduo/net/TimerId.h"
 
@@ -30,6 +32,7 @@ namespace net
 
 class Channel;
 class Poller;
+class SlabPool;
 class TimerQueue;
 
 ///
@@ -39,7 +42,7 @@ class TimerQueue;
 class EventLoop : noncopyable
 {
  public:
-  typedef std::function<void()> Functor;
+  typedef UniqueFunction<void()> Functor;
 
   EventLoop();
   ~EventLoop();  // force out-line dtor, for std::unique_ptr members.
@@ -62,6 +65,13 @@ class EventLoop : noncopyable
   ///
   Timestamp pollReturnTime() const { return pollReturnTime_; }
 
+  ///
+  /// Time when this round of event handling or pending functors began,
+  /// saves a Timestamp::now() call for handlers that can live with it
+  /// being stale by the run time of handlers before them.
+  ///
+  Timestamp loopTime() const { return loopTime_; }
+
   int64_t iteration() const { return iteration_; }
 
   /// Runs callback immediately in the loop thread.
@@ -73,9 +83,22 @@ class EventLoop : noncopyable
   /// Runs after finish pooling.
   /// Safe to call from other threads.
   void queueInLoop(Functor cb);
+  /// Queues callback in the loop thread, unless the loop is overloaded,
+  /// see setQueueDelayTarget(). Then rejected is called in this thread,
+  /// or in the loop thread instead of cb if cb has been queued for too long.
+  /// Same as queueInLoop(cb) if no queue delay target is set.
+  /// Safe to call from other threads.
+  void queueInLoop(Functor cb, Functor rejected);
 
   size_t queueSize() const;
 
+  /// Enables controlled delay admission for queueInLoop(cb, rejected),
+  /// see QueueDelayControl. Delay is measured on those callbacks only.
+  /// Must be called before loop().
+  void setQueueDelayTarget(double targetSeconds, double intervalSeconds)
+  { delayControl_.setTarget(targetSeconds, intervalSeconds); }
+  int64_t numRejected() const { return numRejected_.load(); }
+
   // timers
 
   ///
@@ -128,10 +151,32 @@ class EventLoop : noncopyable
 
   static EventLoop* getEventLoopOfCurrentThread();
 
+  /// Memory for connections of this loop, NULL if disabled.
+  /// See SlabPool.
+  SlabPool* slabPool() const { return slabPool_; }
+
  private:
+  // Of a functor from queueInLoop(cb, rejected), whose cb is in
+  // pendingFunctors_ at index. Kept apart, so that other functors don't
+  // pay for it, nor does cb bound with rejected spill its inline storage.
+  struct DelayedFunctor
+  {
+    DelayedFunctor(size_t i, int64_t t, Functor&& r)
+      : index(i),
+        enqueueTime(t),
+        rejected(std::move(r))
+    {
+    }
+
+    size_t index;
+    int64_t enqueueTime;
+    Functor rejected;
+  };
+
   void abortNotInLoopThread();
   void handleRead();  // waked up
   void doPendingFunctors();
+  void doQueuedFunctor(int64_t enqueueTime, const Functor& cb, const Functor& rejected);
 
   void printActiveChannels() const; // DEBUG
 
@@ -144,6 +189,7 @@ class EventLoop : noncopyable
   int64_t iteration_;
   const pid_t threadId_;
   Timestamp pollReturnTime_;
+  Timestamp loopTime_;
   std::unique_ptr<Poller> poller_;
   std::unique_ptr<TimerQueue> timerQueue_;
   int wakeupFd_;
@@ -151,6 +197,7 @@ class EventLoop : noncopyable
   // we don't expose Channel to client.
   std::unique_ptr<Channel> wakeupChannel_;
   boost::any context_;
+  SlabPool* slabPool_;  // released in dtor
 
   // scratch variables
   ChannelList activeChannels_;
@@ -158,6 +205,11 @@ class EventLoop : noncopyable
 
   mutable MutexLock mutex_;
   std::vector<Functor> pendingFunctors_ GUARDED_BY(mutex_);
+  std::vector<DelayedFunctor> delayedFunctors_ GUARDED_BY(mutex_);  // ascending index
+
+  QueueDelayControl delayControl_;  // used in loop thread
+  std::atomic<bool> overloaded_;
+  std::atomic<int64_t> numRejected_;
 };
 
 }  // namespace net
@@ -18,7 +18,7 @@ EventLoopThread::EventLoopThread(const ThreadInitCallback& cb,
   : loop_(NULL),
     exiting_(false),
     thread_(std::bind(&EventLoopThread::threadFunc, this), name),
-    mutex_(),
+    mutex_("EventLoopThread"),
     cond_(mutex_),
     callback_(cb)
 {
@@ -0,0 +1,356 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_FUTURE_H
+#define MUDUO_NET_FUTURE_H
+
+#include "muduo/base/Atomic.h"
+#include "muduo/base/Mutex.h"
+#include "muduo/base/UniqueFunction.h"
+#include "muduo/net/EventLoop.h"
+
+#include <boost/optional.hpp>
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+template<typename T> class Future;
+template<typename T> class Promise;
+
+namespace detail
+{
+
+// Value and the only continuation of a future.
+template<typename T>
+class FutureState : noncopyable,
+                    public std::enable_shared_from_this<FutureState<T>>
+{
+ public:
+  typedef UniqueFunction<void (T&&)> Continuation;
+
+  FutureState()
+    : ready_(false),
+      loop_(NULL)
+  {
+  }
+
+  void setValue(T&& value)
+  {
+    bool hasContinuation = false;
+    {
+      MutexLockGuard lock(mutex_);
+      assert(!ready_);
+      value_ = std::move(value);
+      ready_ = true;
+      hasContinuation = static_cast<bool>(continuation_);
+    }
+    if (hasContinuation)
+    {
+      dispatch();
+    }
+  }
+
+  void setContinuation(EventLoop* loop, Continuation&& continuation)
+  {
+    {
+      MutexLockGuard lock(mutex_);
+      assert(!continuation_);
+      continuation_ = std::move(continuation);
+      loop_ = loop;
+      if (!ready_)
+        return;
+    }
+    dispatch();
+  }
+
+  bool ready() const
+  {
+    MutexLockGuard lock(mutex_);
+    return ready_;
+  }
+
+  // value_ is written once, before ready_ is set
+  const T& value() const
+  {
+    assert(ready());
+    return *value_;
+  }
+
+ private:
+  // continuation_ and loop_ don't change once both it and the value are set
+  void dispatch()
+  {
+    if (loop_ == NULL)
+    {
+      invoke();
+    }
+    else
+    {
+      std::shared_ptr<FutureState> self(this->shared_from_this());
+      loop_->runInLoop([self] { self->invoke(); });
+    }
+  }
+
+  void invoke()
+  {
+    // releases what it captures right after
+    Continuation continuation(std::move(continuation_));
+    continuation(std::move(*value_));
+  }
+
+  mutable MutexLock mutex_;
+  bool ready_ GUARDED_BY(mutex_);
+  EventLoop* loop_;
+  Continuation continuation_;
+  boost::optional<T> value_;
+};
+
+template<typename T, typename F>
+struct ResultOf
+{
+  typedef typename std::result_of<F(T&&)>::type type;
+};
+
+// then() returns Future<R>, or nothing for a continuation returning void.
+template<typename R>
+struct ThenResult
+{
+  typedef Future<R> type;
+};
+
+template<>
+struct ThenResult<void>
+{
+  typedef void type;
+};
+
+template<typename T, typename F, typename R>
+struct Chain
+{
+  std::shared_ptr<FutureState<R>> next;
+  F f;
+
+  void operator()(T&& value) { next->setValue(f(std::move(value))); }
+};
+
+template<typename T, typename F>
+struct Last
+{
+  F f;
+
+  void operator()(T&& value) { f(std::move(value)); }
+};
+
+template<typename R, typename F>
+struct Offload
+{
+  Promise<R> promise;
+  F f;
+
+  void operator()() { promise.setValue(f()); }
+};
+
+template<typename T>
+struct WhenAll : FutureState<std::vector<T>>
+{
+  explicit WhenAll(size_t n)
+    : values(n)
+  {
+    remaining.getAndSet(static_cast<int32_t>(n));
+  }
+
+  std::vector<T> values;
+  AtomicInt32 remaining;
+};
+
+template<typename T>
+struct WhenAny : FutureState<std::pair<size_t, T>>
+{
+  AtomicInt32 done;
+};
+
+}  // namespace detail
+
+///
+/// The result of an asynchronous operation, for continuations
+/// in a chosen EventLoop.
+///
+///   offload(&threadPool, std::bind(solveSudoku, puzzle))
+///       .then(conn->getLoop(), [conn](const string& result) {
+///         conn->send(result + "\r\n");
+///       });
+///
+/// A future has at most one continuation, which takes the value.
+/// It runs in @c loop, or in the thread setting the value if @c loop is
+/// NULL, or in the calling thread if the value is already set.
+/// A continuation returning void ends the chain and is stored in the
+/// future, without allocating. One returning R gives a Future<R>.
+///
+/// There are no exceptions or broken promises, a continuation never
+/// runs if its promise is destroyed without a value.
+///
+template<typename T>
+class Future : public muduo::copyable
+{
+ public:
+  Future() { }
+
+  bool valid() const { return static_cast<bool>(state_); }
+  bool isReady() const { return state_->ready(); }
+
+  /// Must be ready, and not taken by a continuation.
+  const T& value() const { return state_->value(); }
+
+  template<typename F>
+  typename detail::ThenResult<typename detail::ResultOf<T, F>::type>::type
+  then(EventLoop* loop, F&& f)
+  {
+    typedef typename detail::ResultOf<T, F>::type R;
+    return thenImpl<R>(loop, std::forward<F>(f), std::is_void<R>());
+  }
+
+  /// In the thread setting the value.
+  template<typename F>
+  typename detail::ThenResult<typename detail::ResultOf<T, F>::type>::type
+  then(F&& f)
+  {
+    return then(NULL, std::forward<F>(f));
+  }
+
+ private:
+  template<typename U> friend class Future;
+  friend class Promise<T>;
+  template<typename U>
+  friend Future<std::vector<U>> whenAll(const std::vector<Future<U>>& futures);
+  template<typename U>
+  friend Future<std::pair<size_t, U>> whenAny(const std::vector<Future<U>>& futures);
+
+  typedef std::shared_ptr<detail::FutureState<T>> StatePtr;
+
+  explicit Future(const StatePtr& state)
+    : state_(state)
+  {
+  }
+
+  template<typename R, typename F>
+  Future<R> thenImpl(EventLoop* loop, F&& f, std::false_type)
+  {
+    typedef typename std::decay<F>::type Func;
+    std::shared_ptr<detail::FutureState<R>> next(std::make_shared<detail::FutureState<R>>());
+    state_->setContinuation(loop, detail::Chain<T, Func, R>{ next, std::forward<F>(f) });
+    return Future<R>(next);
+  }
+
+  template<typename R, typename F>
+  void thenImpl(EventLoop* loop, F&& f, std::true_type)
+  {
+    typedef typename std::decay<F>::type Func;
+    state_->setContinuation(loop, detail::Last<T, Func>{ std::forward<F>(f) });
+  }
+
+  StatePtr state_;
+};
+
+///
+/// Sets the value of a Future, once, in any thread.
+///
+template<typename T>
+class Promise : public muduo::copyable
+{
+ public:
+  Promise()
+    : state_(std::make_shared<detail::FutureState<T>>())
+  {
+  }
+
+  Future<T> getFuture() const { return Future<T>(state_); }
+
+  void setValue(T value) const { state_->setValue(std::move(value)); }
+
+ private:
+  std::shared_ptr<detail::FutureState<T>> state_;
+};
+
+template<typename T>
+Future<typename std::decay<T>::type> makeReadyFuture(T&& value)
+{
+  Promise<typename std::decay<T>::type> promise;
+  promise.setValue(std::forward<T>(value));
+  return promise.getFuture();
+}
+
+///
+/// Runs @c f in @c pool, ThreadPool or alike, for its result.
+///
+template<typename Pool, typename F>
+Future<typename std::result_of<F()>::type> offload(Pool* pool, F&& f)
+{
+  typedef typename std::result_of<F()>::type R;
+  Promise<R> promise;
+  pool->run(detail::Offload<R, typename std::decay<F>::type>{ promise, std::forward<F>(f) });
+  return promise.getFuture();
+}
+
+///
+/// Ready when all are ready, with the values in order.
+/// Takes the continuation of each, T must be default constructible.
+///
+template<typename T>
+Future<std::vector<T>> whenAll(const std::vector<Future<T>>& futures)
+{
+  typedef detail::WhenAll<T> State;
+  std::shared_ptr<State> state(std::make_shared<State>(futures.size()));
+  if (futures.empty())
+  {
+    state->setValue(std::vector<T>());
+  }
+  for (size_t i = 0; i < futures.size(); ++i)
+  {
+    futures[i].state_->setContinuation(NULL, [state, i](T&& value) {
+      state->values[i] = std::move(value);
+      if (state->remaining.decrementAndGet() == 0)
+      {
+        state->setValue(std::move(state->values));
+      }
+    });
+  }
+  return Future<std::vector<T>>(state);
+}
+
+///
+/// Ready when the first is, with its index and value.
+/// Takes the continuation of each, @c futures must not be empty.
+///
+template<typename T>
+Future<std::pair<size_t, T>> whenAny(const std::vector<Future<T>>& futures)
+{
+  typedef detail::WhenAny<T> State;
+  assert(!futures.empty());
+  std::shared_ptr<State> state(std::make_shared<State>());
+  for (size_t i = 0; i < futures.size(); ++i)
+  {
+    futures[i].state_->setContinuation(NULL, [state, i](T&& value) {
+      if (state->done.getAndSet(1) == 0)
+      {
+        state->setValue(std::make_pair(i, std::move(value)));
+      }
+    });
+  }
+  return Future<std::pair<size_t, T>>(state);
+}
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_FUTURE_H
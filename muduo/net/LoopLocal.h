@@ -0,0 +1,119 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_LOOPLOCAL_H
+#define MUDUO_NET_LOOPLOCAL_H
+
+#include "muduo/base/copyable.h"
+#include "muduo/base/noncopyable.h"
+#include "muduo/net/EventLoop.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Numbers a fixed set of loops 0 to size()-1, in the given order.
+///
+class LoopIndex : public muduo::copyable
+{
+ public:
+  explicit LoopIndex(const std::vector<EventLoop*>& loops)
+    : loops_(loops)
+  {
+    for (size_t i = 0; i < loops.size(); ++i)
+    {
+      sorted_.push_back(std::make_pair(loops[i], static_cast<int>(i)));
+    }
+    std::sort(sorted_.begin(), sorted_.end());
+  }
+
+  int size() const { return static_cast<int>(loops_.size()); }
+
+  EventLoop* loop(int index) const { return loops_[index]; }
+
+  /// -1 if @c loop is not one of them.
+  int indexOf(EventLoop* loop) const
+  {
+    std::vector<std::pair<EventLoop*, int>>::const_iterator it =
+        std::lower_bound(sorted_.begin(), sorted_.end(), std::make_pair(loop, 0));
+    return it != sorted_.end() && it->first == loop ? it->second : -1;
+  }
+
+  /// Of the loop of the calling thread, -1 if none.
+  int current() const
+  {
+    return indexOf(EventLoop::getEventLoopOfCurrentThread());
+  }
+
+ private:
+  std::vector<EventLoop*> loops_;
+  std::vector<std::pair<EventLoop*, int>> sorted_;
+};
+
+///
+/// One T per loop, used by that loop without locking.
+///
+/// Like ThreadLocalSingleton, but the values are owned by this object
+/// and visible to others, eg. for collecting stats once the loops
+/// have stopped. Values are a cache line apart.
+///
+///   LoopLocal<ConnectionList> connections(server.threadPool()->getAllLoops());
+///   // in onConnection(), in the loop of conn
+///   connections.get().insert(conn);
+///
+template<typename T>
+class LoopLocal : noncopyable
+{
+ public:
+  explicit LoopLocal(const std::vector<EventLoop*>& loops)
+    : index_(loops),
+      values_(loops.size())
+  {
+  }
+
+  /// Of the loop of the calling thread, which must be one of loops.
+  T& get()
+  {
+    int i = index_.current();
+    assert(i >= 0);
+    return values_[i].value;
+  }
+
+  T& get(EventLoop* loop)
+  {
+    int i = index_.indexOf(loop);
+    assert(i >= 0);
+    return values_[i].value;
+  }
+
+  T& at(int index) { return values_[index].value; }
+  const T& at(int index) const { return values_[index].value; }
+
+  int size() const { return index_.size(); }
+  const LoopIndex& index() const { return index_; }
+
+ private:
+  struct Slot
+  {
+    T value;
+    char padding[64];  // against false sharing
+  };
+
+  const LoopIndex index_;
+  std::vector<Slot> values_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_LOOPLOCAL_H
@@ -0,0 +1,88 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/net/LoopMesh.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/Channel.h"
+#include "muduo/net/SocketsOps.h"
+
+#include <sys/eventfd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+using namespace muduo::net::detail;
+
+namespace
+{
+
+int createEventfd()
+{
+  int evtfd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (evtfd < 0)
+  {
+    LOG_SYSFATAL << "Failed in eventfd";
+  }
+  return evtfd;
+}
+
+}  // namespace
+
+MeshInbox::MeshInbox(EventLoop* loop, const DrainCallback& cb)
+  : loop_(loop),
+    eventfd_(createEventfd()),
+    channel_(new Channel(loop, eventfd_)),
+    drainCallback_(cb),
+    signaled_(false)
+{
+  channel_->setReadCallback(std::bind(&MeshInbox::handleRead, this));
+}
+
+MeshInbox::~MeshInbox()
+{
+  sockets::close(eventfd_);
+}
+
+void MeshInbox::start()
+{
+  loop_->assertInLoopThread();
+  channel_->enableReading();
+}
+
+void MeshInbox::stop()
+{
+  loop_->assertInLoopThread();
+  channel_->disableAll();
+  channel_->remove();
+}
+
+void MeshInbox::notify()
+{
+  // pairs with the fence in handleRead(), either it sees the message
+  // just pushed, or we see signaled_ cleared and write the eventfd.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!signaled_.load(std::memory_order_relaxed) && !signaled_.exchange(true))
+  {
+    uint64_t one = 1;
+    ssize_t n = sockets::write(eventfd_, &one, sizeof one);
+    if (n != sizeof one)
+    {
+      LOG_ERROR << "MeshInbox::notify() writes " << n << " bytes instead of 8";
+    }
+  }
+}
+
+void MeshInbox::handleRead()
+{
+  uint64_t count = 0;
+  ssize_t n = sockets::read(eventfd_, &count, sizeof count);
+  if (n != sizeof count)
+  {
+    LOG_ERROR << "MeshInbox::handleRead() reads " << n << " bytes instead of 8";
+  }
+  signaled_.store(false, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  drainCallback_();
+}
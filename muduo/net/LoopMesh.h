@@ -0,0 +1,256 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_LOOPMESH_H
+#define MUDUO_NET_LOOPMESH_H
+
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/noncopyable.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/LoopLocal.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+class Channel;
+
+namespace detail
+{
+
+// Bounded ring of one producer thread and one consumer thread.
+template<typename T>
+class SpscRing : noncopyable
+{
+ public:
+  explicit SpscRing(size_t capacity)
+    : capacity_(roundUp(capacity)),
+      slots_(new Slot[capacity_]),
+      tail_(0),
+      headCache_(0),
+      head_(0)
+  {
+  }
+
+  ~SpscRing()
+  {
+    drain([](T&&) { });
+  }
+
+  // in the producer thread
+  bool push(T&& value)
+  {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - headCache_ == capacity_)
+    {
+      headCache_ = head_.load(std::memory_order_acquire);
+      if (tail - headCache_ == capacity_)
+        return false;
+    }
+    new (&slots_[tail & (capacity_ - 1)]) T(std::move(value));
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // in the consumer thread, takes what is there now
+  template<typename F>
+  size_t drain(F&& f)
+  {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    for (size_t i = head; i != tail; ++i)
+    {
+      T* value = reinterpret_cast<T*>(&slots_[i & (capacity_ - 1)]);
+      f(std::move(*value));
+      value->~T();
+    }
+    head_.store(tail, std::memory_order_release);
+    return tail - head;
+  }
+
+ private:
+  typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Slot;
+
+  static size_t roundUp(size_t n)
+  {
+    size_t capacity = 1;
+    while (capacity < n)
+      capacity *= 2;
+    return capacity;
+  }
+
+  const size_t capacity_;
+  std::unique_ptr<Slot[]> slots_;
+  // written by the producer
+  std::atomic<size_t> tail_;
+  size_t headCache_;
+  char padding_[64];
+  // written by the consumer
+  std::atomic<size_t> head_;
+};
+
+// Wakes up a loop to drain its rings, once for any number of messages
+// sent in the meantime.
+class MeshInbox : noncopyable
+{
+ public:
+  typedef std::function<void()> DrainCallback;
+
+  MeshInbox(EventLoop* loop, const DrainCallback& cb);
+  ~MeshInbox();
+
+  // in the loop thread
+  void start();
+  void stop();
+
+  // in any thread, after pushing to a ring
+  void notify();
+
+ private:
+  void handleRead();
+
+  EventLoop* loop_;
+  const int eventfd_;
+  std::unique_ptr<Channel> channel_;
+  DrainCallback drainCallback_;
+  std::atomic<bool> signaled_;
+};
+
+}  // namespace detail
+
+///
+/// Bounded channels of messages between each pair of a fixed set of
+/// loops, for sharding state across loops without sharing it.
+///
+/// Each ordered pair (from, to) has its own ring of @c capacity slots,
+/// with a single producer and a single consumer, so send() takes no
+/// lock and messages between a pair arrive in order. A loop drains all
+/// its rings in one callback of its loop, whenever it is woken up,
+/// once for however many messages arrived since the last time.
+///
+/// send() must be called in one of the loops, a full ring is reported,
+/// not waited for. Use runInLoop() from other threads.
+///
+///   // in the loop owning the session of key
+///   mesh.send(mesh.index().indexOf(server.threadPool()->getLoopForHash(key)), msg);
+///
+/// Construct and destroy while the loops are looping, in a thread
+/// that is not one of them.
+///
+template<typename T>
+class LoopMesh : noncopyable
+{
+ public:
+  /// In the loop of @c to.
+  typedef std::function<void (int from, T&& message)> MessageCallback;
+
+  LoopMesh(const std::vector<EventLoop*>& loops,
+           size_t capacity,
+           const MessageCallback& cb)
+    : index_(loops),
+      messageCallback_(cb)
+  {
+    int n = index_.size();
+    for (int i = 0; i < n * n; ++i)
+    {
+      rings_.emplace_back(new detail::SpscRing<T>(capacity));
+    }
+    for (int i = 0; i < n; ++i)
+    {
+      inboxes_.emplace_back(new detail::MeshInbox(
+          loops[i], std::bind(&LoopMesh::drain, this, i)));
+    }
+    runInAll(&detail::MeshInbox::start);
+  }
+
+  ~LoopMesh()
+  {
+    runInAll(&detail::MeshInbox::stop);
+  }
+
+  int size() const { return index_.size(); }
+  const LoopIndex& index() const { return index_; }
+
+  /// In a loop of the mesh, to loop @c to, maybe itself.
+  /// False if that ring is full, @c message is left untouched then.
+  bool send(int to, T&& message)
+  {
+    int from = index_.current();
+    assert(from >= 0);
+    if (!ring(from, to)->push(std::move(message)))
+      return false;
+    inboxes_[to]->notify();
+    return true;
+  }
+
+  bool send(int to, const T& message)
+  {
+    T copy(message);
+    return send(to, std::move(copy));
+  }
+
+  /// To all loops including this one, returns the number sent.
+  int broadcast(const T& message)
+  {
+    int sent = 0;
+    for (int to = 0; to < size(); ++to)
+    {
+      if (send(to, message))
+        ++sent;
+    }
+    return sent;
+  }
+
+ private:
+  detail::SpscRing<T>* ring(int from, int to)
+  {
+    return rings_[from * size() + to].get();
+  }
+
+  void drain(int to)
+  {
+    for (int from = 0; from < size(); ++from)
+    {
+      ring(from, to)->drain([this, from](T&& message) {
+        messageCallback_(from, std::move(message));
+      });
+    }
+  }
+
+  void runInAll(void (detail::MeshInbox::*f)())
+  {
+    CountDownLatch latch(size());
+    for (int i = 0; i < size(); ++i)
+    {
+      detail::MeshInbox* inbox = inboxes_[i].get();
+      index_.loop(i)->runInLoop([inbox, f, &latch] {
+        (inbox->*f)();
+        latch.countDown();
+      });
+    }
+    latch.wait();
+  }
+
+  const LoopIndex index_;
+  MessageCallback messageCallback_;
+  std::vector<std::unique_ptr<detail::SpscRing<T>>> rings_;  // from * size() + to
+  std::vector<std::unique_ptr<detail::MeshInbox>> inboxes_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_LOOPMESH_H
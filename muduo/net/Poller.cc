@@ -10,6 +10,8 @@
 
 #include "muduo/net/Channel.h"
 
+#include <algorithm>
+
 using namespace muduo;
 using namespace muduo::net;
 
@@ -23,7 +25,75 @@ Poller::~Poller() = default;
 bool Poller::hasChannel(Channel* channel) const
 {
   assertInLoopThread();
-  ChannelMap::const_iterator it = channels_.find(channel->fd());
-  return it != channels_.end() && it->second == channel;
+  return channels_.find(channel->fd()) == channel;
+}
+
+namespace
+{
+const size_t kMinSlots = 16;
+}  // namespace
+
+void Poller::ChannelMap::insert(int fd, Channel* channel)
+{
+  assert(fd >= 0 && channel != NULL);
+  assert(find(fd) == NULL);
+  if ((size_ + 1) * 4 > slots_.size() * 3)
+  {
+    resize(std::max(kMinSlots, slots_.size() * 2));
+  }
+  size_t mask = slots_.size() - 1;
+  size_t i = hash(fd) & mask;
+  while (slots_[i].channel != NULL)
+  {
+    i = (i + 1) & mask;
+  }
+  slots_[i].fd = fd;
+  slots_[i].channel = channel;
+  ++size_;
 }
 
+size_t Poller::ChannelMap::erase(int fd)
+{
+  if (find(fd) == NULL)
+  {
+    return 0;
+  }
+  size_t mask = slots_.size() - 1;
+  size_t i = hash(fd) & mask;
+  while (slots_[i].fd != fd || slots_[i].channel == NULL)
+  {
+    i = (i + 1) & mask;
+  }
+  // moves back the following ones which would not be found past the hole
+  for (size_t j = (i + 1) & mask; slots_[j].channel != NULL; j = (j + 1) & mask)
+  {
+    size_t home = hash(slots_[j].fd) & mask;
+    if (((j - home) & mask) >= ((j - i) & mask))
+    {
+      slots_[i] = slots_[j];
+      i = j;
+    }
+  }
+  slots_[i].channel = NULL;
+  --size_;
+  // gives back the memory after a burst of connections
+  if (slots_.size() > kMinSlots && size_ * 8 < slots_.size())
+  {
+    resize(slots_.size() / 2);
+  }
+  return 1;
+}
+
+void Poller::ChannelMap::resize(size_t capacity)
+{
+  std::vector<Slot> old(capacity, Slot{ -1, NULL });
+  old.swap(slots_);
+  size_ = 0;
+  for (const Slot& slot : old)
+  {
+    if (slot.channel != NULL)
+    {
+      insert(slot.fd, slot.channel);
+    }
+  }
+}
@@ -11,7 +11,6 @@
 #ifndef MUDUO_NET_POLLER_H
 #define MUDUO_NET_POLLER_H
 
-#include <map>
 #include <vector>
 
 #include "muduo/base/Timestamp.h"
@@ -58,7 +57,52 @@ class Poller : noncopyable
   }
 
  protected:
-  typedef std::map<int, Channel*> ChannelMap;
+  /// Channels by fd, in an open addressing hash table sized to the
+  /// channels of this loop. A vector indexed by fd would be sized to the
+  /// largest fd of the process in every loop, a std::map costs a tree
+  /// node per channel. A slot is 16 bytes, at most 3/4 of them are used.
+  class ChannelMap
+  {
+   public:
+    ChannelMap() : size_(0) {}
+
+    /// NULL if fd has no channel.
+    Channel* find(int fd) const
+    {
+      if (slots_.empty())
+      {
+        return NULL;
+      }
+      size_t mask = slots_.size() - 1;
+      for (size_t i = hash(fd) & mask; slots_[i].channel != NULL; i = (i + 1) & mask)
+      {
+        if (slots_[i].fd == fd)
+        {
+          return slots_[i].channel;
+        }
+      }
+      return NULL;
+    }
+    void insert(int fd, Channel* channel);
+    /// returns the number of channels removed, 0 or 1.
+    size_t erase(int fd);
+    size_t size() const { return size_; }
+
+   private:
+    struct Slot
+    {
+      int fd;
+      Channel* channel;  // NULL if empty
+    };
+
+    // consecutive fds go to consecutive slots
+    static size_t hash(int fd) { return static_cast<size_t>(fd) * 0x9E3779B1u; }
+    void resize(size_t capacity);
+
+    std::vector<Slot> slots_;  // power of 2
+    size_t size_;
+  };
+
   ChannelMap channels_;
 
  private:
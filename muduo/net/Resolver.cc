@@ -0,0 +1,554 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/net/Resolver.h"
+
+#include "muduo/base/FileUtil.h"
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/Endian.h"
+
+#include <algorithm>
+
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <sys/random.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// RFC 1035
+//
+//  message: header, question, answer, authority, additional
+//
+//  header:  ID, flags (QR Opcode AA TC RD RA Z RCODE), QDCOUNT, ANCOUNT, NSCOUNT, ARCOUNT
+//  question: QNAME, QTYPE, QCLASS
+//  resource record: NAME, TYPE, CLASS, TTL, RDLENGTH, RDATA
+
+namespace
+{
+
+const int kHeaderSize = 12;
+const size_t kMaxNameLength = 253;
+const size_t kMaxLabelLength = 63;
+const uint16_t kTypeA = 1;
+const uint16_t kTypeSoa = 6;
+const uint16_t kClassIn = 1;
+const uint16_t kFlagResponse = 0x8000;
+const uint16_t kFlagTruncated = 0x0200;
+const uint16_t kFlagRecursionDesired = 0x0100;
+const int kRcodeNoError = 0;
+const int kRcodeNxDomain = 3;
+const int kMaxFileSize = 1024*1024;
+const int kMaxUdpSize = 512;  // without EDNS
+
+uint16_t get16(const unsigned char* p)
+{
+  return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+uint32_t get32(const unsigned char* p)
+{
+  return (static_cast<uint32_t>(get16(p)) << 16) | get16(p + 2);
+}
+
+void put16(string* out, uint16_t x)
+{
+  out->push_back(static_cast<char>(x >> 8));
+  out->push_back(static_cast<char>(x & 0xff));
+}
+
+// Lowercase, without the trailing dot, empty if it's not a valid name.
+string normalize(StringPiece name)
+{
+  if (name.size() > 0 && name[name.size() - 1] == '.')
+  {
+    name.remove_suffix(1);
+  }
+  string result;
+  if (name.empty() || implicit_cast<size_t>(name.size()) > kMaxNameLength)
+  {
+    return result;
+  }
+  result.reserve(name.size());
+  size_t labelLength = 0;
+  for (int i = 0; i < name.size(); ++i)
+  {
+    char c = name[i];
+    if (c == '.')
+    {
+      if (labelLength == 0)
+        return string();
+      labelLength = 0;
+    }
+    else if (++labelLength > kMaxLabelLength || isspace(static_cast<unsigned char>(c)))
+    {
+      return string();
+    }
+    result.push_back(static_cast<char>(tolower(static_cast<unsigned char>(c))));
+  }
+  return labelLength > 0 ? result : string();
+}
+
+// Reads a possibly compressed name at *pos, advances *pos past it.
+// Returns false if it's malformed.
+bool readName(const unsigned char* msg, size_t len, size_t* pos, string* name)
+{
+  size_t cur = *pos;
+  bool jumped = false;
+  for (int hops = 0; hops < 64; )
+  {
+    if (cur >= len)
+      return false;
+    unsigned char c = msg[cur];
+    if (c == 0)
+    {
+      if (!jumped)
+        *pos = cur + 1;
+      return true;
+    }
+    else if ((c & 0xC0) == 0xC0)
+    {
+      if (cur + 2 > len)
+        return false;
+      if (!jumped)
+        *pos = cur + 2;
+      jumped = true;
+      cur = get16(msg + cur) & 0x3FFF;
+      ++hops;
+    }
+    else if (c & 0xC0)
+    {
+      return false;
+    }
+    else
+    {
+      if (cur + 1 + c > len)
+        return false;
+      if (name)
+      {
+        if (!name->empty())
+          name->push_back('.');
+        for (size_t i = 0; i < c; ++i)
+        {
+          name->push_back(static_cast<char>(tolower(msg[cur + 1 + i])));
+        }
+      }
+      cur += 1 + c;
+    }
+  }
+  return false;
+}
+
+string buildQuery(uint16_t id, const string& name)
+{
+  string query;
+  query.reserve(kHeaderSize + name.size() + 6);
+  put16(&query, id);
+  put16(&query, kFlagRecursionDesired);
+  put16(&query, 1);  // QDCOUNT
+  put16(&query, 0);
+  put16(&query, 0);
+  put16(&query, 0);
+  size_t start = 0;
+  while (start <= name.size())
+  {
+    size_t dot = name.find('.', start);
+    if (dot == string::npos)
+      dot = name.size();
+    query.push_back(static_cast<char>(dot - start));
+    query.append(name, start, dot - start);
+    start = dot + 1;
+  }
+  query.push_back('\0');
+  put16(&query, kTypeA);
+  put16(&query, kClassIn);
+  return query;
+}
+
+struct Answer
+{
+  int rcode;
+  bool truncated;
+  std::vector<InetAddress> addresses;
+  uint32_t ttl;  // min of A records, or of SOA for negative answers
+};
+
+bool parseAnswer(const unsigned char* msg, size_t len, const string& name, Answer* answer)
+{
+  if (len < kHeaderSize)
+    return false;
+  uint16_t flags = get16(msg + 2);
+  if (!(flags & kFlagResponse))
+    return false;
+  answer->rcode = flags & 0xF;
+  answer->truncated = (flags & kFlagTruncated) != 0;
+  answer->ttl = UINT32_MAX;
+  int qdcount = get16(msg + 4);
+  int ancount = get16(msg + 6);
+  int nscount = get16(msg + 8);
+  if (qdcount != 1)
+    return false;
+
+  size_t pos = kHeaderSize;
+  string qname;
+  if (!readName(msg, len, &pos, &qname) || qname != name || pos + 4 > len
+      || get16(msg + pos) != kTypeA || get16(msg + pos + 2) != kClassIn)
+  {
+    return false;
+  }
+  pos += 4;
+
+  uint32_t soaTtl = UINT32_MAX;
+  for (int i = 0; i < ancount + nscount; ++i)
+  {
+    if (!readName(msg, len, &pos, NULL) || pos + 10 > len)
+      return false;
+    uint16_t type = get16(msg + pos);
+    uint16_t klass = get16(msg + pos + 2);
+    uint32_t ttl = get32(msg + pos + 4);
+    uint16_t rdlength = get16(msg + pos + 8);
+    pos += 10;
+    if (pos + rdlength > len)
+      return false;
+    if (i < ancount && type == kTypeA && klass == kClassIn && rdlength == 4)
+    {
+      // CNAMEs are followed by the A records of their targets,
+      // so all A records in the answer section belong to the name.
+      struct sockaddr_in addr;
+      memZero(&addr, sizeof addr);
+      addr.sin_family = AF_INET;
+      memcpy(&addr.sin_addr, msg + pos, 4);
+      answer->addresses.push_back(InetAddress(addr));
+      answer->ttl = std::min(answer->ttl, ttl);
+    }
+    else if (i >= ancount && type == kTypeSoa)
+    {
+      // RFC 2308, min of the TTL and the MINIMUM field, the last of RDATA
+      if (rdlength < 4)
+        return false;
+      soaTtl = std::min(ttl, get32(msg + pos + rdlength - 4));
+    }
+    pos += rdlength;
+  }
+  if (answer->addresses.empty())
+  {
+    answer->ttl = soaTtl;
+  }
+  return true;
+}
+
+// Splits line by spaces, dropping comments.
+std::vector<StringPiece> split(StringPiece line)
+{
+  std::vector<StringPiece> tokens;
+  const char* p = line.begin();
+  const char* end = line.end();
+  while (p < end && *p != '#' && *p != ';')
+  {
+    if (isspace(static_cast<unsigned char>(*p)))
+    {
+      ++p;
+      continue;
+    }
+    const char* start = p;
+    while (p < end && !isspace(static_cast<unsigned char>(*p)))
+      ++p;
+    tokens.push_back(StringPiece(start, static_cast<int>(p - start)));
+  }
+  return tokens;
+}
+
+bool parseIpv4(const string& ip, InetAddress* result)
+{
+  struct sockaddr_in addr;
+  memZero(&addr, sizeof addr);
+  addr.sin_family = AF_INET;
+  if (::inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) != 1)
+    return false;
+  *result = InetAddress(addr);
+  return true;
+}
+
+// Not from a PRNG seeded by time or pid, which a spoofer could guess.
+uint16_t randomId()
+{
+  uint16_t id = 0;
+  if (::getrandom(&id, sizeof id, 0) != static_cast<ssize_t>(sizeof id))
+  {
+    LOG_SYSFATAL << "Resolver - getrandom";
+  }
+  return id;
+}
+
+}  // namespace
+
+Resolver::Resolver(EventLoop* loop, const string& resolvConf, const string& hostsFile)
+  : loop_(CHECK_NOTNULL(loop)),
+    timeout_(5.0),
+    attempts_(2),
+    maxTtl_(24*3600),
+    negativeTtl_(300),
+    maxCacheSize_(10000),
+    numQueries_(0),
+    numCacheHits_(0),
+    numCoalesced_(0)
+{
+  if (!resolvConf.empty())
+    loadResolvConf(resolvConf);
+  if (nameServers_.empty())
+    nameServers_.push_back(InetAddress("127.0.0.1", 53));
+  if (!hostsFile.empty())
+    loadHostsFile(hostsFile);
+}
+
+Resolver::~Resolver()
+{
+  loop_->assertInLoopThread();
+  for (const auto& item : queries_)
+  {
+    loop_->cancel(item.second.timer);
+    item.second.socket->stop();
+  }
+}
+
+void Resolver::loadResolvConf(const string& path)
+{
+  string content;
+  int err = FileUtil::readFile(path, kMaxFileSize, &content);
+  if (err != 0)
+  {
+    LOG_WARN << "Resolver - cannot read " << path << ": " << strerror_tl(err);
+    return;
+  }
+  FileUtil::LineIterator lines(content.data(), content.data() + content.size());
+  StringPiece line;
+  while (lines.next(&line))
+  {
+    std::vector<StringPiece> tokens = split(line);
+    if (tokens.size() >= 2 && tokens[0] == "nameserver")
+    {
+      InetAddress server;
+      if (parseIpv4(tokens[1].as_string(), &server))
+      {
+        nameServers_.push_back(InetAddress(server.toIp(), 53));
+      }
+      else
+      {
+        LOG_WARN << "Resolver - unsupported name server " << tokens[1];
+      }
+    }
+    else if (tokens.size() >= 2 && tokens[0] == "options")
+    {
+      for (size_t i = 1; i < tokens.size(); ++i)
+      {
+        if (tokens[i].starts_with("timeout:"))
+          timeout_ = std::max(1, atoi(tokens[i].as_string().c_str() + 8));
+        else if (tokens[i].starts_with("attempts:"))
+          attempts_ = std::max(1, atoi(tokens[i].as_string().c_str() + 9));
+      }
+    }
+  }
+}
+
+void Resolver::loadHostsFile(const string& path)
+{
+  string content;
+  int err = FileUtil::readFile(path, kMaxFileSize, &content);
+  if (err != 0)
+  {
+    LOG_WARN << "Resolver - cannot read " << path << ": " << strerror_tl(err);
+    return;
+  }
+  FileUtil::LineIterator lines(content.data(), content.data() + content.size());
+  StringPiece line;
+  while (lines.next(&line))
+  {
+    std::vector<StringPiece> tokens = split(line);
+    InetAddress addr;
+    if (tokens.size() < 2 || !parseIpv4(tokens[0].as_string(), &addr))
+      continue;  // IPv6
+    for (size_t i = 1; i < tokens.size(); ++i)
+    {
+      string name = normalize(tokens[i]);
+      if (!name.empty())
+        hosts_[name].push_back(addr);
+    }
+  }
+}
+
+void Resolver::resolve(StringArg hostname, const Callback& cb)
+{
+  loop_->assertInLoopThread();
+  InetAddress numeric;
+  if (parseIpv4(hostname.c_str(), &numeric))
+  {
+    cb(std::vector<InetAddress>(1, numeric));
+    return;
+  }
+
+  string name = normalize(hostname.c_str());
+  if (name.empty())
+  {
+    LOG_ERROR << "Resolver::resolve - invalid name " << hostname.c_str();
+    cb(std::vector<InetAddress>());
+    return;
+  }
+
+  auto host = hosts_.find(name);
+  if (host != hosts_.end())
+  {
+    cb(host->second);
+    return;
+  }
+
+  auto cached = cache_.find(name);
+  if (cached != cache_.end())
+  {
+    if (cached->second.expiration > MonotonicTimestamp::now())
+    {
+      ++numCacheHits_;
+      cb(cached->second.addresses);
+      return;
+    }
+    cache_.erase(cached);
+  }
+
+  auto pending = queries_.find(name);
+  if (pending != queries_.end())
+  {
+    ++numCoalesced_;
+    pending->second.callbacks.push_back(cb);
+    return;
+  }
+
+  Query& query = queries_[name];
+  query.id = randomId();
+  query.tries = 0;
+  query.callbacks.push_back(cb);
+  // IDs needn't be unique, the socket tells which query an answer is for.
+  query.socket.reset(new UdpSocket(loop_, InetAddress(0)));
+  query.socket->setBatch(1, kMaxUdpSize);
+  query.socket->setDatagramCallback(
+      std::bind(&Resolver::onDatagram, this, name, _2, _3));
+  query.socket->start();
+  sendQuery(name, &query);
+}
+
+void Resolver::sendQuery(const string& name, Query* query)
+{
+  const InetAddress& server = nameServers_[query->tries % nameServers_.size()];
+  LOG_DEBUG << "Resolver::sendQuery " << name << " to " << server.toIpPort()
+            << " id " << query->id;
+  query->socket->send(server, buildQuery(query->id, name));
+  ++query->tries;
+  ++numQueries_;
+  query->timer = loop_->runAfter(timeout_, std::bind(&Resolver::onTimeout, this, name, query->id));
+}
+
+void Resolver::onTimeout(const string& name, uint16_t id)
+{
+  auto it = queries_.find(name);
+  if (it == queries_.end() || it->second.id != id)
+    return;
+  Query& query = it->second;
+  LOG_DEBUG << "Resolver::onTimeout " << name << " tries " << query.tries;
+  if (query.tries < attempts_ * static_cast<int>(nameServers_.size()))
+  {
+    sendQuery(name, &query);
+  }
+  else
+  {
+    LOG_WARN << "Resolver - no answer for " << name << " after " << query.tries << " tries";
+    finish(name, std::vector<InetAddress>(), 0);
+  }
+}
+
+void Resolver::onDatagram(const string& name, const InetAddress& peer, StringPiece datagram)
+{
+  if (datagram.size() < kHeaderSize)
+    return;
+  const unsigned char* msg = reinterpret_cast<const unsigned char*>(datagram.data());
+  uint16_t id = get16(msg);
+  auto it = queries_.find(name);
+  bool fromServer = false;
+  for (const InetAddress& server : nameServers_)
+  {
+    fromServer = fromServer || (server.ipv4NetEndian() == peer.ipv4NetEndian()
+                                && server.portNetEndian() == peer.portNetEndian());
+  }
+  if (it == queries_.end() || it->second.id != id || !fromServer)
+  {
+    LOG_DEBUG << "Resolver - unexpected answer from " << peer.toIpPort() << " id " << id;
+    return;
+  }
+
+  Answer answer;
+  if (!parseAnswer(msg, datagram.size(), name, &answer))
+  {
+    LOG_WARN << "Resolver - malformed answer from " << peer.toIpPort() << " for " << name;
+    return;  // wait for timeout
+  }
+
+  if (answer.rcode == kRcodeNoError && !answer.addresses.empty())
+  {
+    finish(name, answer.addresses, static_cast<int>(std::min<uint32_t>(answer.ttl, maxTtl_)));
+  }
+  else if ((answer.rcode == kRcodeNxDomain || answer.rcode == kRcodeNoError) && !answer.truncated)
+  {
+    // non-existent, or no A records
+    finish(name, answer.addresses, static_cast<int>(std::min<uint32_t>(answer.ttl, negativeTtl_)));
+  }
+  else
+  {
+    // SERVFAIL, REFUSED, etc. try next server
+    loop_->cancel(it->second.timer);
+    onTimeout(name, id);
+  }
+}
+
+void Resolver::finish(const string& name, const std::vector<InetAddress>& addresses, int ttl)
+{
+  auto it = queries_.find(name);
+  assert(it != queries_.end());
+  std::vector<Callback> callbacks;
+  callbacks.swap(it->second.callbacks);
+  loop_->cancel(it->second.timer);
+  // safe in its own datagram callback, the channel holds a tie
+  it->second.socket->stop();
+  queries_.erase(it);
+
+  if (ttl > 0)
+  {
+    addCache(name, addresses, ttl);
+  }
+  for (const Callback& cb : callbacks)
+  {
+    cb(addresses);
+  }
+}
+
+void Resolver::addCache(const string& name, const std::vector<InetAddress>& addresses, int ttl)
+{
+  MonotonicTimestamp now = MonotonicTimestamp::now();
+  if (cache_.size() >= maxCacheSize_)
+  {
+    for (auto it = cache_.begin(); it != cache_.end(); )
+    {
+      if (it->second.expiration <= now)
+        it = cache_.erase(it);
+      else
+        ++it;
+    }
+    if (cache_.size() >= maxCacheSize_)
+    {
+      cache_.clear();
+    }
+  }
+  CacheEntry& entry = cache_[name];
+  entry.addresses = addresses;
+  entry.expiration = addTime(now, ttl);
+}
@@ -0,0 +1,132 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_RESOLVER_H
+#define MUDUO_NET_RESOLVER_H
+
+#include "muduo/base/noncopyable.h"
+#include "muduo/base/StringPiece.h"
+#include "muduo/base/Timestamp.h"
+#include "muduo/base/Types.h"
+#include "muduo/net/InetAddress.h"
+#include "muduo/net/TimerId.h"
+#include "muduo/net/UdpSocket.h"
+
+#include <functional>
+#include <map>
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+class EventLoop;
+
+///
+/// Asynchronous DNS resolver of IPv4 addresses, driven by an EventLoop.
+///
+/// Looks up the hosts file, then the cache, then asks the name servers
+/// of resolv.conf over UDP, trying them in turn on timeout.
+/// Answers are cached for their TTL, non-existent names for the TTL of
+/// the SOA record, up to setNegativeTtl().
+/// Concurrent lookups of a name share one query.
+/// Each query is sent from a socket of its own, bound to an ephemeral port
+/// which the kernel picks at random, with a random ID from getrandom(2),
+/// so an off-path spoofer has to guess both.
+///
+/// Not thread safe, all member functions must be called in loop thread,
+/// use one Resolver per loop.
+/// Search domains and TCP fallback of truncated answers are not supported.
+class Resolver : noncopyable
+{
+ public:
+  /// Addresses of the name, port is 0, empty if it fails.
+  typedef std::function<void (const std::vector<InetAddress>&)> Callback;
+
+  /// Empty path means not to read it, without name servers 127.0.0.1 is used.
+  explicit Resolver(EventLoop* loop,
+                    const string& resolvConf = "/etc/resolv.conf",
+                    const string& hostsFile = "/etc/hosts");
+  ~Resolver();
+
+  /// Replaces name servers of resolv.conf, e.g. for testing.
+  void setNameServers(const std::vector<InetAddress>& servers)
+  { nameServers_ = servers; }
+  const std::vector<InetAddress>& nameServers() const { return nameServers_; }
+
+  /// Seconds to wait for each name server, 5 by default
+  /// or "options timeout:n" in resolv.conf.
+  void setTimeout(double seconds) { timeout_ = seconds; }
+  /// Rounds over all name servers, 2 by default
+  /// or "options attempts:n" in resolv.conf.
+  void setAttempts(int attempts) { attempts_ = attempts; }
+  /// Caps of TTL, 1 day for answers and 5 minutes for non-existent names.
+  void setMaxTtl(int seconds) { maxTtl_ = seconds; }
+  void setNegativeTtl(int seconds) { negativeTtl_ = seconds; }
+  /// Entries in cache, 10000 by default.
+  void setMaxCacheSize(size_t entries) { maxCacheSize_ = entries; }
+
+  /// Resolves hostname, or a dotted decimal IPv4 address.
+  /// @c cb is called before returning if it's answered by the hosts file
+  /// or the cache, and later in loop thread otherwise.
+  void resolve(StringArg hostname, const Callback& cb);
+
+  void clearCache() { cache_.clear(); }
+  size_t cacheSize() const { return cache_.size(); }
+
+  /// Queries sent to name servers, including retries.
+  int64_t numQueries() const { return numQueries_; }
+  int64_t numCacheHits() const { return numCacheHits_; }
+  /// Lookups which joined a pending query.
+  int64_t numCoalesced() const { return numCoalesced_; }
+
+ private:
+  struct Query
+  {
+    uint16_t id;
+    int tries;
+    TimerId timer;
+    UdpSocketPtr socket;
+    std::vector<Callback> callbacks;
+  };
+
+  struct CacheEntry
+  {
+    std::vector<InetAddress> addresses;  // empty for non-existent names
+    MonotonicTimestamp expiration;
+  };
+
+  void loadResolvConf(const string& path);
+  void loadHostsFile(const string& path);
+  void sendQuery(const string& name, Query* query);
+  void onTimeout(const string& name, uint16_t id);
+  void onDatagram(const string& name, const InetAddress& peer, StringPiece datagram);
+  void finish(const string& name, const std::vector<InetAddress>& addresses, int ttl);
+  void addCache(const string& name, const std::vector<InetAddress>& addresses, int ttl);
+
+  EventLoop* loop_;
+  std::vector<InetAddress> nameServers_;
+  double timeout_;
+  int attempts_;
+  int maxTtl_;
+  int negativeTtl_;
+  size_t maxCacheSize_;
+
+  std::map<string, std::vector<InetAddress>> hosts_;
+  std::map<string, CacheEntry> cache_;
+  std::map<string, Query> queries_;  // pending, by name
+
+  int64_t numQueries_;
+  int64_t numCacheHits_;
+  int64_t numCoalesced_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_RESOLVER_H
@@ -0,0 +1,298 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/net/SlabPool.h"
+
+#include "muduo/base/Atomic.h"
+#include "muduo/base/Types.h"
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+AtomicInt32 g_disabled;
+
+}  // namespace
+
+// in front of each block, keeps blocks 16-byte aligned
+struct SlabPool::Header
+{
+  Slab* slab;  // NULL if from the heap
+  union
+  {
+    SlabPool* pool;  // of a block from the heap, NULL without a pool
+    Header* next;  // in a free list
+  };
+};
+
+// at the beginning of each slab
+struct SlabPool::Slab
+{
+  SlabPool* pool;
+  Slab* prev;  // in the SlabList of its size class, if it has free blocks
+  Slab* next;
+  Header* freeList;
+  char* unused;  // not yet carved
+  size_t sizeClass;
+  int numAllocated;
+  bool inList;
+  bool shared;  // allocated in other threads, guarded by mutex_
+};
+
+void SlabPool::setEnabled(bool on)
+{
+  g_disabled.getAndSet(on ? 0 : 1);
+}
+
+bool SlabPool::enabled()
+{
+  return g_disabled.get() == 0;
+}
+
+SlabPool::SlabPool()
+  : ownerTid_(CurrentThread::tid()),
+    remoteFrees_(NULL),
+    numRefs_(1),
+    numSlabs_(0)
+{
+  static_assert(sizeof(Header) <= kHeaderSize, "Header too large");
+  static_assert(sizeof(Slab) <= kSlabHeaderSize, "Slab too large");
+  memZero(local_, sizeof local_);
+  memZero(shared_, sizeof shared_);
+}
+
+SlabPool::~SlabPool()
+{
+  // all blocks are returned, the slabs are empty or will be
+  putRemoteBlocks();
+  for (SlabList* lists : { local_, shared_ })
+  {
+    for (size_t i = 0; i < kNumClasses; ++i)
+    {
+      while (Slab* slab = lists[i].head)
+      {
+        assert(slab->numAllocated == 0);
+        remove(&lists[i], slab);
+        ::operator delete(slab);
+      }
+    }
+  }
+}
+
+void SlabPool::release()
+{
+  if (unref())
+  {
+    delete this;
+  }
+}
+
+bool SlabPool::unref()
+{
+  return numRefs_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+}
+
+bool SlabPool::inOwnerThread() const
+{
+  return CurrentThread::tid() == ownerTid_;
+}
+
+void* SlabPool::allocate(SlabPool* pool, size_t size)
+{
+  if (pool)
+  {
+    return pool->allocateBlock(size);
+  }
+  Header* header = static_cast<Header*>(::operator new(kHeaderSize + size));
+  header->slab = NULL;
+  header->pool = NULL;
+  return reinterpret_cast<char*>(header) + kHeaderSize;
+}
+
+void SlabPool::deallocate(void* p)
+{
+  Header* header = reinterpret_cast<Header*>(static_cast<char*>(p) - kHeaderSize);
+  Slab* slab = header->slab;
+  if (slab == NULL)
+  {
+    SlabPool* pool = header->pool;
+    ::operator delete(header);
+    if (pool && pool->unref())
+    {
+      delete pool;
+    }
+    return;
+  }
+
+  SlabPool* pool = slab->pool;
+  if (slab->shared)
+  {
+    MutexLockGuard lock(pool->mutex_);
+    pool->putBlock(&pool->shared_[slab->sizeClass], header);
+  }
+  else if (pool->inOwnerThread())
+  {
+    pool->putBlock(&pool->local_[slab->sizeClass], header);
+  }
+  else
+  {
+    header->next = pool->remoteFrees_.load(std::memory_order_relaxed);
+    while (!pool->remoteFrees_.compare_exchange_weak(header->next, header,
+                                                     std::memory_order_release,
+                                                     std::memory_order_relaxed))
+    {
+    }
+  }
+  if (pool->unref())
+  {
+    delete pool;
+  }
+}
+
+void* SlabPool::allocateBlock(size_t size)
+{
+  numRefs_.fetch_add(1, std::memory_order_relaxed);
+  size_t sizeClass = (kHeaderSize + size + kGranularity - 1) / kGranularity;
+  Header* header = NULL;
+  if (sizeClass >= kNumClasses)
+  {
+    header = static_cast<Header*>(::operator new(kHeaderSize + size));
+    header->slab = NULL;
+    header->pool = this;
+  }
+  else if (inOwnerThread())
+  {
+    if (remoteFrees_.load(std::memory_order_relaxed) != NULL)
+    {
+      putRemoteBlocks();
+    }
+    header = takeBlock(&local_[sizeClass], sizeClass, false);
+  }
+  else
+  {
+    MutexLockGuard lock(mutex_);
+    header = takeBlock(&shared_[sizeClass], sizeClass, true);
+  }
+  return reinterpret_cast<char*>(header) + kHeaderSize;
+}
+
+SlabPool::Header* SlabPool::takeBlock(SlabList* list, size_t sizeClass, bool shared)
+{
+  const size_t blockSize = sizeClass * kGranularity;
+  Slab* slab = list->head;
+  if (slab == NULL)
+  {
+    slab = static_cast<Slab*>(::operator new(kSlabSize));
+    slab->pool = this;
+    slab->freeList = NULL;
+    slab->unused = reinterpret_cast<char*>(slab) + kSlabHeaderSize;
+    slab->sizeClass = sizeClass;
+    slab->numAllocated = 0;
+    slab->inList = false;
+    slab->shared = shared;
+    numSlabs_.fetch_add(1, std::memory_order_relaxed);
+    append(list, slab);
+    ++list->numEmpty;
+  }
+
+  Header* header = slab->freeList;
+  if (header)
+  {
+    slab->freeList = header->next;
+  }
+  else
+  {
+    header = reinterpret_cast<Header*>(slab->unused);
+    slab->unused += blockSize;
+  }
+  if (slab->numAllocated++ == 0)
+  {
+    --list->numEmpty;
+  }
+  const char* end = reinterpret_cast<char*>(slab) + kSlabSize;
+  if (slab->freeList == NULL && static_cast<size_t>(end - slab->unused) < blockSize)
+  {
+    remove(list, slab);  // full
+  }
+  header->slab = slab;
+  return header;
+}
+
+void SlabPool::putBlock(SlabList* list, Header* header)
+{
+  Slab* slab = header->slab;
+  header->next = slab->freeList;
+  slab->freeList = header;
+  if (!slab->inList)
+  {
+    append(list, slab);
+  }
+  if (--slab->numAllocated == 0)
+  {
+    if (list->numEmpty > 0)
+    {
+      remove(list, slab);
+      ::operator delete(slab);
+      numSlabs_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    else
+    {
+      // a spare, taken after the partly used ones
+      ++list->numEmpty;
+      remove(list, slab);
+      append(list, slab);
+    }
+  }
+}
+
+void SlabPool::putRemoteBlocks()
+{
+  Header* header = remoteFrees_.exchange(NULL, std::memory_order_acquire);
+  while (header)
+  {
+    Header* next = header->next;
+    putBlock(&local_[header->slab->sizeClass], header);
+    header = next;
+  }
+}
+
+void SlabPool::append(SlabList* list, Slab* slab)
+{
+  assert(!slab->inList);
+  slab->prev = list->tail;
+  slab->next = NULL;
+  if (list->tail)
+    list->tail->next = slab;
+  else
+    list->head = slab;
+  list->tail = slab;
+  slab->inList = true;
+}
+
+void SlabPool::remove(SlabList* list, Slab* slab)
+{
+  assert(slab->inList);
+  if (slab->prev)
+    slab->prev->next = slab->next;
+  else
+    list->head = slab->next;
+  if (slab->next)
+    slab->next->prev = slab->prev;
+  else
+    list->tail = slab->prev;
+  slab->inList = false;
+}
+
+int64_t SlabPool::numAllocated() const
+{
+  return numRefs_.load(std::memory_order_relaxed) - 1;
+}
+
+int64_t SlabPool::numReservedBytes() const
+{
+  return numSlabs_.load(std::memory_order_relaxed) * static_cast<int64_t>(kSlabSize);
+}
@@ -0,0 +1,168 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_SLABPOOL_H
+#define MUDUO_NET_SLABPOOL_H
+
+#include "muduo/base/Mutex.h"
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Blocks carved from 64KiB slabs, in free lists by size, one pool per EventLoop.
+///
+/// TcpServer and TcpClient allocate TcpConnection with its shared_ptr
+/// control block, Socket and Channel from the pool of the loop of the
+/// connection. Freed in whichever thread, a block goes back to the free
+/// list of its pool, to be reused by the next connection of that loop,
+/// instead of to the malloc arena of another thread.
+///
+/// Each slab holds blocks of one size. In the thread which creates the
+/// pool, i.e. the loop thread, blocks are allocated and freed without a
+/// lock. Blocks of those slabs freed in other threads are pushed onto a
+/// lock-free list, taken back by the next allocation in the loop thread.
+/// Blocks allocated in other threads, e.g. by the acceptor loop of a
+/// TcpServer with io threads, are from slabs of their own under a mutex.
+/// A slab is freed once empty, but one empty slab of each size is kept.
+///
+class SlabPool : noncopyable
+{
+ public:
+  /// For std::unique_ptr of objects from make().
+  struct Deleter
+  {
+    template<typename T>
+    void operator()(T* p) const
+    {
+      p->~T();
+      SlabPool::deallocate(p);
+    }
+  };
+
+  /// Loops created afterwards have no pool if off, on by default.
+  static void setEnabled(bool on);
+  static bool enabled();
+
+  SlabPool();
+
+  /// Instead of delete, the pool is freed once all blocks are returned.
+  void release();
+
+  /// From the heap if @c pool is NULL.
+  static void* allocate(SlabPool* pool, size_t size);
+  /// In any thread, @c p is from allocate() of any pool.
+  static void deallocate(void* p);
+
+  template<typename T, typename... Args>
+  static std::unique_ptr<T, Deleter> make(SlabPool* pool, Args&&... args)
+  {
+    void* p = allocate(pool, sizeof(T));
+    return std::unique_ptr<T, Deleter>(new (p) T(std::forward<Args>(args)...));
+  }
+
+  /// Blocks not yet returned.
+  int64_t numAllocated() const;
+  /// Bytes of slabs.
+  int64_t numReservedBytes() const;
+
+ private:
+  ~SlabPool();
+
+  struct Header;
+  struct Slab;
+  // slabs with free blocks, of a size class
+  struct SlabList
+  {
+    Slab* head;
+    Slab* tail;
+    int numEmpty;
+  };
+
+  static const size_t kHeaderSize = 16;
+  static const size_t kSlabHeaderSize = 64;
+  static const size_t kGranularity = 16;
+  static const size_t kMaxBlockSize = 4096;  // larger ones from the heap
+  static const size_t kNumClasses = kMaxBlockSize / kGranularity + 1;
+  static const size_t kSlabSize = 64 * 1024;
+
+  bool inOwnerThread() const;
+  void* allocateBlock(size_t size);
+  Header* takeBlock(SlabList* list, size_t sizeClass, bool shared);
+  void putBlock(SlabList* list, Header* header);
+  void putRemoteBlocks();
+  // true if it's the last reference
+  bool unref();
+
+  static void append(SlabList* list, Slab* slab);
+  static void remove(SlabList* list, Slab* slab);
+
+  const pid_t ownerTid_;
+  SlabList local_[kNumClasses];  // in owner thread
+  std::atomic<Header*> remoteFrees_;  // of local_, freed in other threads
+  mutable MutexLock mutex_;
+  SlabList shared_[kNumClasses] GUARDED_BY(mutex_);
+  std::atomic<int64_t> numRefs_;  // blocks, plus one until release()
+  std::atomic<int64_t> numSlabs_;
+};
+
+///
+/// Allocator for std::allocate_shared, objects and their control block
+/// in one block of @c pool.
+///
+template<typename T>
+class SlabAllocator
+{
+ public:
+  typedef T value_type;
+
+  explicit SlabAllocator(SlabPool* pool)
+    : pool_(pool)
+  {
+  }
+
+  template<typename U>
+  SlabAllocator(const SlabAllocator<U>& rhs)  // NOLINT(runtime/explicit)
+    : pool_(rhs.pool())
+  {
+  }
+
+  T* allocate(size_t n)
+  { return static_cast<T*>(SlabPool::allocate(pool_, n * sizeof(T))); }
+
+  void deallocate(T* p, size_t)
+  { SlabPool::deallocate(p); }
+
+  SlabPool* pool() const { return pool_; }
+
+ private:
+  SlabPool* pool_;
+};
+
+template<typename T, typename U>
+bool operator==(const SlabAllocator<T>& lhs, const SlabAllocator<U>& rhs)
+{
+  return lhs.pool() == rhs.pool();
+}
+
+template<typename T, typename U>
+bool operator!=(const SlabAllocator<T>& lhs, const SlabAllocator<U>& rhs)
+{
+  return !(lhs == rhs);
+}
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_SLABPOOL_H
@@ -10,6 +10,7 @@
 
 #include "muduo/base/Logging.h"
 #include "muduo/net/InetAddress.h"
+#include "muduo/net/UnixAddress.h"
 #include "muduo/net/SocketsOps.h"
 
 #include <netinet/in.h>
@@ -62,6 +63,11 @@ void Socket::bindAddress(const InetAddress& addr)
   sockets::bindOrDie(sockfd_, addr.getSockAddr());
 }
 
+void Socket::bindAddress(const UnixAddress& addr)
+{
+  sockets::bindOrDie(sockfd_, addr.getSockAddr(), addr.length());
+}
+
 void Socket::listen()
 {
   sockets::listenOrDie(sockfd_);
@@ -126,3 +132,30 @@ void Socket::setKeepAlive(bool on)
   // FIXME CHECK
 }
 
+void Socket::setTcpFastOpen(int queueLength)
+{
+#ifdef TCP_FASTOPEN
+  int ret = ::setsockopt(sockfd_, IPPROTO_TCP, TCP_FASTOPEN,
+                         &queueLength, static_cast<socklen_t>(sizeof queueLength));
+  if (ret < 0 && queueLength > 0)
+  {
+    LOG_SYSERR << "TCP_FASTOPEN failed.";
+  }
+#else
+  if (queueLength > 0)
+  {
+    LOG_ERROR << "TCP_FASTOPEN is not supported.";
+  }
+#endif
+}
+
+void Socket::setDeferAccept(int seconds)
+{
+  int ret = ::setsockopt(sockfd_, IPPROTO_TCP, TCP_DEFER_ACCEPT,
+                         &seconds, static_cast<socklen_t>(sizeof seconds));
+  if (ret < 0 && seconds > 0)
+  {
+    LOG_SYSERR << "TCP_DEFER_ACCEPT failed.";
+  }
+}
+
@@ -25,6 +25,7 @@ namespace net
 {
 
 class InetAddress;
+class UnixAddress;
 
 ///
 /// Wrapper of socket file descriptor.
@@ -48,6 +49,7 @@ class Socket : noncopyable
 
   /// abort if address in use
   void bindAddress(const InetAddress& localaddr);
+  void bindAddress(const UnixAddress& localaddr);
   /// abort if address in use
   void listen();
 
@@ -79,6 +81,19 @@ class Socket : noncopyable
   ///
   void setKeepAlive(bool on);
 
+  ///
+  /// Enable TCP Fast Open on a listening socket, accepting data in SYN
+  /// for up to @c queueLength pending handshakes, 0 to disable.
+  /// Needs bit 0x2 of sysctl net.ipv4.tcp_fastopen.
+  ///
+  void setTcpFastOpen(int queueLength);
+
+  ///
+  /// Set TCP_DEFER_ACCEPT on a listening socket, accept() only after
+  /// data arrives, or after about @c seconds. 0 to disable.
+  ///
+  void setDeferAccept(int seconds);
+
  private:
   const int sockfd_;
 };
@@ -64,6 +64,11 @@ const struct sockaddr* sockets::sockaddr_cast(const struct sockaddr_in* addr)
   return static_cast<const struct sockaddr*>(implicit_cast<const void*>(addr));
 }
 
+const struct sockaddr* sockets::sockaddr_cast(const struct sockaddr_un* addr)
+{
+  return static_cast<const struct sockaddr*>(implicit_cast<const void*>(addr));
+}
+
 const struct sockaddr_in* sockets::sockaddr_in_cast(const struct sockaddr* addr)
 {
   return static_cast<const struct sockaddr_in*>(implicit_cast<const void*>(addr));
@@ -94,9 +99,34 @@ int sockets::createNonblockingOrDie(sa_family_t family)
   return sockfd;
 }
 
+int sockets::createNonblockingUdpOrDie(sa_family_t family)
+{
+  int sockfd = ::socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+  if (sockfd < 0)
+  {
+    LOG_SYSFATAL << "sockets::createNonblockingUdpOrDie";
+  }
+  return sockfd;
+}
+
+int sockets::createNonblockingUnixOrDie(int type)
+{
+  int sockfd = ::socket(AF_UNIX, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (sockfd < 0)
+  {
+    LOG_SYSFATAL << "sockets::createNonblockingUnixOrDie";
+  }
+  return sockfd;
+}
+
 void sockets::bindOrDie(int sockfd, const struct sockaddr* addr)
 {
-  int ret = ::bind(sockfd, addr, static_cast<socklen_t>(sizeof(struct sockaddr_in6)));
+  bindOrDie(sockfd, addr, static_cast<socklen_t>(sizeof(struct sockaddr_in6)));
+}
+
+void sockets::bindOrDie(int sockfd, const struct sockaddr* addr, socklen_t addrlen)
+{
+  int ret = ::bind(sockfd, addr, addrlen);
   if (ret < 0)
   {
     LOG_SYSFATAL << "sockets::bindOrDie";
@@ -125,7 +155,7 @@ int sockets::accept(int sockfd, struct sockaddr_in6* addr)
   if (connfd < 0)
   {
     int savedErrno = errno;
-    LOG_SYSERR << "Socket::accept";
+    LOG_EVERY_T(SYSERR, 1) << "Socket::accept";
     switch (savedErrno)
     {
       case EAGAIN:
@@ -161,6 +191,11 @@ int sockets::connect(int sockfd, const struct sockaddr* addr)
   return ::connect(sockfd, addr, static_cast<socklen_t>(sizeof(struct sockaddr_in6)));
 }
 
+int sockets::connect(int sockfd, const struct sockaddr* addr, socklen_t addrlen)
+{
+  return ::connect(sockfd, addr, addrlen);
+}
+
 ssize_t sockets::read(int sockfd, void *buf, size_t count)
 {
   return ::read(sockfd, buf, count);
@@ -176,6 +211,76 @@ ssize_t sockets::write(int sockfd, const void *buf, size_t count)
   return ::write(sockfd, buf, count);
 }
 
+ssize_t sockets::readvWithFds(int sockfd, const struct iovec *iov, int iovcnt,
+                              int* fds, int maxFds, int* numFds, int* msgFlags)
+{
+  assert(0 <= maxFds && maxFds <= kMaxPassedFds);
+  if (fds == NULL)
+  {
+    maxFds = 0;
+  }
+  union
+  {
+    struct cmsghdr align;
+    char buf[CMSG_SPACE(sizeof(int) * kMaxPassedFds)];
+  } control;
+  struct msghdr msg;
+  memZero(&msg, sizeof msg);
+  msg.msg_iov = const_cast<struct iovec*>(iov);
+  msg.msg_iovlen = iovcnt;
+  if (maxFds > 0)
+  {
+    msg.msg_control = control.buf;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * maxFds);
+  }
+  *numFds = 0;
+  ssize_t n = ::recvmsg(sockfd, &msg, MSG_CMSG_CLOEXEC);
+  *msgFlags = msg.msg_flags;
+  if (n >= 0)
+  {
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+      if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+      {
+        int count = static_cast<int>((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        ::memcpy(fds + *numFds, CMSG_DATA(cmsg), sizeof(int) * count);
+        *numFds += count;
+      }
+    }
+    if (msg.msg_flags & MSG_CTRUNC)
+    {
+      LOG_ERROR << "sockets::readvWithFds - more than " << maxFds << " fds, discarded";
+    }
+  }
+  return n;
+}
+
+ssize_t sockets::writeWithFds(int sockfd, const void *buf, size_t count,
+                              const int* fds, int numFds)
+{
+  assert(0 < numFds && numFds <= kMaxPassedFds);
+  union
+  {
+    struct cmsghdr align;
+    char buf[CMSG_SPACE(sizeof(int) * kMaxPassedFds)];
+  } control;
+  struct iovec vec;
+  vec.iov_base = const_cast<void*>(buf);
+  vec.iov_len = count;
+  struct msghdr msg;
+  memZero(&msg, sizeof msg);
+  msg.msg_iov = &vec;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = CMSG_SPACE(sizeof(int) * numFds);
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * numFds);
+  ::memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * numFds);
+  return ::sendmsg(sockfd, &msg, MSG_NOSIGNAL);
+}
+
 void sockets::close(int sockfd)
 {
   if (::close(sockfd) < 0)
@@ -195,6 +300,12 @@ void sockets::shutdownWrite(int sockfd)
 void sockets::toIpPort(char* buf, size_t size,
                        const struct sockaddr* addr)
 {
+  if (addr->sa_family == AF_UNIX)
+  {
+    // sockaddr_un doesn't fit in InetAddress, see UnixAddress
+    snprintf(buf, size, "unix");
+    return;
+  }
   if (addr->sa_family == AF_INET6)
   {
     buf[0] = '[';
@@ -217,7 +328,11 @@ void sockets::toIpPort(char* buf, size_t size,
 void sockets::toIp(char* buf, size_t size,
                    const struct sockaddr* addr)
 {
-  if (addr->sa_family == AF_INET)
+  if (addr->sa_family == AF_UNIX)
+  {
+    snprintf(buf, size, "unix");
+  }
+  else if (addr->sa_family == AF_INET)
   {
     assert(size >= INET_ADDRSTRLEN);
     const struct sockaddr_in* addr4 = sockaddr_in_cast(addr);
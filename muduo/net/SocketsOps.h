@@ -12,6 +12,7 @@
 #define MUDUO_NET_SOCKETSOPS_H
 
 #include <arpa/inet.h>
+#include <sys/un.h>
 
 namespace muduo
 {
@@ -20,18 +21,34 @@ namespace net
 namespace sockets
 {
 
+/// Most fds passed along with one message.
+const int kMaxPassedFds = 16;
+
 ///
 /// Creates a non-blocking socket file descriptor,
 /// abort if any error.
 int createNonblockingOrDie(sa_family_t family);
+int createNonblockingUdpOrDie(sa_family_t family);
+/// AF_UNIX, @c type is SOCK_STREAM or SOCK_SEQPACKET.
+int createNonblockingUnixOrDie(int type);
 
 int  connect(int sockfd, const struct sockaddr* addr);
+int  connect(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
 void bindOrDie(int sockfd, const struct sockaddr* addr);
+void bindOrDie(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
 void listenOrDie(int sockfd);
 int  accept(int sockfd, struct sockaddr_in6* addr);
 ssize_t read(int sockfd, void *buf, size_t count);
 ssize_t readv(int sockfd, const struct iovec *iov, int iovcnt);
 ssize_t write(int sockfd, const void *buf, size_t count);
+/// Unix domain sockets, SCM_RIGHTS ancillary data.
+/// Received fds are close-on-exec, at most @c maxFds are kept,
+/// the rest are closed by the kernel, no fds are received if @c fds is NULL.
+/// @c msgFlags gets msg_flags of recvmsg(2), e.g. MSG_TRUNC.
+ssize_t readvWithFds(int sockfd, const struct iovec *iov, int iovcnt,
+                     int* fds, int maxFds, int* numFds, int* msgFlags);
+ssize_t writeWithFds(int sockfd, const void *buf, size_t count,
+                     const int* fds, int numFds);
 void close(int sockfd);
 void shutdownWrite(int sockfd);
 
@@ -49,6 +66,7 @@ int getSocketError(int sockfd);
 
 const struct sockaddr* sockaddr_cast(const struct sockaddr_in* addr);
 const struct sockaddr* sockaddr_cast(const struct sockaddr_in6* addr);
+const struct sockaddr* sockaddr_cast(const struct sockaddr_un* addr);
 struct sockaddr* sockaddr_cast(struct sockaddr_in6* addr);
 const struct sockaddr_in* sockaddr_in_cast(const struct sockaddr* addr);
 const struct sockaddr_in6* sockaddr_in6_cast(const struct sockaddr* addr);
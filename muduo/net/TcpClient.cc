@@ -61,7 +61,29 @@ TcpClient::TcpClient(EventLoop* loop,
     messageCallback_(defaultMessageCallback),
     retry_(false),
     connect_(true),
-    nextConnId_(1)
+    nextConnId_(1),
+    mutex_("TcpClient")
+{
+  connector_->setNewConnectionCallback(
+      std::bind(&TcpClient::newConnection, this, _1));
+  // FIXME setConnectFailedCallback
+  LOG_INFO << "TcpClient::TcpClient[" << name_
+           << "] - connector " << get_pointer(connector_);
+}
+
+TcpClient::TcpClient(EventLoop* loop,
+                     const UnixAddress& serverAddr,
+                     const string& nameArg,
+                     int socketType)
+  : loop_(CHECK_NOTNULL(loop)),
+    connector_(new Connector(loop, serverAddr, socketType)),
+    name_(nameArg),
+    connectionCallback_(defaultConnectionCallback),
+    messageCallback_(defaultMessageCallback),
+    retry_(false),
+    connect_(true),
+    nextConnId_(1),
+    mutex_("TcpClient")
 {
   connector_->setNewConnectionCallback(
       std::bind(&TcpClient::newConnection, this, _1));
@@ -105,7 +127,7 @@ void TcpClient::connect()
 {
   // FIXME: check state
   LOG_INFO << "TcpClient::connect[" << name_ << "] - connecting to "
-           << connector_->serverAddress().toIpPort();
+           << connector_->serverName();
   connect_ = true;
   connector_->start();
 }
@@ -129,23 +151,28 @@ void TcpClient::stop()
   connector_->stop();
 }
 
+void TcpClient::setTcpFastOpen(bool on)
+{
+  connector_->setTcpFastOpen(on);
+}
+
 void TcpClient::newConnection(int sockfd)
 {
   loop_->assertInLoopThread();
-  InetAddress peerAddr(sockets::getPeerAddr(sockfd));
+  // getpeername(2) fails before a deferred TCP Fast Open handshake
+  InetAddress peerAddr(connector_->tcpFastOpen()
+                       ? connector_->serverAddress()
+                       : InetAddress(sockets::getPeerAddr(sockfd)));
   char buf[32];
-  snprintf(buf, sizeof buf, ":%s#%d", peerAddr.toIpPort().c_str(), nextConnId_);
+  snprintf(buf, sizeof buf, "#%d", nextConnId_);
   ++nextConnId_;
-  string connName = name_ + buf;
+  string connName = name_ + ":" + connector_->serverName() + buf;
 
   InetAddress localAddr(sockets::getLocalAddr(sockfd));
   // FIXME poll with zero timeout to double confirm the new connection
-  // FIXME use make_shared if necessary
-  TcpConnectionPtr conn(new TcpConnection(loop_,
-                                          connName,
-                                          sockfd,
-                                          localAddr,
-                                          peerAddr));
+  TcpConnectionPtr conn(std::allocate_shared<TcpConnection>(
+      SlabAllocator<TcpConnection>(loop_->slabPool()),
+      loop_, connName, sockfd, localAddr, peerAddr));
 
   conn->setConnectionCallback(connectionCallback_);
   conn->setMessageCallback(messageCallback_);
@@ -174,7 +201,7 @@ void TcpClient::removeConnection(const TcpConnectionPtr& conn)
   if (retry_ && connect_)
   {
     LOG_INFO << "TcpClient::connect[" << name_ << "] - Reconnecting to "
-             << connector_->serverAddress().toIpPort();
+             << connector_->serverName();
     connector_->restart();
   }
 }
@@ -13,6 +13,7 @@
 
 #include "muduo/base/Mutex.h"
 #include "muduo/net/TcpConnection.h"
+#include "muduo/net/UnixAddress.h"
 
 namespace muduo
 {
@@ -30,6 +31,11 @@ class TcpClient : noncopyable
   TcpClient(EventLoop* loop,
             const InetAddress& serverAddr,
             const string& nameArg);
+  /// Unix domain socket client, see TcpServer.
+  TcpClient(EventLoop* loop,
+            const UnixAddress& serverAddr,
+            const string& nameArg,
+            int socketType = SOCK_STREAM);
   ~TcpClient();  // force out-line dtor, for std::unique_ptr members.
 
   void connect();
@@ -49,6 +55,12 @@ class TcpClient : noncopyable
   const string& name() const
   { return name_; }
 
+  /// Sends the first data in the SYN with a TCP Fast Open cookie,
+  /// the connection is UP before the handshake completes then.
+  /// Idempotent requests only, data in SYN may be replayed.
+  /// TCP only, must be called before @c connect
+  void setTcpFastOpen(bool on);
+
   /// Set connection callback.
   /// Not thread safe.
   void setConnectionCallback(ConnectionCallback cb)
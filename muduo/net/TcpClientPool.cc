@@ -0,0 +1,306 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/net/TcpClientPool.h"
+
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/Logging.h"
+#include "muduo/base/Mutex.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpClient.h"
+
+#include <stdio.h>  // snprintf
+#include <stdlib.h>  // rand_r
+
+using namespace muduo;
+using namespace muduo::net;
+
+struct TcpClientPool::Slot : noncopyable
+{
+  Slot(int indexArg, EventLoop* loopArg, const InetAddress& serverAddrArg)
+    : index(indexArg),
+      loop(loopArg),
+      serverAddr(serverAddrArg),
+      numClients(0),
+      backoff(0.0),
+      seed(static_cast<unsigned>(Timestamp::now().microSecondsSinceEpoch()) + indexArg),
+      generation(0)
+  {
+  }
+
+  const int index;
+  EventLoop* const loop;
+  const InetAddress serverAddr;
+
+  // in loop thread
+  std::unique_ptr<TcpClient> client;  // a new one for each reconnection
+  int numClients;
+  Timestamp upTime;
+  double backoff;
+  unsigned seed;
+  TimerId reconnectTimer;
+
+  // any thread
+  AtomicInt32 up;
+  AtomicInt32 outstanding;
+  MutexLock mutex;
+  TcpConnectionPtr connection GUARDED_BY(mutex);
+  int generation GUARDED_BY(mutex);
+};
+
+TcpClientPool::TcpClientPool(const std::vector<EventLoop*>& loops, const string& nameArg)
+  : loops_(loops),
+    name_(nameArg),
+    healthCheckInterval_(0.0),
+    initialBackoff_(0.1),
+    maxBackoff_(30.0),
+    loopAffinity_(true),
+    started_(false)
+{
+  assert(!loops_.empty());
+}
+
+TcpClientPool::~TcpClientPool()
+{
+  stopping_.getAndSet(1);
+  for (size_t i = 0; i < loops_.size(); ++i)
+  {
+    if (loops_[i]->isInLoopThread())
+    {
+      stopInLoop(i);
+    }
+    else
+    {
+      CountDownLatch latch(1);
+      loops_[i]->runInLoop([this, i, &latch] {
+        stopInLoop(i);
+        latch.countDown();
+      });
+      latch.wait();
+    }
+  }
+}
+
+void TcpClientPool::addServer(const InetAddress& serverAddr, int numConnections)
+{
+  assert(!started_);
+  for (int i = 0; i < numConnections; ++i)
+  {
+    int index = static_cast<int>(slots_.size());
+    EventLoop* loop = loops_[index % loops_.size()];
+    slots_.emplace_back(new Slot(index, loop, serverAddr));
+  }
+}
+
+void TcpClientPool::start()
+{
+  assert(!started_);
+  started_ = true;
+  for (const auto& slot : slots_)
+  {
+    slot->loop->runInLoop(std::bind(&TcpClientPool::connect, this, get_pointer(slot)));
+  }
+  if (healthCheckCallback_)
+  {
+    for (EventLoop* loop : loops_)
+    {
+      healthCheckTimers_.push_back(
+          loop->runEvery(healthCheckInterval_,
+                         std::bind(&TcpClientPool::checkHealth, this, loop)));
+    }
+  }
+}
+
+void TcpClientPool::connect(Slot* slot)
+{
+  slot->loop->assertInLoopThread();
+  if (stopping_.get())
+  {
+    return;
+  }
+  char buf[64];
+  snprintf(buf, sizeof buf, "%s-%d.%d", name_.c_str(), slot->index, ++slot->numClients);
+  // destroys the previous one, whose connection has been removed
+  slot->client.reset(new TcpClient(slot->loop, slot->serverAddr, buf));
+  slot->client->setConnectionCallback(
+      std::bind(&TcpClientPool::onConnection, this, slot, _1));
+  if (messageCallback_)
+  {
+    slot->client->setMessageCallback(messageCallback_);
+  }
+  slot->client->setWriteCompleteCallback(writeCompleteCallback_);
+  slot->client->connect();
+}
+
+void TcpClientPool::onConnection(Slot* slot, const TcpConnectionPtr& conn)
+{
+  slot->loop->assertInLoopThread();
+  if (conn->connected())
+  {
+    slot->upTime = Timestamp::now();
+    {
+      MutexLockGuard lock(slot->mutex);
+      slot->connection = conn;
+      ++slot->generation;
+      slot->outstanding.getAndSet(0);
+    }
+    slot->up.getAndSet(1);
+  }
+  else
+  {
+    slot->up.getAndSet(0);
+    {
+      MutexLockGuard lock(slot->mutex);
+      slot->connection.reset();
+      ++slot->generation;
+      slot->outstanding.getAndSet(0);
+    }
+    if (!stopping_.get())
+    {
+      double lived = timeDifference(Timestamp::now(), slot->upTime);
+      if (slot->backoff == 0.0 || lived >= maxBackoff_)
+      {
+        slot->backoff = initialBackoff_;
+      }
+      else
+      {
+        slot->backoff = std::min(slot->backoff * 2, maxBackoff_);
+      }
+      // 0.5x to 1.5x
+      double delay = slot->backoff * (0.5 + ::rand_r(&slot->seed) / (RAND_MAX + 1.0));
+      LOG_INFO << "TcpClientPool[" << name_ << "] - reconnecting "
+               << slot->serverAddr.toIpPort() << " in " << delay << " seconds";
+      slot->reconnectTimer =
+          slot->loop->runAfter(delay, std::bind(&TcpClientPool::connect, this, slot));
+    }
+  }
+  if (connectionCallback_)
+  {
+    connectionCallback_(conn);
+  }
+}
+
+TcpClientPool::Lease TcpClientPool::acquire()
+{
+  Lease lease;
+  const int n = size();
+  if (n == 0)
+  {
+    return lease;
+  }
+  EventLoop* current = loopAffinity_ ? EventLoop::getEventLoopOfCurrentThread() : NULL;
+  // a connection may go down after it's picked, then pick again.
+  for (int tries = 0; tries < n && !lease.connection_; ++tries)
+  {
+    unsigned start = static_cast<unsigned>(nextSlot_.getAndAdd(1));
+    Slot* best = NULL;
+    bool bestLocal = false;
+    int bestOutstanding = 0;
+    for (int i = 0; i < n; ++i)
+    {
+      Slot* slot = get_pointer(slots_[(start + i) % n]);
+      if (!slot->up.get())
+        continue;
+      bool local = slot->loop == current;
+      int outstanding = slot->outstanding.get();
+      if (best == NULL
+          || (local && !bestLocal)
+          || (local == bestLocal && outstanding < bestOutstanding))
+      {
+        best = slot;
+        bestLocal = local;
+        bestOutstanding = outstanding;
+      }
+    }
+    if (best == NULL)
+    {
+      break;
+    }
+
+    MutexLockGuard lock(best->mutex);
+    if (best->connection)
+    {
+      lease.connection_ = best->connection;
+      lease.slot_ = best->index;
+      lease.generation_ = best->generation;
+      best->outstanding.increment();
+    }
+  }
+  return lease;
+}
+
+void TcpClientPool::release(const Lease& lease)
+{
+  if (lease.slot_ < 0)
+  {
+    return;
+  }
+  Slot* slot = get_pointer(slots_[lease.slot_]);
+  MutexLockGuard lock(slot->mutex);
+  if (slot->generation == lease.generation_)
+  {
+    slot->outstanding.decrement();
+  }
+}
+
+int TcpClientPool::numConnected() const
+{
+  int connected = 0;
+  for (const auto& slot : slots_)
+  {
+    connected += slot->up.get();
+  }
+  return connected;
+}
+
+void TcpClientPool::checkHealth(EventLoop* loop)
+{
+  for (const auto& slot : slots_)
+  {
+    if (slot->loop != loop || !slot->up.get())
+      continue;
+    TcpConnectionPtr conn;
+    {
+      MutexLockGuard lock(slot->mutex);
+      conn = slot->connection;
+    }
+    if (conn && !healthCheckCallback_(conn))
+    {
+      LOG_WARN << "TcpClientPool[" << name_ << "] - " << conn->name()
+               << " failed health check";
+      slot->up.getAndSet(0);
+      conn->forceClose();
+    }
+  }
+}
+
+void TcpClientPool::stopInLoop(size_t loopIndex)
+{
+  EventLoop* loop = loops_[loopIndex];
+  loop->assertInLoopThread();
+  if (loopIndex < healthCheckTimers_.size())
+  {
+    loop->cancel(healthCheckTimers_[loopIndex]);
+  }
+  for (const auto& slot : slots_)
+  {
+    if (slot->loop != loop)
+      continue;
+    loop->cancel(slot->reconnectTimer);
+    TcpConnectionPtr conn;
+    {
+      MutexLockGuard lock(slot->mutex);
+      conn = slot->connection;
+    }
+    // leaves conn open, as it's shared
+    slot->client.reset();
+    if (conn)
+    {
+      // closes now like ~TcpServer, a queued forceClose() might not run
+      // if the loop quits right after. Calls back with it DOWN.
+      conn->connectDestroyed();
+    }
+  }
+}
@@ -0,0 +1,138 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_TCPCLIENTPOOL_H
+#define MUDUO_NET_TCPCLIENTPOOL_H
+
+#include "muduo/base/Atomic.h"
+#include "muduo/base/copyable.h"
+#include "muduo/base/noncopyable.h"
+#include "muduo/base/Types.h"
+#include "muduo/net/Callbacks.h"
+#include "muduo/net/InetAddress.h"
+#include "muduo/net/TimerId.h"
+
+#include <memory>
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+class EventLoop;
+
+///
+/// Pre-connected TCP connections to a set of servers, spread over loops.
+///
+/// Each server gets N connections, assigned to the loops round-robin.
+/// acquire() picks the connected one with the fewest outstanding
+/// requests, preferring connections in the calling loop to save
+/// a cross-thread hop for each send.
+///
+/// A lost connection is reconnected after a delay that doubles when
+/// connections keep dropping, with jitter, so that a restarted server
+/// isn't hit by all clients at once. Failed connects are retried by
+/// the Connector with its own backoff.
+///
+/// acquire(), release() and numConnected() are thread safe, the rest
+/// must be called before start(). Destroy it while the loops are running.
+class TcpClientPool : noncopyable
+{
+ public:
+  /// Returns false to close the connection and reconnect.
+  typedef std::function<bool (const TcpConnectionPtr&)> HealthCheckCallback;
+
+  /// A connection taken from the pool, which counts as an outstanding
+  /// request on it until released.
+  class Lease : public muduo::copyable
+  {
+   public:
+    Lease() : slot_(-1), generation_(0) { }
+
+    /// null if no connection is up.
+    const TcpConnectionPtr& connection() const { return connection_; }
+
+   private:
+    friend class TcpClientPool;
+    TcpConnectionPtr connection_;
+    int slot_;
+    int generation_;  // of the slot, for release after reconnecting
+  };
+
+  /// @c loops are usually EventLoopThreadPool::getAllLoops().
+  TcpClientPool(const std::vector<EventLoop*>& loops, const string& name);
+  ~TcpClientPool();  // force out-line dtor, for std::unique_ptr members.
+
+  const string& name() const { return name_; }
+
+  void addServer(const InetAddress& serverAddr, int numConnections);
+
+  /// Called in the loop of the connection, with the state of it
+  /// already updated in the pool, and with it DOWN on destruction.
+  void setConnectionCallback(const ConnectionCallback& cb)
+  { connectionCallback_ = cb; }
+  void setMessageCallback(const MessageCallback& cb)
+  { messageCallback_ = cb; }
+  void setWriteCompleteCallback(const WriteCompleteCallback& cb)
+  { writeCompleteCallback_ = cb; }
+
+  /// Calls @c cb for every connection every @c interval seconds,
+  /// in the loop of the connection.
+  void setHealthCheck(double interval, const HealthCheckCallback& cb)
+  { healthCheckInterval_ = interval; healthCheckCallback_ = cb; }
+
+  /// Reconnect delay, starting at @c initial and doubling up to @c max.
+  /// Reset when a connection has been up for @c max seconds.
+  /// 0.1 and 30 seconds by default.
+  void setReconnectBackoff(double initial, double max)
+  { initialBackoff_ = initial; maxBackoff_ = max; }
+
+  /// Prefers connections in the calling loop, true by default.
+  void setLoopAffinity(bool on) { loopAffinity_ = on; }
+
+  /// Connects all.
+  void start();
+
+  /// A connection with the fewest outstanding requests, null connection()
+  /// if none is connected.
+  Lease acquire();
+  /// The request on the lease is done, harmless if it's null.
+  void release(const Lease& lease);
+
+  int size() const { return static_cast<int>(slots_.size()); }
+  int numConnected() const;
+
+ private:
+  struct Slot;
+
+  void connect(Slot* slot);
+  void onConnection(Slot* slot, const TcpConnectionPtr& conn);
+  void checkHealth(EventLoop* loop);
+  void stopInLoop(size_t loopIndex);
+
+  const std::vector<EventLoop*> loops_;
+  const string name_;
+  ConnectionCallback connectionCallback_;
+  MessageCallback messageCallback_;
+  WriteCompleteCallback writeCompleteCallback_;
+  HealthCheckCallback healthCheckCallback_;
+  double healthCheckInterval_;
+  double initialBackoff_;
+  double maxBackoff_;
+  bool loopAffinity_;
+  bool started_;
+  AtomicInt32 stopping_;
+  AtomicInt32 nextSlot_;  // to break ties
+  std::vector<std::unique_ptr<Slot>> slots_;
+  std::vector<TimerId> healthCheckTimers_;  // by loop
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_TCPCLIENTPOOL_H
@@ -8,6 +8,7 @@
 
 #include "muduo/net/TcpConnection.h"
 
+#include "muduo/base/FlightRecorder.h"
 #include "muduo/base/Logging.h"
 #include "muduo/base/WeakCallback.h"
 #include "muduo/net/Channel.h"
@@ -35,6 +36,17 @@ void muduo::net::defaultMessageCallback(const TcpConnectionPtr&,
   buf->retrieveAll();
 }
 
+namespace
+{
+
+const TcpConnection::CallbacksPtr& emptyCallbacks()
+{
+  static const TcpConnection::CallbacksPtr empty(new TcpConnection::Callbacks);
+  return empty;
+}
+
+}  // namespace
+
 TcpConnection::TcpConnection(EventLoop* loop,
                              const string& nameArg,
                              int sockfd,
@@ -44,22 +56,28 @@ TcpConnection::TcpConnection(EventLoop* loop,
     name_(nameArg),
     state_(kConnecting),
     reading_(true),
-    socket_(new Socket(sockfd)),
-    channel_(new Channel(loop, sockfd)),
+    socket_(SlabPool::make<Socket>(loop->slabPool(), sockfd)),
+    channel_(SlabPool::make<Channel>(loop->slabPool(), loop, sockfd)),
     localAddr_(localAddr),
     peerAddr_(peerAddr),
-    highWaterMark_(64*1024*1024)
+    callbacks_(emptyCallbacks()),
+    highWaterMark_(64*1024*1024),
+    inputBuffer_(0),  // grows on first use, idle connections hold little
+    outputBuffer_(0)
 {
+  // lambdas capturing this fit in the small buffer of std::function,
+  // std::bind of a member function doesn't and takes a heap block.
   channel_->setReadCallback(
-      std::bind(&TcpConnection::handleRead, this, _1));
+      [this](Timestamp receiveTime) { handleRead(receiveTime); });
   channel_->setWriteCallback(
-      std::bind(&TcpConnection::handleWrite, this));
+      [this] { handleWrite(); });
   channel_->setCloseCallback(
-      std::bind(&TcpConnection::handleClose, this));
+      [this] { handleClose(); });
   channel_->setErrorCallback(
-      std::bind(&TcpConnection::handleError, this));
+      [this] { handleError(); });
   LOG_DEBUG << "TcpConnection::ctor[" <<  name_ << "] at " << this
             << " fd=" << sockfd;
+  RECORD_DEBUG("TcpConnection::ctor fd", sockfd);
   socket_->setKeepAlive(true);
 }
 
@@ -68,7 +86,19 @@ TcpConnection::~TcpConnection()
   LOG_DEBUG << "TcpConnection::dtor[" <<  name_ << "] at " << this
             << " fd=" << channel_->fd()
             << " state=" << stateToString();
+  RECORD_DEBUG("TcpConnection::dtor fd, state", channel_->fd(), state_);
   assert(state_ == kDisconnected);
+  setReceiveFds(false);
+}
+
+TcpConnection::Callbacks* TcpConnection::mutableCallbacks()
+{
+  if (callbacks_.use_count() != 1)
+  {
+    // shared, copy on write
+    callbacks_ = std::make_shared<Callbacks>(*callbacks_);
+  }
+  return get_pointer(callbacks_);
 }
 
 bool TcpConnection::getTcpInfo(struct tcp_info* tcpi) const
@@ -154,9 +184,9 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
     if (nwrote >= 0)
     {
       remaining = len - nwrote;
-      if (remaining == 0 && writeCompleteCallback_)
+      if (remaining == 0 && callbacks_->writeCompleteCallback)
       {
-        loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+        loop_->queueInLoop(std::bind(callbacks_->writeCompleteCallback, shared_from_this()));
       }
     }
     else // nwrote < 0
@@ -164,7 +194,7 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
       nwrote = 0;
       if (errno != EWOULDBLOCK)
       {
-        LOG_SYSERR << "TcpConnection::sendInLoop";
+        LOG_EVERY_T(SYSERR, 1) << "TcpConnection::sendInLoop";
         if (errno == EPIPE || errno == ECONNRESET) // FIXME: any others?
         {
           faultError = true;
@@ -179,9 +209,9 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
     size_t oldLen = outputBuffer_.readableBytes();
     if (oldLen + remaining >= highWaterMark_
         && oldLen < highWaterMark_
-        && highWaterMarkCallback_)
+        && callbacks_->highWaterMarkCallback)
     {
-      loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining));
+      loop_->queueInLoop(std::bind(callbacks_->highWaterMarkCallback, shared_from_this(), oldLen + remaining));
     }
     outputBuffer_.append(static_cast<const char*>(data)+nwrote, remaining);
     if (!channel_->isWriting())
@@ -290,6 +320,61 @@ void TcpConnection::setTcpNoDelay(bool on)
   socket_->setTcpNoDelay(on);
 }
 
+bool TcpConnection::sendWithFds(const StringPiece& message, const int* fds, int numFds)
+{
+  loop_->assertInLoopThread();
+  assert(message.size() > 0);
+  if (state_ != kConnected || channel_->isWriting() || outputBuffer_.readableBytes() > 0)
+  {
+    return false;
+  }
+  ssize_t nwrote = sockets::writeWithFds(channel_->fd(), message.data(), message.size(),
+                                         fds, numFds);
+  if (nwrote < 0)
+  {
+    if (errno != EWOULDBLOCK)
+    {
+      LOG_SYSERR << "TcpConnection::sendWithFds";
+    }
+    return false;
+  }
+  if (nwrote < message.size())
+  {
+    sendInLoop(message.data() + nwrote, static_cast<size_t>(message.size() - nwrote));
+  }
+  else if (callbacks_->writeCompleteCallback)
+  {
+    loop_->queueInLoop(std::bind(callbacks_->writeCompleteCallback, shared_from_this()));
+  }
+  return true;
+}
+
+void TcpConnection::setReceiveFds(bool on)
+{
+  if (on && !receivedFds_)
+  {
+    receivedFds_.reset(new std::vector<int>);
+  }
+  else if (!on && receivedFds_)
+  {
+    for (int fd : *receivedFds_)
+    {
+      sockets::close(fd);
+    }
+    receivedFds_.reset();
+  }
+}
+
+std::vector<int> TcpConnection::takeReceivedFds()
+{
+  std::vector<int> fds;
+  if (receivedFds_)
+  {
+    fds.swap(*receivedFds_);
+  }
+  return fds;
+}
+
 void TcpConnection::startRead()
 {
   loop_->runInLoop(std::bind(&TcpConnection::startReadInLoop, this));
@@ -328,18 +413,21 @@ void TcpConnection::connectEstablished()
   channel_->tie(shared_from_this());
   channel_->enableReading();
 
-  connectionCallback_(shared_from_this());
+  // the callback may set callbacks of this connection, even itself
+  CallbacksPtr callbacks(callbacks_);
+  callbacks->connectionCallback(shared_from_this());
 }
 
 void TcpConnection::connectDestroyed()
 {
   loop_->assertInLoopThread();
-  if (state_ == kConnected)
+  // kDisconnecting if shut down, but the peer hasn't closed yet
+  if (state_ == kConnected || state_ == kDisconnecting)
   {
     setState(kDisconnected);
     channel_->disableAll();
 
-    connectionCallback_(shared_from_this());
+    callbacks_->connectionCallback(shared_from_this());
   }
   channel_->remove();
 }
@@ -348,10 +436,21 @@ void TcpConnection::handleRead(Timestamp receiveTime)
 {
   loop_->assertInLoopThread();
   int savedErrno = 0;
-  ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
-  if (n > 0)
+  bool truncated = false;
+  ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno, get_pointer(receivedFds_),
+                                  &truncated);
+  RECORD_TRACE("TcpConnection::handleRead fd, n", channel_->fd(), n);
+  if (truncated)
+  {
+    // SOCK_SEQPACKET, the rest of the record is lost, so is the framing
+    LOG_ERROR << "TcpConnection::handleRead [" << name_
+              << "] - record truncated to " << n << " bytes, closing";
+    inputBuffer_.retrieveAll();
+    handleClose();
+  }
+  else if (n > 0)
   {
-    messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+    callbacks_->messageCallback(shared_from_this(), &inputBuffer_, receiveTime);
   }
   else if (n == 0)
   {
@@ -360,7 +459,7 @@ void TcpConnection::handleRead(Timestamp receiveTime)
   else
   {
     errno = savedErrno;
-    LOG_SYSERR << "TcpConnection::handleRead";
+    LOG_EVERY_T(SYSERR, 1) << "TcpConnection::handleRead";
     handleError();
   }
 }
@@ -373,15 +472,16 @@ void TcpConnection::handleWrite()
     ssize_t n = sockets::write(channel_->fd(),
                                outputBuffer_.peek(),
                                outputBuffer_.readableBytes());
+    RECORD_TRACE("TcpConnection::handleWrite fd, n", channel_->fd(), n);
     if (n > 0)
     {
       outputBuffer_.retrieve(n);
       if (outputBuffer_.readableBytes() == 0)
       {
         channel_->disableWriting();
-        if (writeCompleteCallback_)
+        if (callbacks_->writeCompleteCallback)
         {
-          loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+          loop_->queueInLoop(std::bind(callbacks_->writeCompleteCallback, shared_from_this()));
         }
         if (state_ == kDisconnecting)
         {
@@ -391,7 +491,7 @@ void TcpConnection::handleWrite()
     }
     else
     {
-      LOG_SYSERR << "TcpConnection::handleWrite";
+      LOG_EVERY_T(SYSERR, 1) << "TcpConnection::handleWrite";
       // if (state_ == kDisconnecting)
       // {
       //   shutdownInLoop();
@@ -402,6 +502,7 @@ void TcpConnection::handleWrite()
   {
     LOG_TRACE << "Connection fd = " << channel_->fd()
               << " is down, no more writing";
+    RECORD_TRACE("TcpConnection::handleWrite down, fd", channel_->fd());
   }
 }
 
@@ -409,21 +510,23 @@ void TcpConnection::handleClose()
 {
   loop_->assertInLoopThread();
   LOG_TRACE << "fd = " << channel_->fd() << " state = " << stateToString();
+  RECORD_DEBUG("TcpConnection::handleClose fd, state", channel_->fd(), state_);
   assert(state_ == kConnected || state_ == kDisconnecting);
   // we don't close fd, leave it to dtor, so we can find leaks easily.
   setState(kDisconnected);
   channel_->disableAll();
 
   TcpConnectionPtr guardThis(shared_from_this());
-  connectionCallback_(guardThis);
+  callbacks_->connectionCallback(guardThis);
   // must be the last line
-  closeCallback_(guardThis);
+  callbacks_->closeCallback(guardThis);
 }
 
 void TcpConnection::handleError()
 {
   int err = sockets::getSocketError(channel_->fd());
-  LOG_ERROR << "TcpConnection::handleError [" << name_
+  RECORD_DEBUG("TcpConnection::handleError fd, SO_ERROR", channel_->fd(), err);
+  LOG_EVERY_T(ERROR, 1) << "TcpConnection::handleError [" << name_
             << "] - SO_ERROR = " << err << " " << strerror_tl(err);
 }
 
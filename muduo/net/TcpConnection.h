@@ -17,6 +17,7 @@
 #include "muduo/net/Callbacks.h"
 #include "muduo/net/Buffer.h"
 #include "muduo/net/InetAddress.h"
+#include "muduo/net/SlabPool.h"
 
 #include <memory>
 
@@ -42,6 +43,18 @@ class TcpConnection : noncopyable,
                       public std::enable_shared_from_this<TcpConnection>
 {
  public:
+  /// Callbacks of a connection. One set is shared by all connections of
+  /// a TcpServer, the setters below copy it on write.
+  struct Callbacks
+  {
+    ConnectionCallback connectionCallback;
+    MessageCallback messageCallback;
+    WriteCompleteCallback writeCompleteCallback;
+    HighWaterMarkCallback highWaterMarkCallback;
+    CloseCallback closeCallback;
+  };
+  typedef std::shared_ptr<Callbacks> CallbacksPtr;
+
   /// Constructs a TcpConnection with a connected sockfd
   ///
   /// User should not create this object.
@@ -72,6 +85,20 @@ class TcpConnection : noncopyable,
   void forceClose();
   void forceCloseWithDelay(double seconds);
   void setTcpNoDelay(bool on);
+
+  /// Unix domain sockets only, passing fds with SCM_RIGHTS.
+  /// Sends @c fds along with the first byte of non-empty @c message,
+  /// the rest of message is sent as usual.
+  /// Returns false and sends nothing if the output buffer is not empty,
+  /// or the socket is not writable now.
+  /// Must be called in loop thread, @c fds are not closed.
+  bool sendWithFds(const StringPiece& message, const int* fds, int numFds);
+  /// Keeps received fds instead of closing them, call it in loop thread,
+  /// e.g. in connection callback, before any fds arrive.
+  void setReceiveFds(bool on);
+  /// Fds received so far, in order, ownership goes to the caller.
+  /// Fds not taken are closed on destruction.
+  std::vector<int> takeReceivedFds();
   // reading or not
   void startRead();
   void stopRead();
@@ -87,16 +114,16 @@ class TcpConnection : noncopyable,
   { return &context_; }
 
   void setConnectionCallback(const ConnectionCallback& cb)
-  { connectionCallback_ = cb; }
+  { mutableCallbacks()->connectionCallback = cb; }
 
   void setMessageCallback(const MessageCallback& cb)
-  { messageCallback_ = cb; }
+  { mutableCallbacks()->messageCallback = cb; }
 
   void setWriteCompleteCallback(const WriteCompleteCallback& cb)
-  { writeCompleteCallback_ = cb; }
+  { mutableCallbacks()->writeCompleteCallback = cb; }
 
   void setHighWaterMarkCallback(const HighWaterMarkCallback& cb, size_t highWaterMark)
-  { highWaterMarkCallback_ = cb; highWaterMark_ = highWaterMark; }
+  { mutableCallbacks()->highWaterMarkCallback = cb; highWaterMark_ = highWaterMark; }
 
   /// Advanced interface
   Buffer* inputBuffer()
@@ -107,7 +134,11 @@ class TcpConnection : noncopyable,
 
   /// Internal use only.
   void setCloseCallback(const CloseCallback& cb)
-  { closeCallback_ = cb; }
+  { mutableCallbacks()->closeCallback = cb; }
+
+  /// Internal use only, shares callbacks with other connections.
+  void setCallbacks(const CallbacksPtr& callbacks)
+  { callbacks_ = callbacks; }
 
   // called when TcpServer accepts a new connection
   void connectEstablished();   // should be called only once
@@ -130,25 +161,24 @@ class TcpConnection : noncopyable,
   const char* stateToString() const;
   void startReadInLoop();
   void stopReadInLoop();
+  Callbacks* mutableCallbacks();
 
   EventLoop* loop_;
   const string name_;
   StateE state_;  // FIXME: use atomic variable
   bool reading_;
   // we don't expose those classes to client.
-  std::unique_ptr<Socket> socket_;
-  std::unique_ptr<Channel> channel_;
+  // from the SlabPool of loop_
+  std::unique_ptr<Socket, SlabPool::Deleter> socket_;
+  std::unique_ptr<Channel, SlabPool::Deleter> channel_;
   const InetAddress localAddr_;
   const InetAddress peerAddr_;
-  ConnectionCallback connectionCallback_;
-  MessageCallback messageCallback_;
-  WriteCompleteCallback writeCompleteCallback_;
-  HighWaterMarkCallback highWaterMarkCallback_;
-  CloseCallback closeCallback_;
+  CallbacksPtr callbacks_;  // never null
   size_t highWaterMark_;
   Buffer inputBuffer_;
   Buffer outputBuffer_; // FIXME: use list<Buffer> as output buffer.
   boost::any context_;
+  std::unique_ptr<std::vector<int>> receivedFds_;  // not null if receiving
   // FIXME: creationTime_, lastReceiveTime_
   //        bytesReceived_, bytesSent_
 };
@@ -8,6 +8,7 @@
 
 #include "muduo/net/TcpServer.h"
 
+#include "muduo/base/FlightRecorder.h"
 #include "muduo/base/Logging.h"
 #include "muduo/net/Acceptor.h"
 #include "muduo/net/EventLoop.h"
@@ -36,10 +37,28 @@ TcpServer::TcpServer(EventLoop* loop,
       std::bind(&TcpServer::newConnection, this, _1, _2));
 }
 
+TcpServer::TcpServer(EventLoop* loop,
+                     const UnixAddress& listenAddr,
+                     const string& nameArg,
+                     int socketType)
+  : loop_(CHECK_NOTNULL(loop)),
+    ipPort_(listenAddr.path()),
+    name_(nameArg),
+    acceptor_(new Acceptor(loop, listenAddr, socketType)),
+    threadPool_(new EventLoopThreadPool(loop, name_)),
+    connectionCallback_(defaultConnectionCallback),
+    messageCallback_(defaultMessageCallback),
+    nextConnId_(1)
+{
+  acceptor_->setNewConnectionCallback(
+      std::bind(&TcpServer::newConnection, this, _1, _2));
+}
+
 TcpServer::~TcpServer()
 {
   loop_->assertInLoopThread();
   LOG_TRACE << "TcpServer::~TcpServer [" << name_ << "] destructing";
+  RECORD_TRACE("TcpServer::~TcpServer connections", static_cast<int64_t>(connections_.size()));
 
   for (auto& item : connections_)
   {
@@ -56,6 +75,18 @@ void TcpServer::setThreadNum(int numThreads)
   threadPool_->setThreadNum(numThreads);
 }
 
+void TcpServer::setTcpFastOpen(int queueLength)
+{
+  assert(started_.get() == 0);
+  acceptor_->setTcpFastOpen(queueLength);
+}
+
+void TcpServer::setDeferAccept(int seconds)
+{
+  assert(started_.get() == 0);
+  acceptor_->setDeferAccept(seconds);
+}
+
 void TcpServer::start()
 {
   if (started_.getAndSet(1) == 0)
@@ -72,28 +103,31 @@ void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
 {
   loop_->assertInLoopThread();
   EventLoop* ioLoop = threadPool_->getNextLoop();
-  char buf[64];
-  snprintf(buf, sizeof buf, "-%s#%d", ipPort_.c_str(), nextConnId_);
+  char buf[32];
+  snprintf(buf, sizeof buf, "#%d", nextConnId_);
   ++nextConnId_;
-  string connName = name_ + buf;
+  string connName = name_ + "-" + ipPort_ + buf;
 
   LOG_INFO << "TcpServer::newConnection [" << name_
            << "] - new connection [" << connName
            << "] from " << peerAddr.toIpPort();
   InetAddress localAddr(sockets::getLocalAddr(sockfd));
   // FIXME poll with zero timeout to double confirm the new connection
-  // FIXME use make_shared if necessary
-  TcpConnectionPtr conn(new TcpConnection(ioLoop,
-                                          connName,
-                                          sockfd,
-                                          localAddr,
-                                          peerAddr));
+  // with the control block, recycled in ioLoop
+  TcpConnectionPtr conn(std::allocate_shared<TcpConnection>(
+      SlabAllocator<TcpConnection>(ioLoop->slabPool()),
+      ioLoop, connName, sockfd, localAddr, peerAddr));
   connections_[connName] = conn;
-  conn->setConnectionCallback(connectionCallback_);
-  conn->setMessageCallback(messageCallback_);
-  conn->setWriteCompleteCallback(writeCompleteCallback_);
-  conn->setCloseCallback(
-      std::bind(&TcpServer::removeConnection, this, _1)); // FIXME: unsafe
+  if (!callbacks_)
+  {
+    callbacks_ = std::make_shared<TcpConnection::Callbacks>();
+    callbacks_->connectionCallback = connectionCallback_;
+    callbacks_->messageCallback = messageCallback_;
+    callbacks_->writeCompleteCallback = writeCompleteCallback_;
+    callbacks_->closeCallback =
+        std::bind(&TcpServer::removeConnection, this, _1); // FIXME: unsafe
+  }
+  conn->setCallbacks(callbacks_);
   ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
 }
 
@@ -14,6 +14,7 @@
 #include "muduo/base/Atomic.h"
 #include "muduo/base/Types.h"
 #include "muduo/net/TcpConnection.h"
+#include "muduo/net/UnixAddress.h"
 
 #include <map>
 
@@ -45,6 +46,15 @@ class TcpServer : noncopyable
             const InetAddress& listenAddr,
             const string& nameArg,
             Option option = kNoReusePort);
+  /// Unix domain socket server, ipPort() is the path.
+  /// @c socketType is SOCK_STREAM or SOCK_SEQPACKET, with SOCK_SEQPACKET
+  /// each read fills the input buffer with one record of up to 64KiB,
+  /// and each send is one record if the output buffer is empty.
+  /// A longer record may not fit, then the connection is closed.
+  TcpServer(EventLoop* loop,
+            const UnixAddress& listenAddr,
+            const string& nameArg,
+            int socketType = SOCK_STREAM);
   ~TcpServer();  // force out-line dtor, for std::unique_ptr members.
 
   const string& ipPort() const { return ipPort_; }
@@ -68,6 +78,17 @@ class TcpServer : noncopyable
   std::shared_ptr<EventLoopThreadPool> threadPool()
   { return threadPool_; }
 
+  /// Accept data in SYN from clients with a TCP Fast Open cookie, for up to
+  /// @c queueLength pending handshakes. Saves a round trip for short
+  /// connections. Needs bit 0x2 of sysctl net.ipv4.tcp_fastopen.
+  /// TCP only, must be called before @c start
+  void setTcpFastOpen(int queueLength);
+
+  /// Deliver a new connection only after its first data arrives, or after
+  /// about @c seconds, so that idle handshakes don't cost a TcpConnection.
+  /// TCP only, must be called before @c start
+  void setDeferAccept(int seconds);
+
   /// Starts the server if it's not listening.
   ///
   /// It's harmless to call it multiple times.
@@ -77,17 +98,17 @@ class TcpServer : noncopyable
   /// Set connection callback.
   /// Not thread safe.
   void setConnectionCallback(const ConnectionCallback& cb)
-  { connectionCallback_ = cb; }
+  { connectionCallback_ = cb; callbacks_.reset(); }
 
   /// Set message callback.
   /// Not thread safe.
   void setMessageCallback(const MessageCallback& cb)
-  { messageCallback_ = cb; }
+  { messageCallback_ = cb; callbacks_.reset(); }
 
   /// Set write complete callback.
   /// Not thread safe.
   void setWriteCompleteCallback(const WriteCompleteCallback& cb)
-  { writeCompleteCallback_ = cb; }
+  { writeCompleteCallback_ = cb; callbacks_.reset(); }
 
  private:
   /// Not thread safe, but in loop
@@ -110,6 +131,7 @@ class TcpServer : noncopyable
   ThreadInitCallback threadInitCallback_;
   AtomicInt32 started_;
   // always in loop thread
+  TcpConnection::CallbacksPtr callbacks_;  // shared by connections
   int nextConnId_;
   ConnectionMap connections_;
 };
@@ -12,6 +12,7 @@
 
 #include "muduo/net/TimerQueue.h"
 
+#include "muduo/base/FlightRecorder.h"
 #include "muduo/base/Logging.h"
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/Timer.h"
@@ -59,6 +60,7 @@ void readTimerfd(int timerfd, Timestamp now)
   uint64_t howmany;
   ssize_t n = ::read(timerfd, &howmany, sizeof howmany);
   LOG_TRACE << "TimerQueue::handleRead() " << howmany << " at " << now.toString();
+  RECORD_TRACE("TimerQueue::handleRead howmany", static_cast<int64_t>(howmany));
   if (n != sizeof howmany)
   {
     LOG_ERROR << "TimerQueue::handleRead() reads " << n << " bytes instead of 8";
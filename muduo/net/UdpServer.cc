@@ -0,0 +1,81 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/net/UdpServer.h"
+
+#include "muduo/base/FlightRecorder.h"
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThreadPool.h"
+
+using namespace muduo;
+using namespace muduo::net;
+
+UdpServer::UdpServer(EventLoop* loop,
+                     const InetAddress& listenAddr,
+                     const string& nameArg)
+  : loop_(CHECK_NOTNULL(loop)),
+    listenAddr_(listenAddr),
+    name_(nameArg),
+    threadPool_(new EventLoopThreadPool(loop, name_)),
+    batchSize_(UdpSocket::kDefaultBatchSize),
+    bufferSize_(UdpSocket::kDefaultBufferSize),
+    receiveOffload_(false),
+    sendOffload_(false)
+{
+}
+
+UdpServer::~UdpServer()
+{
+  loop_->assertInLoopThread();
+  LOG_TRACE << "UdpServer::~UdpServer [" << name_ << "] destructing";
+  RECORD_TRACE("UdpServer::~UdpServer");
+
+  for (const UdpSocketPtr& socket : sockets_)
+  {
+    socket->getLoop()->runInLoop(std::bind(&UdpSocket::stop, socket));
+  }
+}
+
+void UdpServer::setThreadNum(int numThreads)
+{
+  assert(0 <= numThreads);
+  threadPool_->setThreadNum(numThreads);
+}
+
+void UdpServer::start()
+{
+  if (started_.getAndSet(1) == 0)
+  {
+    threadPool_->start(threadInitCallback_);
+
+    InetAddress addr(listenAddr_);
+    for (EventLoop* ioLoop : threadPool_->getAllLoops())
+    {
+      UdpSocketPtr socket(new UdpSocket(ioLoop, addr, true));
+      if (addr.port() == 0)
+      {
+        // the others share the port picked for the first one
+        addr = socket->localAddress();
+      }
+      socket->setDatagramCallback(datagramCallback_);
+      socket->setBatch(batchSize_, bufferSize_);
+      if (receiveOffload_)
+        socket->setReceiveOffload(true);
+      if (sendOffload_)
+        socket->setSendOffload(true);
+      socket->start();
+      sockets_.push_back(socket);
+    }
+    LOG_INFO << "UdpServer [" << name_ << "] listening on " << addr.toIpPort()
+             << " with " << sockets_.size() << " sockets";
+  }
+}
+
+InetAddress UdpServer::localAddress() const
+{
+  assert(!sockets_.empty());
+  return sockets_.front()->localAddress();
+}
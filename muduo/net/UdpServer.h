@@ -0,0 +1,87 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_UDPSERVER_H
+#define MUDUO_NET_UDPSERVER_H
+
+#include "muduo/base/Atomic.h"
+#include "muduo/base/Types.h"
+#include "muduo/net/UdpSocket.h"
+
+namespace muduo
+{
+namespace net
+{
+
+class EventLoop;
+class EventLoopThreadPool;
+
+///
+/// UDP server, one UdpSocket per loop.
+///
+/// All sockets are bound to the same address with SO_REUSEPORT, the kernel
+/// spreads datagrams across them by hashing the address of peers, so that
+/// datagrams of a peer are always handled in the same loop.
+///
+class UdpServer : noncopyable
+{
+ public:
+  typedef std::function<void(EventLoop*)> ThreadInitCallback;
+
+  UdpServer(EventLoop* loop,
+            const InetAddress& listenAddr,
+            const string& nameArg);
+  ~UdpServer();
+
+  const string& name() const { return name_; }
+  EventLoop* getLoop() const { return loop_; }
+
+  /// Set the number of threads, each has a socket.
+  /// - 0 means all I/O in loop's thread, this is the default value.
+  /// - N means N threads, and no I/O in loop's thread.
+  /// Must be called before @c start
+  void setThreadNum(int numThreads);
+  void setThreadInitCallback(const ThreadInitCallback& cb)
+  { threadInitCallback_ = cb; }
+
+  /// Applied to every socket, see UdpSocket.
+  /// Not thread safe, must be called before @c start
+  void setDatagramCallback(const UdpSocket::DatagramCallback& cb)
+  { datagramCallback_ = cb; }
+  void setBatch(int batchSize, int bufferSize)
+  { batchSize_ = batchSize; bufferSize_ = bufferSize; }
+  void setReceiveOffload(bool on) { receiveOffload_ = on; }
+  void setSendOffload(bool on) { sendOffload_ = on; }
+
+  /// Starts the server if it's not started.
+  ///
+  /// It's harmless to call it multiple times.
+  /// Thread safe.
+  void start();
+
+  /// valid after calling start(), the bound port if listenAddr has port 0.
+  InetAddress localAddress() const;
+
+ private:
+  EventLoop* loop_;
+  const InetAddress listenAddr_;
+  const string name_;
+  std::shared_ptr<EventLoopThreadPool> threadPool_;
+  UdpSocket::DatagramCallback datagramCallback_;
+  ThreadInitCallback threadInitCallback_;
+  int batchSize_;
+  int bufferSize_;
+  bool receiveOffload_;
+  bool sendOffload_;
+  AtomicInt32 started_;
+  std::vector<UdpSocketPtr> sockets_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_UDPSERVER_H
@@ -0,0 +1,436 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/net/UdpSocket.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/Channel.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/Socket.h"
+#include "muduo/net/SocketsOps.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+const int kMaxSegments = 64;           // UDP_MAX_SEGMENTS of kernel
+const size_t kMaxOffloadBytes = 65000;  // fits in one IP packet
+const int kOffloadBufferSize = 65536;
+
+bool samePeer(const InetAddress& lhs, const InetAddress& rhs)
+{
+  if (lhs.family() != rhs.family())
+    return false;
+  size_t len = lhs.family() == AF_INET ? sizeof(struct sockaddr_in)
+                                       : sizeof(struct sockaddr_in6);
+  return memcmp(lhs.getSockAddr(), rhs.getSockAddr(), len) == 0;
+}
+
+socklen_t addressLength(const InetAddress& addr)
+{
+  return static_cast<socklen_t>(addr.family() == AF_INET ? sizeof(struct sockaddr_in)
+                                                         : sizeof(struct sockaddr_in6));
+}
+
+}  // namespace
+
+struct UdpSocket::RecvBatch
+{
+  std::vector<struct mmsghdr> msgs;
+  std::vector<struct iovec> iovs;
+  std::vector<struct sockaddr_in6> addrs;
+  std::vector<char> buffer;
+  std::vector<char> control;
+  size_t controlLen;
+};
+
+struct UdpSocket::SendBatch
+{
+  std::vector<struct mmsghdr> msgs;
+  std::vector<struct iovec> iovs;
+  std::vector<struct sockaddr_in6> addrs;
+  std::vector<char> control;
+  std::vector<int> datagrams;  // in each message
+  size_t controlLen;
+};
+
+UdpSocket::UdpSocket(EventLoop* loop, const InetAddress& localAddr, bool reusePort)
+  : loop_(CHECK_NOTNULL(loop)),
+    socket_(new Socket(sockets::createNonblockingUdpOrDie(localAddr.family()))),
+    channel_(new Channel(loop, socket_->fd())),
+    batchSize_(kDefaultBatchSize),
+    bufferSize_(kDefaultBufferSize),
+    highWaterMark_(4 * 1024 * 1024),
+    receiveOffload_(false),
+    sendOffload_(false),
+    started_(false),
+    numFlushed_(0),
+    flushQueued_(false),
+    numReceived_(0),
+    numSent_(0),
+    numDropped_(0)
+{
+  socket_->setReuseAddr(true);
+  socket_->setReusePort(reusePort);
+  socket_->bindAddress(localAddr);
+  channel_->setReadCallback(
+      std::bind(&UdpSocket::handleRead, this, _1));
+  channel_->setWriteCallback(
+      std::bind(&UdpSocket::handleWrite, this));
+}
+
+UdpSocket::~UdpSocket()
+{
+  assert(!started_);
+}
+
+int UdpSocket::fd() const
+{
+  return socket_->fd();
+}
+
+InetAddress UdpSocket::localAddress() const
+{
+  return InetAddress(sockets::getLocalAddr(socket_->fd()));
+}
+
+void UdpSocket::setBatch(int batchSize, int bufferSize)
+{
+  // startInLoop() sized the batches
+  assert(!started_);
+  assert(batchSize > 0 && bufferSize > 0);
+  batchSize_ = batchSize;
+  bufferSize_ = bufferSize;
+}
+
+bool UdpSocket::setReceiveOffload(bool on)
+{
+  assert(!started_);
+  int optval = on ? 1 : 0;
+  if (::setsockopt(socket_->fd(), SOL_UDP, UDP_GRO, &optval,
+                   static_cast<socklen_t>(sizeof optval)) < 0)
+  {
+    LOG_SYSERR << "UDP_GRO failed";
+    return false;
+  }
+  receiveOffload_ = on;
+  return true;
+}
+
+bool UdpSocket::setSendOffload(bool on)
+{
+  assert(!started_);
+  // probes with a zero segment size, which turns it off
+  int optval = 0;
+  if (on && ::setsockopt(socket_->fd(), SOL_UDP, UDP_SEGMENT, &optval,
+                         static_cast<socklen_t>(sizeof optval)) < 0)
+  {
+    LOG_SYSERR << "UDP_SEGMENT failed";
+    return false;
+  }
+  sendOffload_ = on;
+  return true;
+}
+
+void UdpSocket::start()
+{
+  loop_->runInLoop(std::bind(&UdpSocket::startInLoop, shared_from_this()));
+}
+
+void UdpSocket::startInLoop()
+{
+  loop_->assertInLoopThread();
+  if (started_)
+    return;
+  started_ = true;
+
+  const int bufferSize = receiveOffload_ ? std::max(bufferSize_, kOffloadBufferSize) : bufferSize_;
+  recvBatch_.reset(new RecvBatch);
+  RecvBatch& recv = *recvBatch_;
+  recv.msgs.resize(batchSize_);
+  recv.iovs.resize(batchSize_);
+  recv.addrs.resize(batchSize_);
+  recv.buffer.resize(static_cast<size_t>(batchSize_) * bufferSize);
+  recv.controlLen = CMSG_SPACE(sizeof(int));
+  recv.control.resize(batchSize_ * recv.controlLen);
+  for (int i = 0; i < batchSize_; ++i)
+  {
+    recv.iovs[i].iov_base = &recv.buffer[static_cast<size_t>(i) * bufferSize];
+    recv.iovs[i].iov_len = bufferSize;
+  }
+
+  sendBatch_.reset(new SendBatch);
+  SendBatch& send = *sendBatch_;
+  send.msgs.resize(batchSize_);
+  send.iovs.resize(batchSize_ * (sendOffload_ ? kMaxSegments : 1));
+  send.addrs.resize(batchSize_);
+  send.controlLen = CMSG_SPACE(sizeof(uint16_t));
+  send.control.resize(batchSize_ * send.controlLen);
+  send.datagrams.resize(batchSize_);
+
+  channel_->tie(shared_from_this());
+  channel_->enableReading();
+}
+
+void UdpSocket::stop()
+{
+  loop_->assertInLoopThread();
+  if (started_)
+  {
+    started_ = false;
+    channel_->disableAll();
+    channel_->remove();
+  }
+  numDropped_ += pending_.size() - numFlushed_;
+  pending_.clear();
+  numFlushed_ = 0;
+  sendBuffer_.retrieveAll();
+}
+
+void UdpSocket::handleRead(Timestamp receiveTime)
+{
+  loop_->assertInLoopThread();
+  RecvBatch& recv = *recvBatch_;
+  for (int i = 0; i < batchSize_; ++i)
+  {
+    struct msghdr& hdr = recv.msgs[i].msg_hdr;
+    hdr.msg_name = &recv.addrs[i];
+    hdr.msg_namelen = static_cast<socklen_t>(sizeof recv.addrs[i]);
+    hdr.msg_iov = &recv.iovs[i];
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = receiveOffload_ ? &recv.control[i * recv.controlLen] : NULL;
+    hdr.msg_controllen = receiveOffload_ ? recv.controlLen : 0;
+    hdr.msg_flags = 0;
+  }
+
+  int n = ::recvmmsg(socket_->fd(), recv.msgs.data(), batchSize_, MSG_DONTWAIT, NULL);
+  if (n < 0)
+  {
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+    {
+      LOG_SYSERR << "UdpSocket::handleRead";
+    }
+    return;
+  }
+
+  UdpSocketPtr guard(shared_from_this());
+  for (int i = 0; i < n; ++i)
+  {
+    struct msghdr& hdr = recv.msgs[i].msg_hdr;
+    if (hdr.msg_flags & MSG_TRUNC)
+    {
+      ++numDropped_;
+      continue;
+    }
+    const char* data = static_cast<const char*>(recv.iovs[i].iov_base);
+    size_t len = recv.msgs[i].msg_len;
+    size_t segment = len;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(&hdr, cmsg))
+    {
+      if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO)
+      {
+        int gsoSize = 0;
+        memcpy(&gsoSize, CMSG_DATA(cmsg), sizeof gsoSize);
+        if (gsoSize > 0)
+          segment = gsoSize;
+      }
+    }
+
+    InetAddress peer(recv.addrs[i]);
+    size_t offset = 0;
+    do  // once for an empty datagram
+    {
+      size_t size = std::min(segment, len - offset);
+      ++numReceived_;
+      if (datagramCallback_)
+      {
+        datagramCallback_(guard, peer, StringPiece(data + offset, static_cast<int>(size)),
+                          receiveTime);
+      }
+      offset += size;
+    } while (offset < len);
+  }
+}
+
+void UdpSocket::handleWrite()
+{
+  loop_->assertInLoopThread();
+  flush();
+}
+
+void UdpSocket::send(const InetAddress& peer, const StringPiece& datagram)
+{
+  send(peer, datagram.data(), datagram.size());
+}
+
+void UdpSocket::send(const InetAddress& peer, const void* data, size_t len)
+{
+  if (loop_->isInLoopThread())
+  {
+    sendInLoop(peer, data, len);
+  }
+  else
+  {
+    void (UdpSocket::*fp)(const InetAddress&, const string&) = &UdpSocket::sendStringInLoop;
+    loop_->runInLoop(std::bind(fp, shared_from_this(), peer,
+                               string(static_cast<const char*>(data), len)));
+  }
+}
+
+void UdpSocket::sendStringInLoop(const InetAddress& peer, const string& datagram)
+{
+  sendInLoop(peer, datagram.data(), datagram.size());
+}
+
+void UdpSocket::sendInLoop(const InetAddress& peer, const void* data, size_t len)
+{
+  loop_->assertInLoopThread();
+  if (!started_ || sendBuffer_.readableBytes() + len > highWaterMark_)
+  {
+    ++numDropped_;
+    return;
+  }
+  Outgoing out = { peer, sendBuffer_.readableBytes(), len };
+  sendBuffer_.append(data, len);
+  pending_.push_back(out);
+
+  if (channel_->isWriting())
+  {
+    return;  // waiting for the socket to be writable
+  }
+  if (pending_.size() - numFlushed_ >= static_cast<size_t>(batchSize_))
+  {
+    flush();
+  }
+  else if (!flushQueued_)
+  {
+    flushQueued_ = true;
+    std::weak_ptr<UdpSocket> weakSelf(shared_from_this());
+    loop_->queueInLoop([weakSelf] {
+      UdpSocketPtr self(weakSelf.lock());
+      if (self)
+      {
+        self->flushQueued_ = false;
+        self->flush();
+      }
+    });
+  }
+}
+
+int UdpSocket::fillSendBatch()
+{
+  SendBatch& send = *sendBatch_;
+  const size_t maxSegments = sendOffload_ ? kMaxSegments : 1;
+  size_t next = numFlushed_;
+  size_t iov = 0;
+  int numMsgs = 0;
+  while (numMsgs < batchSize_ && next < pending_.size())
+  {
+    // with offload, the following datagrams of the same size to the same peer,
+    // and a shorter last one, are sent as segments of the first one
+    const Outgoing& first = pending_[next];
+    size_t count = 1;
+    size_t total = first.len;
+    while (count < maxSegments && next + count < pending_.size())
+    {
+      const Outgoing& out = pending_[next + count];
+      if (out.len > first.len || out.len == 0 || total + out.len > kMaxOffloadBytes
+          || !samePeer(out.peer, first.peer))
+        break;
+      total += out.len;
+      ++count;
+      if (out.len < first.len)
+        break;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      const Outgoing& out = pending_[next + i];
+      send.iovs[iov + i].iov_base = const_cast<char*>(sendBuffer_.peek()) + out.offset;
+      send.iovs[iov + i].iov_len = out.len;
+    }
+    memcpy(&send.addrs[numMsgs], first.peer.getSockAddr(), addressLength(first.peer));
+
+    struct msghdr& hdr = send.msgs[numMsgs].msg_hdr;
+    memZero(&hdr, sizeof hdr);
+    hdr.msg_name = &send.addrs[numMsgs];
+    hdr.msg_namelen = addressLength(first.peer);
+    hdr.msg_iov = &send.iovs[iov];
+    hdr.msg_iovlen = count;
+    if (count > 1)
+    {
+      hdr.msg_control = &send.control[numMsgs * send.controlLen];
+      hdr.msg_controllen = send.controlLen;
+      struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+      cmsg->cmsg_level = SOL_UDP;
+      cmsg->cmsg_type = UDP_SEGMENT;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+      uint16_t segmentSize = static_cast<uint16_t>(first.len);
+      memcpy(CMSG_DATA(cmsg), &segmentSize, sizeof segmentSize);
+    }
+    send.datagrams[numMsgs] = static_cast<int>(count);
+    ++numMsgs;
+    next += count;
+    iov += count;
+  }
+  return numMsgs;
+}
+
+void UdpSocket::flush()
+{
+  loop_->assertInLoopThread();
+  if (!started_)
+    return;
+
+  while (numFlushed_ < pending_.size())
+  {
+    int numMsgs = fillSendBatch();
+    int n = ::sendmmsg(socket_->fd(), sendBatch_->msgs.data(), numMsgs, MSG_DONTWAIT);
+    if (n < 0)
+    {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS)
+      {
+        if (!channel_->isWriting())
+        {
+          channel_->enableWriting();
+        }
+        return;
+      }
+      // the first message failed, drop it
+      LOG_SYSERR << "UdpSocket::flush to " << pending_[numFlushed_].peer.toIpPort();
+      numDropped_ += sendBatch_->datagrams[0];
+      numFlushed_ += sendBatch_->datagrams[0];
+      continue;
+    }
+    for (int i = 0; i < n; ++i)
+    {
+      numSent_ += sendBatch_->datagrams[i];
+      numFlushed_ += sendBatch_->datagrams[i];
+    }
+  }
+
+  pending_.clear();
+  numFlushed_ = 0;
+  sendBuffer_.retrieveAll();
+  if (channel_->isWriting())
+  {
+    channel_->disableWriting();
+  }
+}
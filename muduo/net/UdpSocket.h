@@ -0,0 +1,138 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_UDPSOCKET_H
+#define MUDUO_NET_UDPSOCKET_H
+
+#include "muduo/base/noncopyable.h"
+#include "muduo/base/StringPiece.h"
+#include "muduo/base/Timestamp.h"
+#include "muduo/base/Types.h"
+#include "muduo/net/Buffer.h"
+#include "muduo/net/InetAddress.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+class Channel;
+class EventLoop;
+class Socket;
+class UdpSocket;
+
+typedef std::shared_ptr<UdpSocket> UdpSocketPtr;
+
+///
+/// UDP socket in an EventLoop, for both client and server usage.
+///
+/// Receives up to a batch of datagrams with one recvmmsg(2). Sends are
+/// queued and go out with sendmmsg(2) at the end of the loop iteration,
+/// so replies made while handling a batch are sent in a batch too.
+///
+/// Must be held by std::shared_ptr, like TcpConnection.
+class UdpSocket : noncopyable,
+                  public std::enable_shared_from_this<UdpSocket>
+{
+ public:
+  typedef std::function<void (const UdpSocketPtr&,
+                              const InetAddress& peer,
+                              StringPiece datagram,
+                              Timestamp receiveTime)> DatagramCallback;
+
+  static const int kDefaultBatchSize = 32;
+  static const int kDefaultBufferSize = 2048;
+
+  /// Binds to localAddr, whose port may be 0 for clients.
+  UdpSocket(EventLoop* loop, const InetAddress& localAddr, bool reusePort = false);
+  ~UdpSocket();
+
+  EventLoop* getLoop() const { return loop_; }
+  int fd() const;
+  InetAddress localAddress() const;
+
+  /// Not thread safe, call them before start().
+  void setDatagramCallback(const DatagramCallback& cb)
+  { datagramCallback_ = cb; }
+  /// Datagrams per system call, and bytes of each receive buffer.
+  /// Longer datagrams are truncated and dropped.
+  void setBatch(int batchSize, int bufferSize);
+  /// Pending sends beyond it are dropped, 4MB by default.
+  void setHighWaterMark(size_t bytes) { highWaterMark_ = bytes; }
+  /// UDP_GRO, the kernel coalesces a burst of datagrams from a peer into
+  /// one receive buffer of 64KB, which is split before calling back.
+  /// Returns false if not supported.
+  bool setReceiveOffload(bool on);
+  /// UDP_SEGMENT, consecutive datagrams of the same size to the same peer
+  /// are sent as one, and segmented by the kernel or the NIC.
+  /// Returns false if not supported.
+  bool setSendOffload(bool on);
+
+  /// Starts reading. Thread safe.
+  void start();
+  /// Stops reading and writing, pending sends are dropped.
+  /// Must be called in loop thread before destruction if started.
+  void stop();
+
+  /// Thread safe.
+  void send(const InetAddress& peer, const void* data, size_t len);
+  void send(const InetAddress& peer, const StringPiece& datagram);
+
+  /// In loop thread.
+  int64_t numReceived() const { return numReceived_; }
+  int64_t numSent() const { return numSent_; }
+  int64_t numDropped() const { return numDropped_; }
+
+ private:
+  struct Outgoing
+  {
+    InetAddress peer;
+    size_t offset;  // in sendBuffer_
+    size_t len;
+  };
+  struct RecvBatch;
+  struct SendBatch;
+
+  void startInLoop();
+  void handleRead(Timestamp receiveTime);
+  void handleWrite();
+  void sendInLoop(const InetAddress& peer, const void* data, size_t len);
+  void sendStringInLoop(const InetAddress& peer, const string& datagram);
+  void flush();
+  int fillSendBatch();
+
+  EventLoop* loop_;
+  std::unique_ptr<Socket> socket_;
+  std::unique_ptr<Channel> channel_;
+  DatagramCallback datagramCallback_;
+  int batchSize_;
+  int bufferSize_;
+  size_t highWaterMark_;
+  bool receiveOffload_;
+  bool sendOffload_;
+  bool started_;  // in loop thread
+
+  std::unique_ptr<RecvBatch> recvBatch_;
+  std::unique_ptr<SendBatch> sendBatch_;
+  Buffer sendBuffer_;
+  std::vector<Outgoing> pending_;
+  size_t numFlushed_;  // of pending_
+  bool flushQueued_;
+
+  int64_t numReceived_;
+  int64_t numSent_;
+  int64_t numDropped_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_UDPSOCKET_H
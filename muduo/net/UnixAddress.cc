@@ -0,0 +1,81 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/net/UnixAddress.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/SocketsOps.h"
+
+#include <stddef.h>  // offsetof
+#include <string.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+//     struct sockaddr_un {
+//         sa_family_t sun_family;    /* AF_UNIX */
+//         char        sun_path[108]; /* pathname */
+//     };
+//
+// A pathname is NUL terminated, an abstract name starts with a NUL byte
+// and its length is given by the address length, not by another NUL.
+
+static const size_t kPathOffset = offsetof(struct sockaddr_un, sun_path);
+
+UnixAddress::UnixAddress(StringArg pathArg)
+{
+  memZero(&addr_, sizeof addr_);
+  addr_.sun_family = AF_UNIX;
+  const char* path = pathArg.c_str();
+  size_t len = ::strlen(path);
+  if (path[0] == '@')
+  {
+    // abstract, "@name" -> "\0name"
+    if (len > sizeof addr_.sun_path)
+    {
+      LOG_FATAL << "UnixAddress::UnixAddress - too long " << path;
+    }
+    ::memcpy(addr_.sun_path + 1, path + 1, len - 1);
+    len_ = static_cast<socklen_t>(kPathOffset + len);
+  }
+  else
+  {
+    if (len >= sizeof addr_.sun_path)
+    {
+      LOG_FATAL << "UnixAddress::UnixAddress - too long " << path;
+    }
+    ::memcpy(addr_.sun_path, path, len);
+    len_ = static_cast<socklen_t>(kPathOffset + len + 1);
+  }
+}
+
+UnixAddress::UnixAddress(const struct sockaddr_un& addr, socklen_t len)
+  : addr_(addr),
+    len_(len)
+{
+  assert(addr.sun_family == AF_UNIX);
+  assert(len <= sizeof addr_);
+}
+
+bool UnixAddress::isAbstract() const
+{
+  return len_ > kPathOffset && addr_.sun_path[0] == '\0';
+}
+
+string UnixAddress::path() const
+{
+  if (len_ <= kPathOffset)
+  {
+    return string();  // unnamed
+  }
+  size_t len = len_ - kPathOffset;
+  if (isAbstract())
+  {
+    string result(addr_.sun_path, len);
+    result[0] = '@';
+    return result;
+  }
+  return string(addr_.sun_path, ::strnlen(addr_.sun_path, len));
+}
@@ -0,0 +1,61 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_UNIXADDRESS_H
+#define MUDUO_NET_UNIXADDRESS_H
+
+#include "muduo/base/copyable.h"
+#include "muduo/base/StringPiece.h"
+#include "muduo/base/Types.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace muduo
+{
+namespace net
+{
+namespace sockets
+{
+const struct sockaddr* sockaddr_cast(const struct sockaddr_un* addr);
+}
+
+///
+/// Wrapper of sockaddr_un, the address of a Unix domain socket.
+///
+/// This is an POD interface class.
+class UnixAddress : public muduo::copyable
+{
+ public:
+  /// Constructs an endpoint with given path, e.g. "/run/app.sock",
+  /// or a name in the abstract namespace if it starts with '@', e.g. "@app".
+  /// Aborts if the path is longer than sun_path.
+  explicit UnixAddress(StringArg path);
+
+  /// Constructs an endpoint with given struct @c sockaddr_un
+  UnixAddress(const struct sockaddr_un& addr, socklen_t len);
+
+  sa_family_t family() const { return addr_.sun_family; }
+  /// The path, with a leading '@' for the abstract namespace,
+  /// empty for unnamed sockets.
+  string path() const;
+  bool isAbstract() const;
+
+  // default copy/assignment are Okay
+
+  const struct sockaddr* getSockAddr() const { return sockets::sockaddr_cast(&addr_); }
+  socklen_t length() const { return len_; }
+
+ private:
+  struct sockaddr_un addr_;
+  socklen_t len_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_UNIXADDRESS_H
@@ -9,6 +9,8 @@
 
 #include "muduo/net/inspect/ProcessInspector.h"
 #include "muduo/base/FileUtil.h"
+#include "muduo/base/FlightRecorder.h"
+#include "muduo/base/MutexProfiler.h"
 #include "muduo/base/ProcessInfo.h"
 #include <limits.h>
 #include <stdio.h>
@@ -128,6 +130,10 @@ void ProcessInspector::registerCommands(Inspector* ins)
   ins->add("proc", "status", ProcessInspector::procStatus, "print /proc/self/status");
   // ins->add("proc", "opened_files", ProcessInspector::openedFiles, "count /proc/self/fd");
   ins->add("proc", "threads", ProcessInspector::threads, "list /proc/self/task");
+  ins->add("proc", "flightrecorder", ProcessInspector::flightRecorder,
+           "dump recent TRACE/DEBUG records of each thread");
+  ins->add("proc", "mutex", ProcessInspector::mutexProfile,
+           "print contention of MutexLock, /proc/mutex/enable or /proc/mutex/disable");
 }
 
 string ProcessInspector::overview(HttpRequest::Method, const Inspector::ArgList&)
@@ -237,3 +243,21 @@ string ProcessInspector::threads(HttpRequest::Method, const Inspector::ArgList&)
   return result;
 }
 
+
+string ProcessInspector::flightRecorder(HttpRequest::Method, const Inspector::ArgList&)
+{
+  return FlightRecorder::dumpToString();
+}
+
+string ProcessInspector::mutexProfile(HttpRequest::Method, const Inspector::ArgList& args)
+{
+  if (!args.empty() && args[0] == "enable")
+  {
+    MutexProfiler::enable();
+  }
+  else if (!args.empty() && args[0] == "disable")
+  {
+    MutexProfiler::disable();
+  }
+  return MutexProfiler::report();
+}
@@ -8,6 +8,7 @@
 
 #include "muduo/net/poller/EPollPoller.h"
 
+#include "muduo/base/FlightRecorder.h"
 #include "muduo/base/Logging.h"
 #include "muduo/net/Channel.h"
 
@@ -64,6 +65,8 @@ Timestamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels)
   if (numEvents > 0)
   {
     LOG_TRACE << numEvents << " events happened";
+    RECORD_TRACE("EPollPoller::poll events, fd total count",
+                 numEvents, static_cast<int64_t>(channels_.size()));
     fillActiveChannels(numEvents, activeChannels);
     if (implicit_cast<size_t>(numEvents) == events_.size())
     {
@@ -94,10 +97,7 @@ void EPollPoller::fillActiveChannels(int numEvents,
   {
     Channel* channel = static_cast<Channel*>(events_[i].data.ptr);
 #ifndef NDEBUG
-    int fd = channel->fd();
-    ChannelMap::const_iterator it = channels_.find(fd);
-    assert(it != channels_.end());
-    assert(it->second == channel);
+    assert(channels_.find(channel->fd()) == channel);
 #endif
     channel->set_revents(events_[i].events);
     activeChannels->push_back(channel);
@@ -110,19 +110,18 @@ void EPollPoller::updateChannel(Channel* channel)
   const int index = channel->index();
   LOG_TRACE << "fd = " << channel->fd()
     << " events = " << channel->events() << " index = " << index;
+  RECORD_TRACE("EPollPoller::updateChannel fd, events", channel->fd(), channel->events());
   if (index == kNew || index == kDeleted)
   {
     // a new one, add with EPOLL_CTL_ADD
     int fd = channel->fd();
     if (index == kNew)
     {
-      assert(channels_.find(fd) == channels_.end());
-      channels_[fd] = channel;
+      channels_.insert(fd, channel);
     }
     else // index == kDeleted
     {
-      assert(channels_.find(fd) != channels_.end());
-      assert(channels_[fd] == channel);
+      assert(channels_.find(fd) == channel);
     }
 
     channel->set_index(kAdded);
@@ -133,8 +132,7 @@ void EPollPoller::updateChannel(Channel* channel)
     // update existing one with EPOLL_CTL_MOD/DEL
     int fd = channel->fd();
     (void)fd;
-    assert(channels_.find(fd) != channels_.end());
-    assert(channels_[fd] == channel);
+    assert(channels_.find(fd) == channel);
     assert(index == kAdded);
     if (channel->isNoneEvent())
     {
@@ -153,8 +151,8 @@ void EPollPoller::removeChannel(Channel* channel)
   Poller::assertInLoopThread();
   int fd = channel->fd();
   LOG_TRACE << "fd = " << fd;
-  assert(channels_.find(fd) != channels_.end());
-  assert(channels_[fd] == channel);
+  RECORD_TRACE("EPollPoller::removeChannel fd", fd);
+  assert(channels_.find(fd) == channel);
   assert(channel->isNoneEvent());
   int index = channel->index();
   assert(index == kAdded || index == kDeleted);
@@ -178,6 +176,7 @@ void EPollPoller::update(int operation, Channel* channel)
   int fd = channel->fd();
   LOG_TRACE << "epoll_ctl op = " << operationToString(operation)
     << " fd = " << fd << " event = { " << channel->eventsToString() << " }";
+  RECORD_TRACE("EPollPoller::update epoll_ctl op, fd", operation, fd);
   if (::epoll_ctl(epollfd_, operation, fd, &event) < 0)
   {
     if (operation == EPOLL_CTL_DEL)
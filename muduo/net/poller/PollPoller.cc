@@ -8,6 +8,7 @@
 
 #include "muduo/net/poller/PollPoller.h"
 
+#include "muduo/base/FlightRecorder.h"
 #include "muduo/base/Logging.h"
 #include "muduo/base/Types.h"
 #include "muduo/net/Channel.h"
@@ -35,6 +36,8 @@ Timestamp PollPoller::poll(int timeoutMs, ChannelList* activeChannels)
   if (numEvents > 0)
   {
     LOG_TRACE << numEvents << " events happened";
+    RECORD_TRACE("PollPoller::poll events, fd total count",
+                 numEvents, static_cast<int64_t>(pollfds_.size()));
     fillActiveChannels(numEvents, activeChannels);
   }
   else if (numEvents == 0)
@@ -61,9 +64,8 @@ void PollPoller::fillActiveChannels(int numEvents,
     if (pfd->revents > 0)
     {
       --numEvents;
-      ChannelMap::const_iterator ch = channels_.find(pfd->fd);
-      assert(ch != channels_.end());
-      Channel* channel = ch->second;
+      Channel* channel = channels_.find(pfd->fd);
+      assert(channel != NULL);
       assert(channel->fd() == pfd->fd);
       channel->set_revents(pfd->revents);
       // pfd->revents = 0;
@@ -76,10 +78,10 @@ void PollPoller::updateChannel(Channel* channel)
 {
   Poller::assertInLoopThread();
   LOG_TRACE << "fd = " << channel->fd() << " events = " << channel->events();
+  RECORD_TRACE("PollPoller::updateChannel fd, events", channel->fd(), channel->events());
   if (channel->index() < 0)
   {
     // a new one, add to pollfds_
-    assert(channels_.find(channel->fd()) == channels_.end());
     struct pollfd pfd;
     pfd.fd = channel->fd();
     pfd.events = static_cast<short>(channel->events());
@@ -87,13 +89,12 @@ void PollPoller::updateChannel(Channel* channel)
     pollfds_.push_back(pfd);
     int idx = static_cast<int>(pollfds_.size())-1;
     channel->set_index(idx);
-    channels_[pfd.fd] = channel;
+    channels_.insert(pfd.fd, channel);
   }
   else
   {
     // update existing one
-    assert(channels_.find(channel->fd()) != channels_.end());
-    assert(channels_[channel->fd()] == channel);
+    assert(channels_.find(channel->fd()) == channel);
     int idx = channel->index();
     assert(0 <= idx && idx < static_cast<int>(pollfds_.size()));
     struct pollfd& pfd = pollfds_[idx];
@@ -113,8 +114,8 @@ void PollPoller::removeChannel(Channel* channel)
 {
   Poller::assertInLoopThread();
   LOG_TRACE << "fd = " << channel->fd();
-  assert(channels_.find(channel->fd()) != channels_.end());
-  assert(channels_[channel->fd()] == channel);
+  RECORD_TRACE("PollPoller::removeChannel fd", channel->fd());
+  assert(channels_.find(channel->fd()) == channel);
   assert(channel->isNoneEvent());
   int idx = channel->index();
   assert(0 <= idx && idx < static_cast<int>(pollfds_.size()));
@@ -134,7 +135,7 @@ void PollPoller::removeChannel(Channel* channel)
     {
       channelAtEnd = -channelAtEnd-1;
     }
-    channels_[channelAtEnd]->set_index(idx);
+    channels_.find(channelAtEnd)->set_index(idx);
     pollfds_.pop_back();
   }
 }
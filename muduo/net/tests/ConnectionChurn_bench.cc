@@ -0,0 +1,154 @@
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/Logging.h"
+#include "muduo/base/Thread.h"
+#include "muduo/base/tests/HeapCounter.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThread.h"
+#include "muduo/net/EventLoopThreadPool.h"
+#include "muduo/net/SlabPool.h"
+#include "muduo/net/SocketsOps.h"
+#include "muduo/net/TcpServer.h"
+
+#include <atomic>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Connections per second of a server sending a line and closing, with
+// TcpConnection, Socket and Channel from the heap or from the slab pool
+// of each io loop. Clients are blocking threads: connect, read to EOF,
+// close.
+//
+// Usage: connectionchurn_bench [threads] [clients] [seconds]
+
+using namespace muduo;
+using namespace muduo::net;
+
+uint16_t freePort()
+{
+  int sockfd = sockets::createNonblockingOrDie(AF_INET);
+  InetAddress addr(0, true);
+  sockets::bindOrDie(sockfd, addr.getSockAddr());
+  uint16_t port = InetAddress(sockets::getLocalAddr(sockfd)).port();
+  sockets::close(sockfd);
+  return port;
+}
+
+std::atomic<bool> g_running;
+std::atomic<int64_t> g_connections;
+std::atomic<int> g_live;  // on the server side
+
+void onConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    ++g_live;
+    conn->send("UP\r\n");
+    conn->shutdown();
+  }
+  else
+  {
+    --g_live;
+  }
+}
+
+void client(const InetAddress& serverAddr)
+{
+  char buf[64];
+  while (g_running.load(std::memory_order_relaxed))
+  {
+    int sockfd = sockets::createNonblockingOrDie(AF_INET);
+    // blocking from now on
+    int flags = ::fcntl(sockfd, F_GETFL, 0);
+    ::fcntl(sockfd, F_SETFL, flags & ~O_NONBLOCK);
+    if (sockets::connect(sockfd, serverAddr.getSockAddr()) < 0)
+    {
+      LOG_SYSFATAL << "connect";
+    }
+    while (sockets::read(sockfd, buf, sizeof buf) > 0)
+    {
+    }
+    sockets::close(sockfd);
+    g_connections.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void run(const char* name, int numThreads, int numClients, double seconds)
+{
+  EventLoopThread serverThread;
+  EventLoop* loop = serverThread.startLoop();
+  InetAddress serverAddr(freePort(), true);
+  std::unique_ptr<TcpServer> server;
+  std::vector<EventLoop*> ioLoops;
+  CountDownLatch latch(1);
+  loop->runInLoop([&] {
+    server.reset(new TcpServer(loop, serverAddr, "Churn"));
+    server->setThreadNum(numThreads);
+    server->setConnectionCallback(onConnection);
+    server->start();
+    ioLoops = server->threadPool()->getAllLoops();
+    latch.countDown();
+  });
+  latch.wait();
+
+  g_running = true;
+  g_connections = 0;
+  std::vector<std::unique_ptr<Thread>> clients;
+  for (int i = 0; i < numClients; ++i)
+  {
+    clients.emplace_back(new Thread(std::bind(client, serverAddr)));
+  }
+  Timestamp start = Timestamp::now();
+  int64_t allocations = g_heapAllocations.load();
+  for (auto& thr : clients)
+  {
+    thr->start();
+  }
+  ::usleep(static_cast<useconds_t>(seconds * 1000 * 1000));
+  g_running = false;
+  for (auto& thr : clients)
+  {
+    thr->join();
+  }
+  allocations = g_heapAllocations.load() - allocations;
+  double elapsed = timeDifference(Timestamp::now(), start);
+  int64_t connections = g_connections.load();
+
+  printf("%-5s %8.0f connections/s  %6.2f operator new per connection\n",
+         name, static_cast<double>(connections) / elapsed,
+         static_cast<double>(allocations) / static_cast<double>(connections));
+
+  // the server goes after its connections are removed
+  while (g_live.load() > 0)
+  {
+    ::usleep(1000);
+  }
+  for (EventLoop* ioLoop : ioLoops)
+  {
+    // removeConnection() is queued to loop after the callback
+    CountDownLatch done(1);
+    ioLoop->runInLoop([&done] { done.countDown(); });
+    done.wait();
+  }
+  CountDownLatch stopped(1);
+  loop->runInLoop([&] {
+    server.reset();
+    stopped.countDown();
+  });
+  stopped.wait();
+}
+
+int main(int argc, char* argv[])
+{
+  Logger::setLogLevel(Logger::WARN);
+  int numThreads = argc > 1 ? atoi(argv[1]) : 2;
+  int numClients = argc > 2 ? atoi(argv[2]) : 4;
+  double seconds = argc > 3 ? atof(argv[3]) : 3;
+  printf("%d io threads, %d clients, %.1f seconds each\n", numThreads, numClients, seconds);
+
+  SlabPool::setEnabled(false);
+  run("heap", numThreads, numClients, seconds);
+  SlabPool::setEnabled(true);
+  run("slab", numThreads, numClients, seconds);
+}
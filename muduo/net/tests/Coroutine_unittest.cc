@@ -0,0 +1,190 @@
+#undef NDEBUG
+#include "muduo/net/Coroutine.h"
+
+#include "muduo/base/tests/HeapCounter.h"
+#include "muduo/net/Endian.h"
+#include "muduo/net/SocketsOps.h"
+#include "muduo/net/TcpServer.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+uint16_t freePort()
+{
+  int sockfd = sockets::createNonblockingOrDie(AF_INET);
+  InetAddress addr(0, true);
+  sockets::bindOrDie(sockfd, addr.getSockAddr());
+  uint16_t port = InetAddress(sockets::getLocalAddr(sockfd)).port();
+  sockets::close(sockfd);
+  return port;
+}
+
+EventLoop* g_loop;
+int g_served = 0;
+
+// One request, in a coroutine of its own. Returns false to close.
+co::Task<bool> handle(co::Stream* stream, StringPiece line)
+{
+  if (line == "sleep")
+  {
+    co_await co::sleep(g_loop, 0.01);
+    co_return co_await stream->write("slept\r\n");
+  }
+  else if (line == "body")
+  {
+    // 4-byte length, then the body
+    StringPiece header = co_await stream->read(4);
+    if (stream->closed())
+      co_return false;
+    uint32_t be32;
+    memcpy(&be32, header.data(), sizeof be32);
+    size_t len = sockets::networkToHost32(be32);
+    StringPiece body = co_await stream->read(len);
+    char buf[64];
+    snprintf(buf, sizeof buf, "body %d %c\r\n", body.size(), body.empty() ? '-' : body[0]);
+    co_return co_await stream->write(buf);
+  }
+  else if (line.starts_with("big "))
+  {
+    // larger than the socket buffer, so that write() suspends
+    string big(static_cast<size_t>(atoi(line.data() + 4)), 'b');
+    co_return (co_await stream->write(big)) && (co_await stream->write("\r\n"));
+  }
+  else if (line == "bye")
+  {
+    stream->shutdown();
+    co_return false;
+  }
+  co_return (co_await stream->write(line)) && (co_await stream->write("\r\n"));
+}
+
+co::Task<> serve(TcpConnectionPtr conn)
+{
+  // responses are written in pieces
+  conn->setTcpNoDelay(true);
+  co::Stream stream(conn);
+  while (true)
+  {
+    StringPiece line = co_await stream.readUntil("\r\n");
+    if (stream.closed() || !co_await handle(&stream, line))
+      break;
+  }
+  ++g_served;
+}
+
+void onServerConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    co::spawn(serve(conn));
+  }
+}
+
+co::Task<string> request(co::Stream* stream, StringPiece req)
+{
+  co_await stream->write(req);
+  StringPiece line = co_await stream->readUntil("\r\n");
+  co_return line.as_string();
+}
+
+co::Task<> client(InetAddress serverAddr)
+{
+  TcpClient client(g_loop, serverAddr, "Client");
+  TcpConnectionPtr conn = co_await co::connect(&client);
+  assert(conn && conn->connected());
+  conn->setTcpNoDelay(true);
+  co::Stream stream(conn);
+
+  printf("echo\n");
+  string reply = co_await request(&stream, "hello\r\n");
+  assert(reply == "hello");
+
+  printf("pipelined\n");
+  co_await stream.write("a\r\nbb\r\n\r\nccc\r\n");
+  StringPiece line = co_await stream.readUntil("\r\n");
+  assert(line == "a");
+  line = co_await stream.readUntil("\r\n");
+  assert(line == "bb");
+  line = co_await stream.readUntil("\r\n");
+  assert(line.empty() && !stream.closed());
+  line = co_await stream.readUntil("\r\n");
+  assert(line == "ccc");
+
+  printf("split\n");
+  co_await stream.write("spl");
+  co_await co::sleep(g_loop, 0.01);
+  co_await stream.write("it\r");
+  co_await co::sleep(g_loop, 0.01);
+  reply = co_await request(&stream, "\n");
+  assert(reply == "split");
+
+  printf("sleep\n");
+  Timestamp start = Timestamp::now();
+  reply = co_await request(&stream, "sleep\r\n");
+  assert(reply == "slept");
+  assert(timeDifference(Timestamp::now(), start) >= 0.01);
+
+  printf("body\n");
+  co_await stream.write("body\r\n");
+  co_await stream.write(StringPiece("\0\0\0\5", 4));
+  co_await co::sleep(g_loop, 0.01);
+  reply = co_await request(&stream, "xyzzy");
+  assert(reply == "body 5 x");
+
+  printf("big\n");
+  const int kBig = 16 * 1000 * 1000;
+  co_await stream.write("big 16000000\r\n");
+  StringPiece big = co_await stream.read(kBig);
+  assert(big.size() == kBig && big[0] == 'b' && big[kBig - 1] == 'b');
+  line = co_await stream.readUntil("\r\n");
+  assert(line.empty());
+  reply = co_await request(&stream, "after big\r\n");
+  assert(reply == "after big");
+
+  printf("steady state\n");
+  for (int i = 0; i < 100; ++i)
+  {
+    co_await request(&stream, "ping\r\n");
+  }
+  int64_t before = g_heapAllocations.load();
+  for (int i = 0; i < 1000; ++i)
+  {
+    co_await stream.write("ping\r\n");
+    StringPiece pong = co_await stream.readUntil("\r\n");
+    assert(pong == "ping");
+  }
+  int64_t allocations = g_heapAllocations.load() - before;
+  printf("%lld allocations in 1000 requests\n", static_cast<long long>(allocations));
+  assert(allocations == 0);
+
+  printf("close\n");
+  co_await stream.write("bye\r\n");
+  StringPiece rest = co_await stream.readUntil("\r\n");
+  assert(rest.empty() && stream.closed());
+  assert(g_served == 1);
+  g_loop->quit();
+}
+
+void timeout()
+{
+  LOG_FATAL << "timed out";
+}
+
+int main()
+{
+  EventLoop loop;
+  g_loop = &loop;
+  InetAddress serverAddr(freePort(), true);
+  TcpServer server(&loop, serverAddr, "Server");
+  server.setConnectionCallback(onServerConnection);
+  server.start();
+
+  loop.runAfter(0, [serverAddr] { co::spawn(client(serverAddr)); });
+  loop.runAfter(10, timeout);
+  loop.loop();
+  printf("done\n");
+}
@@ -0,0 +1,154 @@
+#undef NDEBUG
+#include "muduo/net/Future.h"
+
+#include "muduo/base/CurrentThread.h"
+#include "muduo/base/Logging.h"
+#include "muduo/base/ThreadPool.h"
+#include "muduo/base/tests/HeapCounter.h"
+#include "muduo/net/EventLoopThread.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+EventLoop* g_loop;
+const int kTests = 6;
+int g_done = 0;
+
+void done(const char* name)
+{
+  assert(g_loop->isInLoopThread());
+  printf("%s\n", name);
+  if (++g_done == kTests)
+  {
+    g_loop->quit();
+  }
+}
+
+void testChain(ThreadPool* pool)
+{
+  int loopThread = CurrentThread::tid();
+  offload(pool, [loopThread] {
+    assert(CurrentThread::tid() != loopThread);
+    return 6;
+  }).then(g_loop, [](int x) {
+    assert(g_loop->isInLoopThread());
+    return x * 7;
+  }).then(g_loop, [](int x) {
+    assert(x == 42);
+    done("chain");
+  });
+}
+
+void testWhenAll(ThreadPool* pool)
+{
+  std::vector<Future<int>> futures;
+  for (int i = 0; i < 8; ++i)
+  {
+    futures.push_back(offload(pool, [i] {
+      ::usleep(static_cast<useconds_t>((8 - i) * 1000));
+      return i * i;
+    }));
+  }
+  whenAll(futures).then(g_loop, [](const std::vector<int>& values) {
+    assert(values.size() == 8);
+    for (int i = 0; i < 8; ++i)
+    {
+      assert(values[i] == i * i);
+    }
+    done("whenAll");
+  });
+  whenAll(std::vector<Future<int>>()).then(g_loop, [](const std::vector<int>& values) {
+    assert(values.empty());
+    done("whenAll empty");
+  });
+}
+
+void testWhenAny(EventLoop* otherLoop)
+{
+  std::vector<Promise<string>> promises(3);
+  std::vector<Future<string>> futures;
+  for (const auto& promise : promises)
+  {
+    futures.push_back(promise.getFuture());
+  }
+  whenAny(futures).then(g_loop, [promises](std::pair<size_t, string> first) {
+    assert(first.first == 2 && first.second == "two");
+    // later ones are ignored
+    promises[0].setValue("zero");
+    done("whenAny");
+  });
+  otherLoop->runAfter(0.01, [promises] { promises[2].setValue("two"); });
+  otherLoop->runAfter(0.02, [promises] { promises[1].setValue("one"); });
+}
+
+void testReady()
+{
+  // continuation runs at once, in this loop
+  bool ran = false;
+  makeReadyFuture(string("ready")).then(g_loop, [&ran](const string& value) {
+    assert(value == "ready");
+    ran = true;
+  });
+  assert(ran);
+
+  // move-only value
+  Promise<std::unique_ptr<int>> promise;
+  promise.getFuture().then([](std::unique_ptr<int> p) {
+    assert(*p == 7);
+    done("ready");
+  });
+  promise.setValue(std::unique_ptr<int>(new int(7)));
+}
+
+void testAllocations()
+{
+  Promise<int> promise;
+  int result = 0;
+  int64_t before = g_heapAllocations.load();
+  promise.getFuture().then(g_loop, [&result](int x) { result = x; });
+  promise.setValue(1);
+  assert(result == 1);
+  int64_t allocations = g_heapAllocations.load() - before;
+  printf("%lld allocations for a void continuation\n", static_cast<long long>(allocations));
+  assert(allocations == 0);
+
+  Promise<int> promise2;
+  before = g_heapAllocations.load();
+  Future<int> next = promise2.getFuture().then(g_loop, [](int x) { return x + 1; });
+  allocations = g_heapAllocations.load() - before;
+  printf("%lld allocations for a chained continuation\n", static_cast<long long>(allocations));
+  assert(allocations == 1);
+  promise2.setValue(1);
+  assert(next.isReady() && next.value() == 2);
+  done("allocations");
+}
+
+void timeout()
+{
+  LOG_FATAL << "timed out";
+}
+
+int main()
+{
+  EventLoop loop;
+  g_loop = &loop;
+  ThreadPool pool("pool");
+  pool.start(4);
+  EventLoopThread otherThread;
+  EventLoop* otherLoop = otherThread.startLoop();
+
+  testChain(&pool);
+  testWhenAll(&pool);
+  testWhenAny(otherLoop);
+  testReady();
+  testAllocations();
+
+  loop.runAfter(10, timeout);
+  loop.loop();
+  pool.stop();
+  printf("done\n");
+}
@@ -0,0 +1,190 @@
+#undef NDEBUG
+#include "muduo/net/LoopMesh.h"
+
+#include "muduo/net/EventLoopThreadPool.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int kLoops = 4;
+const int kMessages = 100000;
+
+struct Message
+{
+  int from;
+  int seq;
+};
+
+struct Stats
+{
+  Stats()
+    : received(0), full(0)
+  {
+    for (int i = 0; i < kLoops; ++i)
+      next[i] = 0;
+  }
+
+  int64_t received;
+  int64_t full;
+  int next[kLoops];  // expected seq from each loop
+};
+
+void testLoopLocal(const std::vector<EventLoop*>& loops)
+{
+  printf("loop local\n");
+  LoopLocal<int> local(loops);
+  assert(local.size() == kLoops);
+  CountDownLatch latch(kLoops);
+  for (int i = 0; i < kLoops; ++i)
+  {
+    loops[i]->runInLoop([&local, &latch, i] {
+      assert(local.index().current() == i);
+      local.get() = i * 10;
+      latch.countDown();
+    });
+  }
+  latch.wait();
+  for (int i = 0; i < kLoops; ++i)
+  {
+    assert(local.at(i) == i * 10);
+    assert(&local.get(loops[i]) == &local.at(i));
+  }
+  // of main thread
+  assert(local.index().current() == -1);
+}
+
+// Sends what fits, then the rest after the others had a chance.
+class Sender : public std::enable_shared_from_this<Sender>
+{
+ public:
+  Sender(LoopMesh<Message>* mesh, LoopLocal<Stats>* stats, EventLoop* loop, int index)
+    : mesh_(mesh),
+      stats_(stats),
+      loop_(loop),
+      index_(index),
+      seq_(kLoops)
+  {
+  }
+
+  void run()
+  {
+    bool pending = false;
+    for (int to = 0; to < kLoops; ++to)
+    {
+      while (seq_[to] < kMessages)
+      {
+        Message msg = { index_, seq_[to] };
+        if (!mesh_->send(to, std::move(msg)))
+        {
+          ++stats_->get().full;
+          pending = true;
+          break;
+        }
+        ++seq_[to];
+      }
+    }
+    if (pending)
+    {
+      loop_->queueInLoop(std::bind(&Sender::run, shared_from_this()));
+    }
+  }
+
+ private:
+  LoopMesh<Message>* mesh_;
+  LoopLocal<Stats>* stats_;
+  EventLoop* loop_;
+  const int index_;
+  std::vector<int> seq_;
+};
+
+// every loop sends kMessages to every loop, including itself
+void testAllToAll(const std::vector<EventLoop*>& loops)
+{
+  printf("all to all\n");
+  LoopLocal<Stats> stats(loops);
+  CountDownLatch done(kLoops);
+  std::unique_ptr<LoopMesh<Message>> mesh;
+  LoopMesh<Message>::MessageCallback onMessage =
+      [&stats, &done](int from, Message&& msg) {
+        Stats& s = stats.get();
+        assert(msg.from == from);
+        assert(msg.seq == s.next[from]);
+        ++s.next[from];
+        if (++s.received == static_cast<int64_t>(kLoops) * kMessages)
+        {
+          done.countDown();
+        }
+      };
+  mesh.reset(new LoopMesh<Message>(loops, 256, onMessage));
+
+  for (int i = 0; i < kLoops; ++i)
+  {
+    std::shared_ptr<Sender> sender(new Sender(mesh.get(), &stats, loops[i], i));
+    loops[i]->runInLoop(std::bind(&Sender::run, sender));
+  }
+  done.wait();
+  mesh.reset();
+
+  int64_t full = 0;
+  for (int i = 0; i < kLoops; ++i)
+  {
+    assert(stats.at(i).received == static_cast<int64_t>(kLoops) * kMessages);
+    full += stats.at(i).full;
+  }
+  printf("%d messages, %lld sends found the ring full\n",
+         kLoops * kLoops * kMessages, static_cast<long long>(full));
+}
+
+void testFull(const std::vector<EventLoop*>& loops)
+{
+  printf("full\n");
+  int received = 0;
+  CountDownLatch done(1);
+  LoopMesh<std::unique_ptr<int>> mesh(loops, 3,
+      [&received, &done](int from, std::unique_ptr<int>&& p) {
+        assert(from == 1 && *p == received);
+        if (++received == 5)
+          done.countDown();
+      });
+  // to loop 0, which is held until loop 1 is done sending
+  CountDownLatch sending(1);
+  loops[0]->runInLoop([&sending] { sending.wait(); });
+  loops[1]->runInLoop([&mesh, &sending] {
+    int sent = 0;
+    for (int i = 0; i < 6; ++i)
+    {
+      std::unique_ptr<int> p(new int(i));
+      if (mesh.send(0, std::move(p)))
+        ++sent;
+      else
+        assert(p && *p == i);
+    }
+    assert(sent == 4);
+    // room again once loop 0 has drained, before its functors
+    mesh.index().loop(0)->queueInLoop([&mesh] {
+      mesh.index().loop(1)->runInLoop([&mesh] {
+        bool drained = mesh.send(0, std::unique_ptr<int>(new int(4)));
+        assert(drained);
+      });
+    });
+    sending.countDown();
+  });
+  done.wait();
+}
+
+int main()
+{
+  EventLoop baseLoop;
+  EventLoopThreadPool pool(&baseLoop, "mesh");
+  pool.setThreadNum(kLoops);
+  pool.start();
+  std::vector<EventLoop*> loops = pool.getAllLoops();
+
+  testLoopLocal(loops);
+  testAllToAll(loops);
+  testFull(loops);
+  printf("done\n");
+}
@@ -0,0 +1,286 @@
+#undef NDEBUG
+#include "muduo/net/Resolver.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// A stub DNS server, answers A queries from a table.
+class StubServer : noncopyable
+{
+ public:
+  explicit StubServer(EventLoop* loop)
+    : socket_(new UdpSocket(loop, InetAddress(0, true))),
+      numQueries_(0)
+  {
+    socket_->setDatagramCallback(
+        std::bind(&StubServer::onQuery, this, _1, _2, _3));
+    socket_->start();
+  }
+
+  ~StubServer()
+  {
+    socket_->stop();
+  }
+
+  InetAddress address() const { return socket_->localAddress(); }
+  int numQueries() const { return numQueries_; }
+
+ private:
+  static void put16(string* out, int x)
+  {
+    out->push_back(static_cast<char>(x >> 8));
+    out->push_back(static_cast<char>(x & 0xff));
+  }
+
+  static void put32(string* out, uint32_t x)
+  {
+    put16(out, static_cast<int>(x >> 16));
+    put16(out, static_cast<int>(x & 0xffff));
+  }
+
+  void onQuery(const UdpSocketPtr& socket, const InetAddress& peer, StringPiece query)
+  {
+    ++numQueries_;
+    // header, then QNAME, QTYPE, QCLASS
+    string name;
+    for (int pos = 12; pos < query.size() && query[pos] != 0; pos += query[pos] + 1)
+    {
+      if (!name.empty())
+        name += '.';
+      name.append(query.data() + pos + 1, query[pos]);
+    }
+    LOG_DEBUG << "StubServer query " << name;
+
+    string reply(query.data(), query.size());
+    int rcode = 0;
+    std::vector<uint32_t> addresses;
+    if (name == "a.test")
+    {
+      addresses.push_back(0x0a000001);
+      addresses.push_back(0x0a000002);
+    }
+    else if (name == "cname.test")
+    {
+      addresses.push_back(0x0a000003);
+    }
+    else if (name == "nx.test")
+    {
+      rcode = 3;
+    }
+    else if (name == "slow.test" && ++slowQueries_ == 1)
+    {
+      return;  // drops the first one
+    }
+    else if (name == "slow.test")
+    {
+      addresses.push_back(0x0a000004);
+    }
+    else if (name == "dead.test")
+    {
+      return;
+    }
+    else
+    {
+      rcode = 2;  // SERVFAIL
+    }
+
+    reply[2] = static_cast<char>(0x81);  // QR RD
+    reply[3] = static_cast<char>(0x80 | rcode);  // RA
+    reply[6] = 0;
+    reply[7] = static_cast<char>(name == "cname.test" ? 2 : addresses.size());
+    reply[9] = static_cast<char>(rcode == 3 ? 1 : 0);
+    if (name == "cname.test")
+    {
+      // cname.test CNAME target.test, with compressed NAME
+      put16(&reply, 0xC00C);
+      put16(&reply, 5);
+      put16(&reply, 1);
+      put32(&reply, 60);
+      put16(&reply, 13);
+      reply.append("\006target\004test\000", 13);
+    }
+    for (uint32_t addr : addresses)
+    {
+      put16(&reply, 0xC00C);  // the name in question
+      put16(&reply, 1);  // A
+      put16(&reply, 1);  // IN
+      put32(&reply, name == "a.test" ? 1 : 60);  // TTL
+      put16(&reply, 4);
+      put32(&reply, addr);
+    }
+    if (rcode == 3)
+    {
+      // SOA of test, MNAME and RNAME are root, MINIMUM is 1
+      put16(&reply, 0xC00C + 3);  // test
+      put16(&reply, 6);
+      put16(&reply, 1);
+      put32(&reply, 60);
+      put16(&reply, 22);
+      reply.append("\000\000", 2);
+      put32(&reply, 1);  // SERIAL
+      put32(&reply, 0);
+      put32(&reply, 0);
+      put32(&reply, 0);
+      put32(&reply, 1);  // MINIMUM
+    }
+    socket->send(peer, reply);
+  }
+
+  UdpSocketPtr socket_;
+  int numQueries_;
+  int slowQueries_ = 0;
+};
+
+EventLoop* g_loop;
+Resolver* g_resolver;
+StubServer* g_server;
+// lookups in flight, plus one held while a stage is running
+int g_pending = 0;
+std::vector<std::function<void()>> g_stages;
+size_t g_stage = 0;
+
+void release();
+
+void nextStage()
+{
+  if (g_stage < g_stages.size())
+  {
+    printf("stage %zd\n", g_stage);
+    g_pending = 1;
+    g_stages[g_stage++]();
+    release();
+  }
+  else
+  {
+    g_loop->quit();
+  }
+}
+
+void release()
+{
+  if (--g_pending == 0)
+  {
+    g_loop->queueInLoop(nextStage);
+  }
+}
+
+void expect(const string& name, const std::vector<string>& ips,
+            const std::vector<InetAddress>& result)
+{
+  std::vector<string> got;
+  for (const InetAddress& addr : result)
+    got.push_back(addr.toIp());
+  if (got != ips)
+  {
+    LOG_FATAL << name << " got " << got.size() << " addresses, expect " << ips.size()
+              << (got.empty() ? "" : " first " + got[0]);
+  }
+  printf("  %s -> %zd addresses\n", name.c_str(), got.size());
+  release();
+}
+
+void resolve(const string& name, const std::vector<string>& ips)
+{
+  ++g_pending;
+  g_resolver->resolve(name, std::bind(expect, name, ips, _1));
+}
+
+void timeout()
+{
+  LOG_FATAL << "timed out at stage " << g_stage;
+}
+
+int main()
+{
+  char resolvConf[64];
+  char hosts[64];
+  snprintf(resolvConf, sizeof resolvConf, "/tmp/muduo-resolv-%d.conf", getpid());
+  snprintf(hosts, sizeof hosts, "/tmp/muduo-hosts-%d", getpid());
+  FILE* fp = fopen(resolvConf, "w");
+  fputs("# test\nsearch example.com\nnameserver 10.255.255.1\noptions timeout:3 attempts:3\n", fp);
+  fclose(fp);
+  fp = fopen(hosts, "w");
+  fputs("127.0.0.1 localhost\n::1 localhost6\n10.9.9.9  myhost.test  alias.test # comment\n", fp);
+  fclose(fp);
+
+  EventLoop loop;
+  StubServer server(&loop);
+  Resolver resolver(&loop, resolvConf, hosts);
+  ::unlink(resolvConf);
+  ::unlink(hosts);
+  assert(resolver.nameServers().size() == 1);
+  assert(resolver.nameServers()[0].toIpPort() == "10.255.255.1:53");
+  resolver.setNameServers(std::vector<InetAddress>(1, server.address()));
+  resolver.setTimeout(0.2);
+  g_loop = &loop;
+  g_resolver = &resolver;
+  g_server = &server;
+
+  typedef std::vector<string> Ips;
+  const Ips kA = { "10.0.0.1", "10.0.0.2" };
+
+  // hosts file and numeric, answered before resolve() returns
+  g_stages.push_back([&] {
+    resolve("myhost.test", Ips{ "10.9.9.9" });
+    resolve("ALIAS.test.", Ips{ "10.9.9.9" });
+    resolve("localhost", Ips{ "127.0.0.1" });
+    resolve("192.168.1.1", Ips{ "192.168.1.1" });
+    resolve("bad..name", Ips());
+    assert(g_pending == 1 && server.numQueries() == 0);
+  });
+  // coalesced
+  g_stages.push_back([&] {
+    resolve("a.test", kA);
+    resolve("A.TEST", kA);
+    resolve("a.test.", kA);
+    assert(resolver.numCoalesced() == 2);
+  });
+  // cached
+  g_stages.push_back([&] {
+    assert(server.numQueries() == 1);
+    resolve("a.test", kA);
+    assert(resolver.numCacheHits() == 1 && g_pending == 1);
+    resolve("cname.test", Ips{ "10.0.0.3" });
+    resolve("nx.test", Ips());
+  });
+  // negative cache
+  g_stages.push_back([&] {
+    int queries = server.numQueries();
+    resolve("nx.test", Ips());
+    assert(server.numQueries() == queries && g_pending == 1);
+    resolve("slow.test", Ips{ "10.0.0.4" });
+    resolve("servfail.test", Ips());
+  });
+  // gives up after 3 attempts
+  g_stages.push_back([&] {
+    assert(server.numQueries() == 8);
+    resolve("dead.test", Ips());
+  });
+  // TTLs of a.test and nx.test are 1 second
+  g_stages.push_back([&] {
+    assert(server.numQueries() == 11);
+    ++g_pending;
+    g_loop->runAfter(1.1, [&] {
+      resolve("a.test", kA);
+      resolve("nx.test", Ips());
+      release();
+    });
+  });
+  g_stages.push_back([&] {
+    assert(server.numQueries() == 13);
+    printf("queries %" PRId64 " cache hits %" PRId64 " coalesced %" PRId64 "\n",
+           resolver.numQueries(), resolver.numCacheHits(), resolver.numCoalesced());
+  });
+
+  loop.runAfter(10, timeout);
+  loop.runAfter(0, nextStage);
+  loop.loop();
+}
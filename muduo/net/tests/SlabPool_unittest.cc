@@ -0,0 +1,298 @@
+#undef NDEBUG
+#include "muduo/net/SlabPool.h"
+
+#include "muduo/base/BlockingQueue.h"
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/Logging.h"
+#include "muduo/base/Thread.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThread.h"
+#include "muduo/net/SocketsOps.h"
+#include "muduo/net/TcpClient.h"
+#include "muduo/net/TcpServer.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+uint16_t freePort()
+{
+  int sockfd = sockets::createNonblockingOrDie(AF_INET);
+  InetAddress addr(0, true);
+  sockets::bindOrDie(sockfd, addr.getSockAddr());
+  uint16_t port = InetAddress(sockets::getLocalAddr(sockfd)).port();
+  sockets::close(sockfd);
+  return port;
+}
+
+struct Counted
+{
+  explicit Counted(int x)
+    : value(x)
+  {
+    ++live;
+  }
+
+  ~Counted()
+  {
+    --live;
+  }
+
+  int value;
+  char padding[100];
+  static int live;
+};
+
+int Counted::live = 0;
+
+void testReuse()
+{
+  printf("reuse\n");
+  SlabPool* pool = new SlabPool;
+  void* p = SlabPool::allocate(pool, 100);
+  assert(pool->numAllocated() == 1);
+  assert(pool->numReservedBytes() == 64 * 1024);
+  SlabPool::deallocate(p);
+  assert(pool->numAllocated() == 0);
+  void* q = SlabPool::allocate(pool, 100);
+  assert(p == q);
+  void* r = SlabPool::allocate(pool, 10);
+  assert(r != q);
+  assert(reinterpret_cast<uintptr_t>(q) % 16 == 0 && reinterpret_cast<uintptr_t>(r) % 16 == 0);
+
+  // larger ones from the heap, still counted
+  void* big = SlabPool::allocate(pool, 100 * 1000);
+  assert(pool->numAllocated() == 3);
+  SlabPool::deallocate(big);
+  SlabPool::deallocate(q);
+  SlabPool::deallocate(r);
+  assert(pool->numAllocated() == 0);
+  pool->release();
+
+  // without a pool
+  void* heap = SlabPool::allocate(NULL, 100);
+  SlabPool::deallocate(heap);
+}
+
+void testMake()
+{
+  printf("make\n");
+  SlabPool* pool = new SlabPool;
+  {
+    std::unique_ptr<Counted, SlabPool::Deleter> p = SlabPool::make<Counted>(pool, 42);
+    assert(p->value == 42 && Counted::live == 1);
+    assert(pool->numAllocated() == 1);
+    std::unique_ptr<Counted, SlabPool::Deleter> q = SlabPool::make<Counted>(NULL, 43);
+    assert(q->value == 43 && pool->numAllocated() == 1);
+  }
+  assert(Counted::live == 0 && pool->numAllocated() == 0);
+  pool->release();
+}
+
+void testAllocateShared()
+{
+  printf("allocate_shared\n");
+  SlabPool* pool = new SlabPool;
+  std::weak_ptr<Counted> weak;
+  {
+    std::shared_ptr<Counted> p(
+        std::allocate_shared<Counted>(SlabAllocator<Counted>(pool), 7));
+    assert(pool->numAllocated() == 1);
+    weak = p;
+  }
+  assert(Counted::live == 0);
+  assert(pool->numAllocated() == 1);
+  weak.reset();
+  assert(pool->numAllocated() == 0);
+  pool->release();
+}
+
+void testReleaseOutstanding()
+{
+  printf("release outstanding\n");
+  SlabPool* pool = new SlabPool;
+  std::shared_ptr<Counted> p(
+      std::allocate_shared<Counted>(SlabAllocator<Counted>(pool), 1));
+  void* block = SlabPool::allocate(pool, 200);
+  pool->release();
+  // the pool goes with the last one, in another thread
+  Thread thread([&p, block] {
+    SlabPool::deallocate(block);
+    p.reset();
+  });
+  thread.start();
+  thread.join();
+  assert(Counted::live == 0);
+}
+
+void testCrossThread()
+{
+  printf("cross thread\n");
+  SlabPool* pool = new SlabPool;
+  const int kBlocks = 10000;
+  std::vector<void*> blocks;
+  for (int i = 0; i < kBlocks; ++i)
+  {
+    blocks.push_back(SlabPool::allocate(pool, 64));
+  }
+  int64_t reserved = pool->numReservedBytes();
+  Thread thread([&blocks] {
+    for (void* p : blocks)
+    {
+      SlabPool::deallocate(p);
+    }
+  });
+  thread.start();
+  thread.join();
+  assert(pool->numAllocated() == 0);
+  for (int i = 0; i < kBlocks; ++i)
+  {
+    blocks[i] = SlabPool::allocate(pool, 64);
+  }
+  assert(pool->numReservedBytes() == reserved);
+  for (void* p : blocks)
+  {
+    SlabPool::deallocate(p);
+  }
+  pool->release();
+}
+
+void testReleaseSlabs()
+{
+  printf("release slabs\n");
+  SlabPool* pool = new SlabPool;
+  std::vector<void*> blocks;
+  for (int i = 0; i < 10000; ++i)
+  {
+    blocks.push_back(SlabPool::allocate(pool, 64));
+  }
+  assert(pool->numReservedBytes() > 10 * 64 * 1024);
+  for (void* p : blocks)
+  {
+    SlabPool::deallocate(p);
+  }
+  // one empty slab is kept
+  assert(pool->numReservedBytes() == 64 * 1024);
+
+  // from another thread, in slabs of their own
+  Thread thread([pool, &blocks] {
+    for (void*& p : blocks)
+    {
+      p = SlabPool::allocate(pool, 64);
+    }
+  });
+  thread.start();
+  thread.join();
+  assert(pool->numAllocated() == 10000);
+  assert(pool->numReservedBytes() > 11 * 64 * 1024);
+  for (void* p : blocks)
+  {
+    SlabPool::deallocate(p);
+  }
+  assert(pool->numReservedBytes() == 2 * 64 * 1024);
+  pool->release();
+}
+
+void testConcurrent()
+{
+  printf("concurrent\n");
+  SlabPool* pool = new SlabPool;
+  const int kBlocks = 100000;
+  BlockingQueue<void*> toFree;
+  // allocates in its own slabs, and frees blocks of the loop thread
+  Thread thread([pool, &toFree] {
+    for (int i = 0; i < kBlocks; ++i)
+    {
+      void* p = SlabPool::allocate(pool, i % 200);
+      SlabPool::deallocate(p);
+      SlabPool::deallocate(toFree.take());
+    }
+  });
+  thread.start();
+  for (int i = 0; i < kBlocks; ++i)
+  {
+    void* p = SlabPool::allocate(pool, i % 300);
+    memset(p, 0, i % 300);
+    toFree.put(p);
+    SlabPool::deallocate(SlabPool::allocate(pool, 100));
+  }
+  thread.join();
+  assert(pool->numAllocated() == 0);
+  pool->release();
+}
+
+void testDisabled()
+{
+  printf("disabled\n");
+  assert(SlabPool::enabled());
+  SlabPool::setEnabled(false);
+  {
+    EventLoopThread thread;
+    EventLoop* loop = thread.startLoop();
+    assert(loop->slabPool() == NULL);
+    // quit() after loop() has started
+    CountDownLatch latch(1);
+    loop->runInLoop([&latch] { latch.countDown(); });
+    latch.wait();
+  }
+  SlabPool::setEnabled(true);
+}
+
+void testConnection()
+{
+  printf("connection\n");
+  EventLoop loop;
+  assert(loop.slabPool() != NULL);
+  InetAddress serverAddr(freePort(), true);
+  TcpServer server(&loop, serverAddr, "Server");
+  EventLoop* ioLoop = NULL;
+  server.setThreadNum(1);
+  server.setThreadInitCallback([&ioLoop](EventLoop* l) { ioLoop = l; });
+  int64_t serverBlocks = -1;
+  server.setConnectionCallback([&serverBlocks, &ioLoop](const TcpConnectionPtr& conn) {
+    if (conn->connected())
+    {
+      // TcpConnection with control block, Socket, Channel
+      serverBlocks = ioLoop->slabPool()->numAllocated();
+      conn->shutdown();
+    }
+  });
+  server.start();
+
+  TcpClient client(&loop, serverAddr, "Client");
+  int64_t clientBlocks = -1;
+  client.setConnectionCallback([&loop, &clientBlocks](const TcpConnectionPtr& conn) {
+    if (conn->connected())
+    {
+      clientBlocks = loop.slabPool()->numAllocated();
+    }
+    else
+    {
+      loop.quit();
+    }
+  });
+  loop.runAfter(0, [&client] { client.connect(); });
+  loop.runAfter(10, [] { LOG_FATAL << "timed out"; });
+  loop.loop();
+  printf("%lld blocks for a server connection, %lld for a client one\n",
+         static_cast<long long>(serverBlocks), static_cast<long long>(clientBlocks));
+  assert(serverBlocks == 3);
+  assert(clientBlocks == 3);
+}
+
+int main()
+{
+  testReuse();
+  testMake();
+  testAllocateShared();
+  testReleaseOutstanding();
+  testCrossThread();
+  testReleaseSlabs();
+  testConcurrent();
+  testDisabled();
+  testConnection();
+  printf("done\n");
+}
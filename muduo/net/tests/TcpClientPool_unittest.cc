@@ -0,0 +1,223 @@
+#undef NDEBUG
+#include "muduo/net/TcpClientPool.h"
+
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/Logging.h"
+#include "muduo/base/Mutex.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThreadPool.h"
+#include "muduo/net/SocketsOps.h"
+#include "muduo/net/TcpServer.h"
+
+#include <map>
+#include <set>
+#include <assert.h>
+#include <stdio.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int kConnections = 4;
+
+EventLoop* g_loop;
+TcpClientPool* g_pool;
+std::vector<EventLoop*> g_ioLoops;
+
+// server side, in g_loop
+int g_accepted = 0;
+bool g_flapping = false;
+std::set<TcpConnectionPtr> g_serverConns;
+
+MutexLock g_mutex;
+string g_kill GUARDED_BY(g_mutex);  // name of the connection to fail health check
+
+uint16_t freePort()
+{
+  int sockfd = sockets::createNonblockingOrDie(AF_INET);
+  InetAddress addr(0, true);
+  sockets::bindOrDie(sockfd, addr.getSockAddr());
+  uint16_t port = InetAddress(sockets::getLocalAddr(sockfd)).port();
+  sockets::close(sockfd);
+  return port;
+}
+
+void onServerConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    ++g_accepted;
+    if (g_flapping)
+    {
+      conn->forceClose();
+    }
+    else
+    {
+      g_serverConns.insert(conn);
+    }
+  }
+  else
+  {
+    g_serverConns.erase(conn);
+  }
+}
+
+bool healthCheck(const TcpConnectionPtr& conn)
+{
+  MutexLockGuard lock(g_mutex);
+  if (conn->name() == g_kill)
+  {
+    g_kill.clear();
+    return false;
+  }
+  return true;
+}
+
+// how many leases each connection got
+std::map<string, int> count(const std::vector<TcpClientPool::Lease>& leases)
+{
+  std::map<string, int> counts;
+  for (const auto& lease : leases)
+  {
+    assert(lease.connection() != NULL);
+    ++counts[lease.connection()->name()];
+  }
+  return counts;
+}
+
+void testLeastOutstanding()
+{
+  printf("least outstanding\n");
+  std::vector<TcpClientPool::Lease> leases;
+  for (int i = 0; i < 2 * kConnections; ++i)
+  {
+    leases.push_back(g_pool->acquire());
+  }
+  std::map<string, int> counts = count(leases);
+  assert(counts.size() == kConnections);
+  for (const auto& item : counts)
+  {
+    assert(item.second == 2);
+  }
+  for (const auto& lease : leases)
+  {
+    g_pool->release(lease);
+  }
+}
+
+void testAffinity()
+{
+  printf("affinity\n");
+  for (EventLoop* ioLoop : g_ioLoops)
+  {
+    CountDownLatch latch(1);
+    ioLoop->runInLoop([ioLoop, &latch] {
+      for (int i = 0; i < kConnections; ++i)
+      {
+        TcpClientPool::Lease lease = g_pool->acquire();
+        assert(lease.connection() && lease.connection()->getLoop() == ioLoop);
+        g_pool->release(lease);
+      }
+      latch.countDown();
+    });
+    latch.wait();
+  }
+}
+
+enum Stage { kConnecting, kHealthCheck, kFlapping, kRecovering };
+Stage g_stage = kConnecting;
+TcpClientPool::Lease g_staleLease;
+int g_acceptedBefore;
+Timestamp g_flappingStart;
+
+void poll()
+{
+  int connected = g_pool->numConnected();
+  if (g_stage == kConnecting && connected == kConnections)
+  {
+    assert(g_accepted == kConnections);
+    testLeastOutstanding();
+    testAffinity();
+
+    printf("health check\n");
+    g_staleLease = g_pool->acquire();
+    MutexLockGuard lock(g_mutex);
+    g_kill = g_staleLease.connection()->name();
+    g_stage = kHealthCheck;
+  }
+  else if (g_stage == kHealthCheck && g_accepted == kConnections + 1
+           && connected == kConnections)
+  {
+    // must not count against the new connection
+    g_pool->release(g_staleLease);
+    g_staleLease = TcpClientPool::Lease();
+    std::vector<TcpClientPool::Lease> leases;
+    for (int i = 0; i < kConnections; ++i)
+    {
+      leases.push_back(g_pool->acquire());
+    }
+    assert(count(leases).size() == kConnections);
+    for (const auto& lease : leases)
+    {
+      g_pool->release(lease);
+    }
+
+    printf("flapping\n");
+    g_flapping = true;
+    g_acceptedBefore = g_accepted;
+    g_flappingStart = Timestamp::now();
+    std::set<TcpConnectionPtr> conns;
+    conns.swap(g_serverConns);
+    for (const auto& conn : conns)
+    {
+      conn->forceClose();
+    }
+    g_stage = kFlapping;
+  }
+  else if (g_stage == kFlapping && timeDifference(Timestamp::now(), g_flappingStart) > 1.0)
+  {
+    int accepted = g_accepted - g_acceptedBefore;
+    printf("%d connections in 1 second\n", accepted);
+    assert(kConnections <= accepted && accepted <= 10 * kConnections);
+    g_flapping = false;
+    g_stage = kRecovering;
+  }
+  else if (g_stage == kRecovering && connected == kConnections)
+  {
+    g_loop->quit();
+  }
+}
+
+void timeout()
+{
+  LOG_FATAL << "timed out at stage " << g_stage;
+}
+
+int main()
+{
+  EventLoop loop;
+  g_loop = &loop;
+  InetAddress serverAddr(freePort(), true);
+  TcpServer server(&loop, serverAddr, "Server");
+  server.setConnectionCallback(onServerConnection);
+  server.start();
+
+  EventLoopThreadPool threads(&loop, "pool");
+  threads.setThreadNum(2);
+  threads.start();
+  g_ioLoops = threads.getAllLoops();
+
+  {
+    TcpClientPool pool(g_ioLoops, "Pool");
+    g_pool = &pool;
+    pool.addServer(serverAddr, kConnections);
+    pool.setHealthCheck(0.05, healthCheck);
+    pool.setReconnectBackoff(0.05, 1.0);
+    pool.start();
+
+    loop.runEvery(0.02, poll);
+    loop.runAfter(10.0, timeout);
+    loop.loop();
+  }
+  g_serverConns.clear();
+  printf("done\n");
+}
@@ -0,0 +1,177 @@
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/Histogram.h"
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThread.h"
+#include "muduo/net/SocketsOps.h"
+#include "muduo/net/TcpClient.h"
+#include "muduo/net/TcpServer.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Latency of short connections over loopback: connect, send a request,
+// read the response, close. With TCP Fast Open the request goes in the
+// SYN, saving a round trip; with TCP_DEFER_ACCEPT the server wakes up
+// once per connection instead of twice.
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t kRequestSize = 100;
+const size_t kResponseSize = 1000;
+const int kWarmUp = 100;
+
+uint16_t freePort()
+{
+  int sockfd = sockets::createNonblockingOrDie(AF_INET);
+  InetAddress addr(0, true);
+  sockets::bindOrDie(sockfd, addr.getSockAddr());
+  uint16_t port = InetAddress(sockets::getLocalAddr(sockfd)).port();
+  sockets::close(sockfd);
+  return port;
+}
+
+void onRequest(const string& response, const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  if (buf->readableBytes() >= kRequestSize)
+  {
+    buf->retrieve(kRequestSize);
+    conn->send(response);
+  }
+}
+
+// One connection after another, in the loop of main thread.
+class ShortConnections : noncopyable
+{
+ public:
+  ShortConnections(EventLoop* loop, const InetAddress& serverAddr, bool fastOpen, int n)
+    : loop_(loop),
+      serverAddr_(serverAddr),
+      fastOpen_(fastOpen),
+      total_(n + kWarmUp),
+      count_(0),
+      synData_(0),
+      request_(kRequestSize, 'q')
+  {
+  }
+
+  void next()
+  {
+    if (count_ == total_)
+    {
+      loop_->quit();
+      return;
+    }
+    // the previous one has been removed
+    client_.reset(new TcpClient(loop_, serverAddr_, "ShortConnection"));
+    client_->setTcpFastOpen(fastOpen_);
+    client_->setConnectionCallback(
+        std::bind(&ShortConnections::onConnection, this, _1));
+    client_->setMessageCallback(
+        std::bind(&ShortConnections::onMessage, this, _1, _2, _3));
+    start_ = Timestamp::now();
+    client_->connect();
+  }
+
+  const Histogram& latency() const { return latency_; }
+  int synData() const { return synData_; }
+
+ private:
+  void onConnection(const TcpConnectionPtr& conn)
+  {
+    if (conn->connected())
+    {
+      conn->setTcpNoDelay(true);
+      conn->send(request_);
+    }
+    else
+    {
+      loop_->queueInLoop(std::bind(&ShortConnections::next, this));
+    }
+  }
+
+  void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime)
+  {
+    if (buf->readableBytes() < kResponseSize)
+      return;
+    buf->retrieveAll();
+    if (++count_ > kWarmUp)
+    {
+      latency_.record(receiveTime.microSecondsSinceEpoch() - start_.microSecondsSinceEpoch());
+      struct tcp_info tcpi;
+      if (conn->getTcpInfo(&tcpi) && (tcpi.tcpi_options & TCPI_OPT_SYN_DATA))
+      {
+        ++synData_;
+      }
+    }
+    conn->shutdown();
+  }
+
+  EventLoop* loop_;
+  const InetAddress serverAddr_;
+  const bool fastOpen_;
+  const int total_;
+  int count_;
+  int synData_;
+  const string request_;
+  std::unique_ptr<TcpClient> client_;
+  Timestamp start_;
+  Histogram latency_;
+};
+
+void run(EventLoop* serverLoop, const char* name, bool fastOpen, bool deferAccept, int n)
+{
+  InetAddress serverAddr(freePort(), true);
+  std::unique_ptr<TcpServer> server;
+  serverLoop->runInLoop([&] {
+    server.reset(new TcpServer(serverLoop, serverAddr, "Server"));
+    server->setMessageCallback(
+        std::bind(onRequest, string(kResponseSize, 'r'), _1, _2, _3));
+    server->setTcpFastOpen(fastOpen ? 256 : 0);
+    server->setDeferAccept(deferAccept ? 1 : 0);
+    server->start();
+  });
+
+  {
+    EventLoop loop;
+    ShortConnections client(&loop, serverAddr, fastOpen, n);
+    loop.runAfter(0, std::bind(&ShortConnections::next, &client));
+    loop.loop();
+
+    Histogram::Snapshot latency = client.latency().snapshot();
+    printf("%-24s us %s syn data %d\n", name, latency.toString().c_str(), client.synData());
+  }
+
+  CountDownLatch latch(1);
+  serverLoop->runInLoop([&] {
+    server.reset();
+    latch.countDown();
+  });
+  latch.wait();
+}
+
+int main(int argc, char* argv[])
+{
+  int n = argc > 1 ? atoi(argv[1]) : 5000;
+  Logger::setLogLevel(Logger::WARN);
+  FILE* fp = fopen("/proc/sys/net/ipv4/tcp_fastopen", "r");
+  int sysctl = 0;
+  if (fp)
+  {
+    if (fscanf(fp, "%d", &sysctl) != 1)
+      sysctl = 0;
+    fclose(fp);
+  }
+  printf("net.ipv4.tcp_fastopen = %d%s\n", sysctl,
+         (sysctl & 3) == 3 ? "" : ", needs 3 for both ends of fast open");
+
+  EventLoopThread serverThread;
+  EventLoop* serverLoop = serverThread.startLoop();
+  run(serverLoop, "plain", false, false, n);
+  run(serverLoop, "defer accept", false, true, n);
+  run(serverLoop, "fast open", true, false, n);
+  run(serverLoop, "fast open, defer accept", true, true, n);
+}
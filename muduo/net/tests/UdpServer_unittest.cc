@@ -0,0 +1,129 @@
+#undef NDEBUG
+#include "muduo/net/UdpServer.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int kRounds = 20;
+const int kDatagramsPerRound = 50;
+const int kDatagramSize = 100;
+
+class EchoClient : noncopyable
+{
+ public:
+  EchoClient(EventLoop* loop, const InetAddress& serverAddr, bool offload)
+    : loop_(loop),
+      serverAddr_(serverAddr),
+      socket_(new UdpSocket(loop, InetAddress(0, true))),
+      round_(0),
+      received_(0),
+      bytes_(0)
+  {
+    socket_->setDatagramCallback(
+        std::bind(&EchoClient::onDatagram, this, _1, _2, _3, std::placeholders::_4));
+    if (offload)
+    {
+      printf("receive offload %d, send offload %d\n",
+             socket_->setReceiveOffload(true), socket_->setSendOffload(true));
+    }
+  }
+
+  ~EchoClient()
+  {
+    socket_->stop();
+  }
+
+  void start()
+  {
+    socket_->start();
+    sendRound();
+  }
+
+  int round() const { return round_; }
+
+ private:
+  void sendRound()
+  {
+    char buf[kDatagramSize];
+    for (int i = 0; i < kDatagramsPerRound; ++i)
+    {
+      memset(buf, 'a' + (round_ + i) % 26, sizeof buf);
+      socket_->send(serverAddr_, buf, sizeof buf);
+    }
+  }
+
+  void onDatagram(const UdpSocketPtr&, const InetAddress& peer,
+                  StringPiece datagram, Timestamp)
+  {
+    assert(peer.toIpPort() == serverAddr_.toIpPort());
+    (void) peer;
+    if (datagram.size() != kDatagramSize)
+    {
+      LOG_FATAL << "Expect " << kDatagramSize << " bytes, received " << datagram.size();
+    }
+    bytes_ += datagram.size();
+    if (++received_ == kDatagramsPerRound)
+    {
+      received_ = 0;
+      if (++round_ == kRounds)
+      {
+        printf("received %d bytes in %d datagrams\n", bytes_,
+               static_cast<int>(socket_->numReceived()));
+        loop_->quit();
+      }
+      else
+      {
+        sendRound();
+      }
+    }
+  }
+
+  EventLoop* loop_;
+  const InetAddress serverAddr_;
+  UdpSocketPtr socket_;
+  int round_;
+  int received_;
+  int bytes_;
+};
+
+void onServerDatagram(const UdpSocketPtr& socket, const InetAddress& peer,
+                      StringPiece datagram, Timestamp)
+{
+  socket->send(peer, datagram);
+}
+
+void timeout(const char* test)
+{
+  LOG_FATAL << test << " timed out";
+}
+
+void runEcho(const char* test, bool offload)
+{
+  printf("%s\n", test);
+  EventLoop loop;
+  UdpServer server(&loop, InetAddress(0, true), "UdpServer_unittest");
+  server.setThreadNum(2);
+  server.setDatagramCallback(onServerDatagram);
+  server.setReceiveOffload(offload);
+  server.setSendOffload(offload);
+  server.start();
+
+  EchoClient client(&loop, server.localAddress(), offload);
+  client.start();
+  loop.runAfter(10.0, std::bind(timeout, test));
+  loop.loop();
+  assert(client.round() == kRounds);
+}
+
+int main()
+{
+  runEcho("plain", false);
+  runEcho("offload", true);
+}
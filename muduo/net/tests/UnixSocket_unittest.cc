@@ -0,0 +1,335 @@
+#undef NDEBUG
+#include "muduo/net/TcpClient.h"
+#include "muduo/net/TcpServer.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+void timeout(const char* test)
+{
+  LOG_FATAL << test << " timed out";
+}
+
+void testAddress()
+{
+  UnixAddress path("/tmp/muduo.sock");
+  assert(path.path() == "/tmp/muduo.sock");
+  assert(!path.isAbstract());
+  assert(path.family() == AF_UNIX);
+
+  UnixAddress abstract("@muduo");
+  assert(abstract.path() == "@muduo");
+  assert(abstract.isAbstract());
+  (void) path;
+  (void) abstract;
+}
+
+/////////////////////////////// stream ///////////////////////////////
+
+const int kMessages = 100;
+
+void echo(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  conn->send(buf);
+}
+
+class StreamClient : noncopyable
+{
+ public:
+  StreamClient(EventLoop* loop, const UnixAddress& addr)
+    : loop_(loop),
+      client_(loop, addr, "StreamClient"),
+      received_(0)
+  {
+    client_.enableRetry();
+    client_.setConnectionCallback(
+        std::bind(&StreamClient::onConnection, this, _1));
+    client_.setMessageCallback(
+        std::bind(&StreamClient::onMessage, this, _1, _2, _3));
+  }
+
+  void connect() { client_.connect(); }
+
+ private:
+  void onConnection(const TcpConnectionPtr& conn)
+  {
+    if (conn->connected())
+    {
+      printf("%s\n", conn->name().c_str());
+      for (int i = 0; i < kMessages; ++i)
+      {
+        conn->send("0123456789");
+      }
+    }
+    else
+    {
+      loop_->quit();
+    }
+  }
+
+  void onMessage(const TcpConnectionPtr&, Buffer* buf, Timestamp)
+  {
+    received_ += static_cast<int>(buf->readableBytes());
+    buf->retrieveAll();
+    if (received_ == 10 * kMessages)
+    {
+      client_.disconnect();
+    }
+  }
+
+  EventLoop* loop_;
+  TcpClient client_;
+  int received_;
+};
+
+void testStream(const char* path, int numThreads)
+{
+  printf("stream %s threads %d\n", path, numThreads);
+  EventLoop loop;
+  UnixAddress addr(path);
+  // connects before listening, to exercise retrying
+  StreamClient client(&loop, addr);
+  client.connect();
+
+  TcpServer server(&loop, addr, "StreamServer");
+  server.setThreadNum(numThreads);
+  server.setMessageCallback(echo);
+  loop.runAfter(0.1, std::bind(&TcpServer::start, &server));
+  loop.runAfter(10.0, std::bind(timeout, path));
+  loop.loop();
+}
+
+/////////////////////////////// seqpacket ///////////////////////////////
+
+const int kRecordSizes[] = { 1, 1000, 3, 60000, 5 };
+const int kNumRecords = sizeof kRecordSizes / sizeof kRecordSizes[0];
+
+void seqpacketServerMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  // one record per read
+  LOG_DEBUG << "server record " << buf->readableBytes();
+  conn->send(buf);
+}
+
+int g_numRecords = 0;
+
+void seqpacketClientConnection(EventLoop* loop, const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    for (int i = 0; i < kNumRecords; ++i)
+    {
+      conn->send(string(kRecordSizes[i], 'x'));
+    }
+  }
+  else
+  {
+    loop->quit();
+  }
+}
+
+void seqpacketClientMessage(TcpClient* client, const TcpConnectionPtr&,
+                            Buffer* buf, Timestamp)
+{
+  int size = static_cast<int>(buf->readableBytes());
+  buf->retrieveAll();
+  if (size != kRecordSizes[g_numRecords])
+  {
+    LOG_FATAL << "record " << g_numRecords << " expect " << kRecordSizes[g_numRecords]
+              << " bytes, received " << size;
+  }
+  if (++g_numRecords == kNumRecords)
+  {
+    client->disconnect();
+  }
+}
+
+void testSeqpacket()
+{
+  printf("seqpacket\n");
+  EventLoop loop;
+  UnixAddress addr("@muduo-seqpacket-test");
+  TcpServer server(&loop, addr, "SeqpacketServer", SOCK_SEQPACKET);
+  server.setMessageCallback(seqpacketServerMessage);
+  server.start();
+
+  TcpClient client(&loop, addr, "SeqpacketClient", SOCK_SEQPACKET);
+  client.setConnectionCallback(std::bind(seqpacketClientConnection, &loop, _1));
+  client.setMessageCallback(std::bind(seqpacketClientMessage, &client, _1, _2, _3));
+  client.connect();
+  loop.runAfter(10.0, std::bind(timeout, "seqpacket"));
+  loop.loop();
+  assert(g_numRecords == kNumRecords);
+}
+
+// longer than the input buffer plus the 64KiB extra buffer of a read
+const int kOversizedRecord = 150 * 1000;
+int g_numOversizedMessages = 0;
+
+void oversizedServerMessage(const TcpConnectionPtr&, Buffer* buf, Timestamp)
+{
+  buf->retrieveAll();
+  ++g_numOversizedMessages;
+}
+
+void oversizedClientConnection(EventLoop* loop, const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    conn->send(string(kOversizedRecord, 'x'));
+  }
+  else
+  {
+    // closed by the server
+    loop->quit();
+  }
+}
+
+void testOversizedRecord()
+{
+  printf("seqpacket oversized record\n");
+  EventLoop loop;
+  UnixAddress addr("@muduo-seqpacket-oversized-test");
+  TcpServer server(&loop, addr, "OversizedServer", SOCK_SEQPACKET);
+  server.setMessageCallback(oversizedServerMessage);
+  server.start();
+
+  TcpClient client(&loop, addr, "OversizedClient", SOCK_SEQPACKET);
+  client.setConnectionCallback(std::bind(oversizedClientConnection, &loop, _1));
+  client.connect();
+  loop.runAfter(10.0, std::bind(timeout, "seqpacket oversized record"));
+  loop.loop();
+  // not delivered truncated
+  assert(g_numOversizedMessages == 0);
+}
+
+/////////////////////////////// SCM_RIGHTS ///////////////////////////////
+
+void passingServerConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    conn->setReceiveFds(true);
+  }
+}
+
+void passingServerMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  std::vector<int> fds = conn->takeReceivedFds();
+  buf->retrieveAll();
+  for (int fd : fds)
+  {
+    ssize_t n = ::write(fd, "hello", 5);
+    assert(n == 5);
+    (void) n;
+    ::close(fd);
+  }
+}
+
+int g_pipe[2];
+
+void passingClientConnection(EventLoop* loop, const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    bool ok = conn->sendWithFds("F", &g_pipe[1], 1);
+    assert(ok);
+    (void) ok;
+    ::close(g_pipe[1]);
+  }
+  else
+  {
+    loop->quit();
+  }
+}
+
+void passingClientRead(TcpClient* client)
+{
+  static bool done = false;
+  if (done)
+  {
+    return;
+  }
+  char buf[16] = "";
+  ssize_t n = ::read(g_pipe[0], buf, sizeof buf);
+  if (n < 0 && errno == EAGAIN)
+  {
+    return;
+  }
+  if (n != 5 || memcmp(buf, "hello", 5) != 0)
+  {
+    LOG_FATAL << "read from passed fd " << n;
+  }
+  printf("received '%s' through the passed fd\n", buf);
+  done = true;
+  client->disconnect();
+}
+
+void testFdPassing()
+{
+  printf("fd passing\n");
+  EventLoop loop;
+  UnixAddress addr("@muduo-fd-passing-test");
+  TcpServer server(&loop, addr, "PassingServer");
+  server.setConnectionCallback(passingServerConnection);
+  server.setMessageCallback(passingServerMessage);
+  server.start();
+
+  if (::pipe2(g_pipe, O_NONBLOCK | O_CLOEXEC) < 0)
+  {
+    LOG_SYSFATAL << "pipe2";
+  }
+  TcpClient client(&loop, addr, "PassingClient");
+  client.setConnectionCallback(std::bind(passingClientConnection, &loop, _1));
+  client.connect();
+  loop.runEvery(0.01, std::bind(passingClientRead, &client));
+  loop.runAfter(10.0, std::bind(timeout, "fd passing"));
+  loop.loop();
+  ::close(g_pipe[0]);
+}
+
+/////////////////////////////// stale socket ///////////////////////////////
+
+void testStaleSocket(const char* path)
+{
+  printf("stale socket %s\n", path);
+  UnixAddress addr(path);
+  int sockfd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  int ret = ::bind(sockfd, addr.getSockAddr(), addr.length());
+  assert(ret == 0);
+  (void) ret;
+  ::close(sockfd);  // leaves the socket file
+  assert(::access(path, F_OK) == 0);
+
+  {
+    EventLoop loop;
+    TcpServer server(&loop, addr, "StaleServer");
+    server.start();
+  }
+  assert(::access(path, F_OK) != 0);
+}
+
+int main()
+{
+  char path[64];
+  snprintf(path, sizeof path, "/tmp/muduo-unix-test-%d.sock", getpid());
+
+  testAddress();
+  testStream(path, 0);
+  testStream(path, 2);
+  testStream("@muduo-stream-test", 1);
+  testSeqpacket();
+  testOversizedRecord();
+  testFdPassing();
+  testStaleSocket(path);
+}